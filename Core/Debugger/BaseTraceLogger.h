@@ -130,6 +130,12 @@ struct TraceLogPpuState
 	uint32_t FrameCount;
 };
 
+struct TraceLogMemoryAccess
+{
+	EffectiveAddressInfo EffectiveAddress;
+	uint16_t Value;
+};
+
 struct RowPart
 {
 	RowDataType DataType;
@@ -170,6 +176,10 @@ protected:
 	unique_ptr<ExpressionEvaluator> _expEvaluator;
 	ExpressionData _conditionData;
 
+	//Effective address & memory value captured when the row was logged (used when formatting binary log records)
+	bool _needMemoryAccess = false;
+	TraceLogMemoryAccess* _loggedMemoryAccess = nullptr;
+
 	void WriteByteCode(DisassemblyInfo& info, RowPart& rowPart, string& output)
 	{
 		string byteCode;
@@ -201,7 +211,7 @@ protected:
 	
 	void WriteEffectiveAddress(DisassemblyInfo& info, RowPart& rowPart, void* cpuState, string& output, MemoryType cpuMemoryType, CpuType cpuType)
 	{
-		EffectiveAddressInfo effectiveAddress = info.GetEffectiveAddress(_debugger, cpuState, cpuType);
+		EffectiveAddressInfo effectiveAddress = _loggedMemoryAccess ? _loggedMemoryAccess->EffectiveAddress : info.GetEffectiveAddress(_debugger, cpuState, cpuType);
 		if(effectiveAddress.ShowAddress && effectiveAddress.Address >= 0) {
 			MemoryType effectiveMemType = effectiveAddress.Type == MemoryType::None ? cpuMemoryType : effectiveAddress.Type;
 			if(_options.UseLabels) {
@@ -224,10 +234,10 @@ protected:
 
 	void WriteMemoryValue(DisassemblyInfo& info, RowPart& rowPart, void* cpuState, string& output, MemoryType memType, CpuType cpuType)
 	{
-		EffectiveAddressInfo effectiveAddress = info.GetEffectiveAddress(_debugger, cpuState, cpuType);
+		EffectiveAddressInfo effectiveAddress = _loggedMemoryAccess ? _loggedMemoryAccess->EffectiveAddress : info.GetEffectiveAddress(_debugger, cpuState, cpuType);
 		if(effectiveAddress.Address >= 0 && effectiveAddress.ValueSize > 0) {
 			MemoryType effectiveMemType = effectiveAddress.Type == MemoryType::None ? memType : effectiveAddress.Type;
-			uint16_t value = info.GetMemoryValue(effectiveAddress, _memoryDumper, effectiveMemType);
+			uint16_t value = _loggedMemoryAccess ? _loggedMemoryAccess->Value : info.GetMemoryValue(effectiveAddress, _memoryDumper, effectiveMemType);
 			if(rowPart.DisplayInHex) {
 				output += "= $";
 				if(effectiveAddress.ValueSize == 2) {
@@ -299,27 +309,55 @@ protected:
 
 		_pendingLog = false;
 
-		if(_debugger->GetTraceLogFileSaver()->IsEnabled()) {
-			string row;
-			row.reserve(300);
-			
-			//Display PC
-			RowPart rowPart = {};
-			rowPart.DisplayInHex = true;
-			rowPart.MinWidth = DebugUtilities::GetProgramCounterSize(_cpuType);
-			WriteIntValue(row, ((TraceLoggerType*)this)->GetProgramCounter(cpuState), rowPart);
-			row += "  ";
-
-			((TraceLoggerType*)this)->GetTraceRow(row, cpuState, _ppuState[_currentPos], disassemblyInfo);
-			_debugger->GetTraceLogFileSaver()->Log(row);
+		TraceLogFileSaver* fileSaver = _debugger->GetTraceLogFileSaver();
+		if(fileSaver->IsEnabled()) {
+			if(fileSaver->IsBinaryFormat()) {
+				//Store the raw data, the row is formatted later on (see FormatBinaryRecord)
+				TraceLogMemoryAccess memoryAccess = {};
+				if(_needMemoryAccess) {
+					memoryAccess.EffectiveAddress = disassemblyInfo.GetEffectiveAddress(_debugger, &cpuState, _cpuType);
+					if(memoryAccess.EffectiveAddress.Address >= 0 && memoryAccess.EffectiveAddress.ValueSize > 0) {
+						MemoryType memType = memoryAccess.EffectiveAddress.Type == MemoryType::None ? _cpuMemoryType : memoryAccess.EffectiveAddress.Type;
+						memoryAccess.Value = disassemblyInfo.GetMemoryValue(memoryAccess.EffectiveAddress, _memoryDumper, memType);
+					}
+				}
+
+				constexpr uint32_t dataSize = sizeof(DisassemblyInfo) + sizeof(TraceLogPpuState) + sizeof(TraceLogMemoryAccess) + sizeof(CpuStateType);
+				uint8_t* dst = fileSaver->LogBinary(_cpuType, (uint16_t)sizeof(CpuStateType), dataSize);
+				memcpy(dst, &disassemblyInfo, sizeof(DisassemblyInfo));
+				dst += sizeof(DisassemblyInfo);
+				memcpy(dst, &_ppuState[_currentPos], sizeof(TraceLogPpuState));
+				dst += sizeof(TraceLogPpuState);
+				memcpy(dst, &memoryAccess, sizeof(TraceLogMemoryAccess));
+				dst += sizeof(TraceLogMemoryAccess);
+				memcpy(dst, &cpuState, sizeof(CpuStateType));
+			} else {
+				string row;
+				row.reserve(300);
+				GetFileRow(row, cpuState, _ppuState[_currentPos], disassemblyInfo);
+				fileSaver->Log(row);
+			}
 		}
 
 		_currentPos = (_currentPos + 1) % ExecutionLogSize;
 	}
 
+	void GetFileRow(string& row, CpuStateType& cpuState, TraceLogPpuState& ppuState, DisassemblyInfo& disassemblyInfo)
+	{
+		//Display PC
+		RowPart rowPart = {};
+		rowPart.DisplayInHex = true;
+		rowPart.MinWidth = DebugUtilities::GetProgramCounterSize(_cpuType);
+		WriteIntValue(row, ((TraceLoggerType*)this)->GetProgramCounter(cpuState), rowPart);
+		row += "  ";
+
+		((TraceLoggerType*)this)->GetTraceRow(row, cpuState, ppuState, disassemblyInfo);
+	}
+
 	void ParseFormatString(string format)
 	{
 		_rowParts.clear();
+		_needMemoryAccess = false;
 
 		std::regex formatRegex = std::regex("(\\[\\s*([^[]*?)\\s*(,\\s*([\\d]*)\\s*(h){0,1}){0,1}\\s*\\])|([^[]*)", std::regex_constants::icase);
 		std::sregex_iterator start = std::sregex_iterator(format.cbegin(), format.cend(), formatRegex);
@@ -350,6 +388,10 @@ protected:
 				}
 				part.DisplayInHex = match.str(5) == "h";
 
+				if(part.DataType == RowDataType::EffectiveAddress || part.DataType == RowDataType::MemoryValue) {
+					_needMemoryAccess = true;
+				}
+
 				_rowParts.push_back(part);
 			}
 		}
@@ -541,4 +583,28 @@ public:
 		memcpy(row.LogOutput, logOutput.c_str(), row.LogSize);
 		row.LogOutput[row.LogSize] = 0;
 	}
+
+	bool FormatBinaryRecord(uint8_t* data, uint32_t stateSize, string& output) override
+	{
+		if(stateSize != sizeof(CpuStateType)) {
+			return false;
+		}
+
+		DisassemblyInfo disassemblyInfo;
+		TraceLogPpuState ppuState;
+		TraceLogMemoryAccess memoryAccess;
+		CpuStateType cpuState;
+		memcpy(&disassemblyInfo, data, sizeof(DisassemblyInfo));
+		data += sizeof(DisassemblyInfo);
+		memcpy(&ppuState, data, sizeof(TraceLogPpuState));
+		data += sizeof(TraceLogPpuState);
+		memcpy(&memoryAccess, data, sizeof(TraceLogMemoryAccess));
+		data += sizeof(TraceLogMemoryAccess);
+		memcpy(&cpuState, data, sizeof(CpuStateType));
+
+		_loggedMemoryAccess = &memoryAccess;
+		GetFileRow(output, cpuState, ppuState, disassemblyInfo);
+		_loggedMemoryAccess = nullptr;
+		return true;
+	}
 };
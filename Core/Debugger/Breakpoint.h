@@ -19,6 +19,9 @@ public:
 
 	uint32_t GetId();
 	CpuType GetCpuType();
+	MemoryType GetMemoryType();
+	int32_t GetStartAddress();
+	int32_t GetEndAddress();
 	bool IsEnabled();
 	bool IsMarked();
 	bool IsAllowedForOpType(MemoryOperationType opType);
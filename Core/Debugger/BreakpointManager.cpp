@@ -24,6 +24,7 @@ void BreakpointManager::SetBreakpoints(Breakpoint breakpoints[], uint32_t count)
 	for(int i = 0; i < BreakpointManager::BreakpointTypeCount; i++) {
 		_breakpoints[i].clear();
 		_rpnList[i].clear();
+		_addressIndex[i].clear();
 		_hasBreakpointType[i] = false;
 	}
 
@@ -56,10 +57,12 @@ void BreakpointManager::SetBreakpoints(Breakpoint breakpoints[], uint32_t count)
 					continue;
 				}
 
-				if(bp.IsAllowedForOpType(opType)) {
-					_breakpoints[i].push_back(bp);
+				if(!bp.IsAllowedForOpType(opType)) {
+					continue;
 				}
 
+				_breakpoints[i].push_back(bp);
+
 				if(bp.HasCondition()) {
 					bool success = true;
 					ExpressionData data = _bpExpEval->GetRpnList(bp.GetCondition(), success);
@@ -73,6 +76,88 @@ void BreakpointManager::SetBreakpoints(Breakpoint breakpoints[], uint32_t count)
 			}
 		}
 	}
+
+	for(int i = 0; i < BreakpointManager::BreakpointTypeCount; i++) {
+		BuildAddressIndex(i);
+	}
+}
+
+void BreakpointManager::BuildAddressIndex(int opType)
+{
+	vector<Breakpoint>& breakpoints = _breakpoints[opType];
+	if(breakpoints.empty()) {
+		return;
+	}
+
+	vector<BreakpointAddressIndex>& indexes = _addressIndex[opType];
+	indexes.resize(BreakpointManager::MemoryTypeCount);
+
+	for(int memType = 0; memType < BreakpointManager::MemoryTypeCount; memType++) {
+		vector<uint32_t> bpIndexes;
+		vector<int64_t> boundaries;
+		for(uint32_t i = 0; i < (uint32_t)breakpoints.size(); i++) {
+			Breakpoint& bp = breakpoints[i];
+			if((int)bp.GetMemoryType() == memType && bp.GetEndAddress() >= 0 && bp.GetStartAddress() <= bp.GetEndAddress()) {
+				bpIndexes.push_back(i);
+				boundaries.push_back(std::max(0, bp.GetStartAddress()));
+				boundaries.push_back((int64_t)bp.GetEndAddress() + 1);
+			}
+		}
+
+		if(bpIndexes.empty()) {
+			continue;
+		}
+
+		BreakpointAddressIndex& index = indexes[memType];
+
+		//Mark all the pages covered by at least 1 breakpoint
+		for(uint32_t i : bpIndexes) {
+			uint32_t startPage = (uint32_t)std::max(0, breakpoints[i].GetStartAddress()) >> BreakpointManager::PageShift;
+			uint32_t endPage = (uint32_t)breakpoints[i].GetEndAddress() >> BreakpointManager::PageShift;
+			if(index.Pages.size() <= endPage / 64) {
+				index.Pages.resize(endPage / 64 + 1);
+			}
+			for(uint32_t page = startPage; page <= endPage; page++) {
+				index.Pages[page / 64] |= (uint64_t)1 << (page & 0x3F);
+			}
+		}
+
+		//Split the address space at every breakpoint's start/end address, and keep track of which breakpoints cover each segment
+		std::sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+		for(size_t i = 0; i + 1 < boundaries.size(); i++) {
+			BreakpointSegment segment = {};
+			segment.Start = (int32_t)boundaries[i];
+			segment.End = (int32_t)(boundaries[i + 1] - 1);
+			for(uint32_t bpIndex : bpIndexes) {
+				if(breakpoints[bpIndex].GetStartAddress() <= segment.Start && breakpoints[bpIndex].GetEndAddress() >= segment.End) {
+					segment.Breakpoints.push_back(bpIndex);
+				}
+			}
+
+			if(!segment.Breakpoints.empty()) {
+				index.Segments.push_back(std::move(segment));
+			}
+		}
+	}
+}
+
+__forceinline bool BreakpointManager::IsPageMarked(BreakpointAddressIndex& index, int64_t address)
+{
+	uint64_t page = (uint64_t)address >> BreakpointManager::PageShift;
+	return page / 64 < index.Pages.size() && (index.Pages[page / 64] & ((uint64_t)1 << (page & 0x3F)));
+}
+
+void BreakpointManager::AddCandidates(BreakpointAddressIndex& index, int32_t startAddr, int32_t endAddr)
+{
+	//Find the first segment that ends at or after the start address
+	auto it = std::lower_bound(index.Segments.begin(), index.Segments.end(), startAddr, [](const BreakpointSegment& segment, int32_t addr) {
+		return segment.End < addr;
+	});
+
+	for(; it != index.Segments.end() && it->Start <= endAddr; it++) {
+		_candidates.insert(_candidates.end(), it->Breakpoints.begin(), it->Breakpoints.end());
+	}
 }
 
 bool BreakpointManager::IsForbidden(MemoryOperationInfo* memoryOpPtr, AddressInfo& relAddr, AddressInfo& absAddr)
@@ -122,9 +207,38 @@ BreakpointType BreakpointManager::GetBreakpointType(MemoryOperationType type)
 template<uint8_t accessWidth>
 int BreakpointManager::InternalCheckBreakpoint(MemoryOperationInfo operationInfo, AddressInfo &address, bool processMarkedBreakpoints)
 {
+	vector<BreakpointAddressIndex>& indexes = _addressIndex[(int)operationInfo.Type];
+	_candidates.clear();
+
+	if(DebugUtilities::IsRelativeMemory(operationInfo.MemType)) {
+		BreakpointAddressIndex& index = indexes[(int)operationInfo.MemType];
+		int64_t addr = operationInfo.Address;
+		if(IsPageMarked(index, addr) || (accessWidth > 1 && IsPageMarked(index, addr + accessWidth - 1))) {
+			AddCandidates(index, (int32_t)addr, (int32_t)(addr + accessWidth - 1));
+		}
+	}
+
+	if(address.Address >= 0 && address.Type != MemoryType::None) {
+		BreakpointAddressIndex& index = indexes[(int)address.Type];
+		int64_t addr = address.Address;
+		if(IsPageMarked(index, addr) || (accessWidth > 1 && IsPageMarked(index, addr + accessWidth - 1))) {
+			AddCandidates(index, (int32_t)addr, (int32_t)(addr + accessWidth - 1));
+		}
+	}
+
+	if(_candidates.empty()) {
+		return -1;
+	}
+
+	if(_candidates.size() > 1) {
+		//Process the breakpoints in the same order as they were defined (a breakpoint can also appear in multiple segments)
+		std::sort(_candidates.begin(), _candidates.end());
+		_candidates.erase(std::unique(_candidates.begin(), _candidates.end()), _candidates.end());
+	}
+
 	EvalResultType resultType;
 	vector<Breakpoint> &breakpoints = _breakpoints[(int)operationInfo.Type];
-	for(size_t i = 0, len = breakpoints.size(); i < len; i++) {
+	for(uint32_t i : _candidates) {
 		if(breakpoints[i].Matches<accessWidth>(operationInfo, address)) {
 			if(breakpoints[i].HasCondition() && !_bpExpEval->Evaluate(_rpnList[(int)operationInfo.Type][i], resultType, operationInfo, address)) {
 				continue;
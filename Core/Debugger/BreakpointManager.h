@@ -11,10 +11,30 @@ class BaseEventManager;
 struct ExpressionData;
 enum class MemoryOperationType;
 
+struct BreakpointSegment
+{
+	int32_t Start;
+	int32_t End;
+
+	//Indexes (in _breakpoints) of the breakpoints that cover this address range
+	vector<uint32_t> Breakpoints;
+};
+
+struct BreakpointAddressIndex
+{
+	//1 bit per page, set when at least 1 breakpoint covers part of the page
+	vector<uint64_t> Pages;
+
+	//Non-overlapping address ranges, sorted by address
+	vector<BreakpointSegment> Segments;
+};
+
 class BreakpointManager
 {
 private:
 	static constexpr int BreakpointTypeCount = (int)MemoryOperationType::PpuRenderingRead + 1;
+	static constexpr int MemoryTypeCount = (int)MemoryType::None + 1;
+	static constexpr int PageShift = 8;
 
 	Debugger* _debugger;
 	IDebugger *_cpuDebugger;
@@ -26,12 +46,19 @@ private:
 	bool _hasBreakpoint;
 	bool _hasBreakpointType[BreakpointTypeCount] = {};
 
+	//Used to find the breakpoints that can match a given address without checking every breakpoint
+	vector<BreakpointAddressIndex> _addressIndex[BreakpointTypeCount];
+	vector<uint32_t> _candidates;
+
 	vector<Breakpoint> _forbidBreakpoints;
 	vector<ExpressionData> _forbidRpn;
 
 	unique_ptr<ExpressionEvaluator> _bpExpEval;
 
 	BreakpointType GetBreakpointType(MemoryOperationType type);
+	void BuildAddressIndex(int opType);
+	__forceinline bool IsPageMarked(BreakpointAddressIndex& index, int64_t address);
+	void AddCandidates(BreakpointAddressIndex& index, int32_t startAddr, int32_t endAddr);
 	template<uint8_t accessWidth> int InternalCheckBreakpoint(MemoryOperationInfo operationInfo, AddressInfo &address, bool processMarkedBreakpoints);
 
 public:
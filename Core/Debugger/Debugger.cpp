@@ -80,7 +80,7 @@ Debugger::Debugger(Emulator* emu, IConsole* console)
 	_disassemblySearch.reset(new DisassemblySearch(_disassembler.get(), _labelManager.get()));
 	_memoryAccessCounter.reset(new MemoryAccessCounter(this));
 	_scriptManager.reset(new ScriptManager(this));
-	_traceLogSaver.reset(new TraceLogFileSaver());
+	_traceLogSaver.reset(new TraceLogFileSaver(this));
 	_cdlManager.reset(new CdlManager(this, _disassembler.get()));
 
 	//Use cpuTypes for iteration (ordered), not _cpuTypes (order is important for coprocessors, etc.)
@@ -369,9 +369,138 @@ bool ExpressionEvaluator::ToRpn(string expression, ExpressionData &data)
 	return true;
 }
 
+__forceinline bool ExpressionEvaluator::ProcessOperator(int64_t op, int64_t left, int64_t right, int64_t &result, EvalResultType &resultType)
+{
+	switch(op) {
+		case EvalOperators::Multiplication: result = left * right; break;
+		case EvalOperators::Division:
+			if(right == 0) {
+				resultType = EvalResultType::DivideBy0;
+				return false;
+			}
+			result = left / right; break;
+		case EvalOperators::Modulo:
+			if(right == 0) {
+				resultType = EvalResultType::DivideBy0;
+				return false;
+			}
+			result = left % right;
+			break;
+		case EvalOperators::Addition: result = left + right; break;
+		case EvalOperators::Substration: result = left - right; break;
+		case EvalOperators::ShiftLeft: result = left << right; break;
+		case EvalOperators::ShiftRight: result = left >> right; break;
+		case EvalOperators::SmallerThan: result = left < right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::SmallerOrEqual: result = left <= right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::GreaterThan: result = left > right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::GreaterOrEqual: result = left >= right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::Equal: result = left == right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::NotEqual: result = left != right; resultType = EvalResultType::Boolean; break;
+		case EvalOperators::BinaryAnd: result = left & right; break;
+		case EvalOperators::BinaryXor: result = left ^ right; break;
+		case EvalOperators::BinaryOr: result = left | right; break;
+		case EvalOperators::LogicalAnd: result = (bool)(left && right); resultType = EvalResultType::Boolean; break;
+		case EvalOperators::LogicalOr: result = (bool)(left || right); resultType = EvalResultType::Boolean; break;
+
+		//Unary operators
+		case EvalOperators::Plus: result = right; break;
+		case EvalOperators::Minus: result = -right; break;
+		case EvalOperators::BinaryNot: result = ~right; break;
+		case EvalOperators::LogicalNot: result = (bool)!right; break;
+		case EvalOperators::AbsoluteAddress: result = right >= 0 ? _debugger->GetAbsoluteAddress({ (int32_t)right, _cpuMemory }).Address : -1; break;
+		case EvalOperators::ReadDword: result = _debugger->GetMemoryDumper()->GetMemoryValue32(_cpuMemory, (uint32_t)right); break;
+
+		case EvalOperators::Bracket: result = _debugger->GetMemoryDumper()->GetMemoryValue(_cpuMemory, (uint32_t)right); break;
+		case EvalOperators::Braces: result = _debugger->GetMemoryDumper()->GetMemoryValue16(_cpuMemory, (uint32_t)right); break;
+		default: throw std::runtime_error("Invalid operator");
+	}
+	return true;
+}
+
+void ExpressionEvaluator::Compile(ExpressionData &data)
+{
+	//Convert the RPN queue into instructions that Evaluate can run without decoding each token again:
+	//special values get their own opcode, CPU-specific values go directly to this CPU's token getter,
+	//and operations whose operands are all constants are computed ahead of time.
+	data.Program.clear();
+	data.Program.reserve(data.RpnQueue.size());
+
+	//Don't fold anything in expressions that overflow the operand stack (folding reduces the stack depth needed),
+	//or that have binary operators with a missing operand (these reuse the previous operator's left operand).
+	//Evaluate's result for these expressions is the same as it would be for the original RPN queue.
+	int depth = 0;
+	bool optimize = true;
+	for(int64_t token : data.RpnQueue) {
+		if(token >= EvalOperators::Multiplication && token < EvalValues::RegA && depth > 0) {
+			depth--;
+			if(token <= EvalOperators::LogicalOr) {
+				if(depth == 0) {
+					optimize = false;
+				} else {
+					depth--;
+				}
+			}
+		}
+		depth++;
+		if(depth >= 100) {
+			optimize = false;
+		}
+	}
+
+	auto isConstant = [](ExpressionInstruction& inst) {
+		return inst.OpCode == ExpressionOpCode::Constant || inst.OpCode == ExpressionOpCode::NumericConstant || inst.OpCode == ExpressionOpCode::BooleanConstant;
+	};
+
+	for(int64_t token : data.RpnQueue) {
+		ExpressionInstruction inst = { ExpressionOpCode::Constant, token, 0 };
+		if(token >= EvalValues::FirstLabelIndex) {
+			//Labels are resolved when the expression is evaluated, since they can be changed at any time
+			inst = { ExpressionOpCode::Label, token - EvalValues::FirstLabelIndex, 0 };
+		} else if(token >= EvalValues::RegA) {
+			switch(token) {
+				case EvalValues::Value: inst.OpCode = ExpressionOpCode::Value; break;
+				case EvalValues::Address: inst.OpCode = ExpressionOpCode::Address; break;
+				case EvalValues::MemoryAddress: inst.OpCode = ExpressionOpCode::MemoryAddress; break;
+				case EvalValues::IsWrite: inst.OpCode = ExpressionOpCode::IsWrite; break;
+				case EvalValues::IsRead: inst.OpCode = ExpressionOpCode::IsRead; break;
+				case EvalValues::IsDma: inst.OpCode = ExpressionOpCode::IsDma; break;
+				case EvalValues::IsDummy: inst.OpCode = ExpressionOpCode::IsDummy; break;
+				case EvalValues::OpProgramCounter: inst.OpCode = ExpressionOpCode::OpProgramCounter; break;
+				default: inst.OpCode = ExpressionOpCode::CpuToken; break;
+			}
+		} else if(token >= EvalOperators::Multiplication) {
+			inst.OpCode = ExpressionOpCode::Operator;
+
+			//Memory reads and AbsoluteAddress depend on the memory's content/mappings and are never folded
+			size_t count = data.Program.size();
+			bool binary = token <= EvalOperators::LogicalOr;
+			bool foldable = optimize && token <= EvalOperators::LogicalNot;
+			if(foldable && count >= (binary ? 2 : 1) && isConstant(data.Program[count - 1]) && (!binary || isConstant(data.Program[count - 2]))) {
+				int64_t right = data.Program[count - 1].Param;
+				int64_t left = binary ? data.Program[count - 2].Param : 0;
+				int64_t result;
+				EvalResultType resultType = EvalResultType::Numeric;
+				if(ProcessOperator(token, left, right, result, resultType)) {
+					data.Program.resize(count - (binary ? 2 : 1));
+					inst.OpCode = resultType == EvalResultType::Boolean ? ExpressionOpCode::BooleanConstant : ExpressionOpCode::NumericConstant;
+					inst.Param = result;
+				}
+			}
+
+			if(inst.OpCode == ExpressionOpCode::Operator && optimize && binary && count >= 1 && isConstant(data.Program[count - 1])) {
+				//Merge the constant into the operator's instruction (e.g for "a == $10"), instead of pushing it on the stack
+				inst.OpCode = ExpressionOpCode::ConstantOperator;
+				inst.Operand = data.Program[count - 1].Param;
+				data.Program.pop_back();
+			}
+		}
+		data.Program.push_back(inst);
+	}
+}
+
 int64_t ExpressionEvaluator::Evaluate(ExpressionData &data, EvalResultType &resultType, MemoryOperationInfo &operationInfo, AddressInfo& addressInfo)
 {
-	if(data.RpnQueue.empty()) {
+	if(data.Program.empty()) {
 		resultType = EvalResultType::Invalid;
 		return 0;
 	}
@@ -382,15 +511,26 @@ int64_t ExpressionEvaluator::Evaluate(ExpressionData &data, EvalResultType &resu
 	int64_t operandStack[100];
 	resultType = EvalResultType::Numeric;
 
-	for(size_t i = 0, len = data.RpnQueue.size(); i < len; i++) {
-		int64_t token = data.RpnQueue[i];
-
-		if(token >= EvalValues::RegA) {
-			//Replace value with a special value
-			if(token >= EvalValues::FirstLabelIndex) {
-				int64_t labelIndex = token - EvalValues::FirstLabelIndex;
-				if((size_t)labelIndex < data.Labels.size()) {
-					token = _labelManager->GetLabelRelativeAddress(data.Labels[(uint32_t)labelIndex], _cpuType);
+	for(ExpressionInstruction& inst : data.Program) {
+		int64_t token;
+		switch(inst.OpCode) {
+			case ExpressionOpCode::Constant: token = inst.Param; break;
+			case ExpressionOpCode::NumericConstant: token = inst.Param; resultType = EvalResultType::Numeric; break;
+			case ExpressionOpCode::BooleanConstant: token = inst.Param; resultType = EvalResultType::Boolean; break;
+
+			case ExpressionOpCode::Value: token = operationInfo.Value; break;
+			case ExpressionOpCode::Address: token = operationInfo.Address; break;
+			case ExpressionOpCode::MemoryAddress: token = addressInfo.Address; break;
+			case ExpressionOpCode::IsWrite: token = operationInfo.Type == MemoryOperationType::Write || operationInfo.Type == MemoryOperationType::DmaWrite || operationInfo.Type == MemoryOperationType::DummyWrite; break;
+			case ExpressionOpCode::IsRead: token = operationInfo.Type != MemoryOperationType::Write && operationInfo.Type != MemoryOperationType::DmaWrite && operationInfo.Type != MemoryOperationType::DummyWrite; break;
+			case ExpressionOpCode::IsDma: token = operationInfo.Type == MemoryOperationType::DmaRead || operationInfo.Type == MemoryOperationType::DmaWrite; break;
+			case ExpressionOpCode::IsDummy: token = operationInfo.Type == MemoryOperationType::DummyRead || operationInfo.Type == MemoryOperationType::DummyWrite; break;
+			case ExpressionOpCode::OpProgramCounter: token = _cpuDebugger->GetProgramCounter(true); break;
+			case ExpressionOpCode::CpuToken: token = _getTokenValue ? (this->*_getTokenValue)(inst.Param, resultType) : 0; break;
+
+			case ExpressionOpCode::Label:
+				if((size_t)inst.Param < data.Labels.size()) {
+					token = _labelManager->GetLabelRelativeAddress(data.Labels[(uint32_t)inst.Param], _cpuType);
 				} else {
 					token = -2;
 				}
@@ -399,97 +539,42 @@ int64_t ExpressionEvaluator::Evaluate(ExpressionData &data, EvalResultType &resu
 					resultType = token == -1 ? EvalResultType::OutOfScope : EvalResultType::Invalid;
 					return 0;
 				}
-			} else {
-				switch(token) {
-					case EvalValues::Value: token = operationInfo.Value; break;
-					case EvalValues::Address: token = operationInfo.Address; break;
-					case EvalValues::MemoryAddress: token = addressInfo.Address; break;
-					case EvalValues::IsWrite: token = operationInfo.Type == MemoryOperationType::Write || operationInfo.Type == MemoryOperationType::DmaWrite || operationInfo.Type == MemoryOperationType::DummyWrite; break;
-					case EvalValues::IsRead: token = operationInfo.Type != MemoryOperationType::Write && operationInfo.Type != MemoryOperationType::DmaWrite && operationInfo.Type != MemoryOperationType::DummyWrite; break;
-					case EvalValues::IsDma: token = operationInfo.Type == MemoryOperationType::DmaRead || operationInfo.Type == MemoryOperationType::DmaWrite; break;
-					case EvalValues::IsDummy: token = operationInfo.Type == MemoryOperationType::DummyRead|| operationInfo.Type == MemoryOperationType::DummyWrite; break;
-					case EvalValues::OpProgramCounter: token = _cpuDebugger->GetProgramCounter(true); break;
-
-					default:
-						if(!_cpuDebugger) {
-							token = 0;
-						} else {
-							switch(_cpuType) {
-								case CpuType::Snes: token = GetSnesTokenValue(token, resultType); break;
-								case CpuType::Spc: token = GetSpcTokenValue(token, resultType); break;
-								case CpuType::NecDsp: token = GetNecDspTokenValue(token, resultType); break;
-								case CpuType::Sa1: token = GetSnesTokenValue(token, resultType); break;
-								case CpuType::Gsu: token = GetGsuTokenValue(token, resultType); break;
-								case CpuType::Cx4: token = GetCx4TokenValue(token, resultType); break;
-								case CpuType::St018: token = GetSt018TokenValue(token, resultType); break;
-								case CpuType::Gameboy: token = GetGameboyTokenValue(token, resultType); break;
-								case CpuType::Nes: token = GetNesTokenValue(token, resultType); break;
-								case CpuType::Pce: token = GetPceTokenValue(token, resultType); break;
-								case CpuType::Sms: token = GetSmsTokenValue(token, resultType); break;
-								case CpuType::Gba: token = GetGbaTokenValue(token, resultType); break;
-								case CpuType::Ws: token = GetWsTokenValue(token, resultType); break;
-							}
-						}
-						break;
+				break;
+
+			case ExpressionOpCode::Operator:
+				if(pos <= 0) {
+					resultType = EvalResultType::Invalid;
+					return 0;
 				}
-			}
-		} else if(token >= EvalOperators::Multiplication) {
-			if(pos <= 0) {
-				resultType = EvalResultType::Invalid;
-				return 0;
-			}
 
-			right = operandStack[--pos];
-			if(pos > 0 && token <= EvalOperators::LogicalOr) {
-				//Only do this for binary operators
-				left = operandStack[--pos];
-			}
+				right = operandStack[--pos];
+				if(pos > 0 && inst.Param <= EvalOperators::LogicalOr) {
+					//Only do this for binary operators
+					left = operandStack[--pos];
+				}
 
-			resultType = EvalResultType::Numeric;
-			switch(token) {
-				case EvalOperators::Multiplication: token = left * right; break;
-				case EvalOperators::Division: 
-					if(right == 0) {
-						resultType = EvalResultType::DivideBy0;
-						return 0;
-					}
-					token = left / right; break;
-				case EvalOperators::Modulo:
-					if(right == 0) {
-						resultType = EvalResultType::DivideBy0;
-						return 0;
-					}
-					token = left % right;
-					break;
-				case EvalOperators::Addition: token = left + right; break;
-				case EvalOperators::Substration: token = left - right; break;
-				case EvalOperators::ShiftLeft: token = left << right; break;
-				case EvalOperators::ShiftRight: token = left >> right; break;
-				case EvalOperators::SmallerThan: token = left < right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::SmallerOrEqual: token = left <= right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::GreaterThan: token = left > right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::GreaterOrEqual: token = left >= right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::Equal: token = left == right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::NotEqual: token = left != right; resultType = EvalResultType::Boolean; break;
-				case EvalOperators::BinaryAnd: token = left & right; break;
-				case EvalOperators::BinaryXor: token = left ^ right; break;
-				case EvalOperators::BinaryOr: token = left | right; break;
-				case EvalOperators::LogicalAnd: token = (bool)(left && right); resultType = EvalResultType::Boolean; break;
-				case EvalOperators::LogicalOr: token = (bool)(left || right); resultType = EvalResultType::Boolean; break;
-
-				//Unary operators
-				case EvalOperators::Plus: token = right; break;
-				case EvalOperators::Minus: token = -right; break;
-				case EvalOperators::BinaryNot: token = ~right; break;
-				case EvalOperators::LogicalNot: token = (bool)!right; break;
-				case EvalOperators::AbsoluteAddress: token = right >= 0 ? _debugger->GetAbsoluteAddress({ (int32_t)right, _cpuMemory }).Address : -1; break;
-				case EvalOperators::ReadDword: token = _debugger->GetMemoryDumper()->GetMemoryValue32(_cpuMemory, (uint32_t)right); break;
-
-				case EvalOperators::Bracket: token = _debugger->GetMemoryDumper()->GetMemoryValue(_cpuMemory, (uint32_t)right); break;
-				case EvalOperators::Braces: token = _debugger->GetMemoryDumper()->GetMemoryValue16(_cpuMemory, (uint32_t)right); break;
-				default: throw std::runtime_error("Invalid operator");
-			}
+				resultType = EvalResultType::Numeric;
+				if(!ProcessOperator(inst.Param, left, right, token, resultType)) {
+					return 0;
+				}
+				break;
+
+			case ExpressionOpCode::ConstantOperator:
+				//Binary operator with a constant right operand
+				right = inst.Operand;
+				if(pos > 0) {
+					left = operandStack[--pos];
+				}
+
+				resultType = EvalResultType::Numeric;
+				if(!ProcessOperator(inst.Param, left, right, token, resultType)) {
+					return 0;
+				}
+				break;
+
+			default: throw std::runtime_error("Invalid instruction");
 		}
+
 		operandStack[pos++] = token;
 		if(pos >= 100) {
 			resultType = EvalResultType::Invalid;
@@ -506,6 +591,24 @@ ExpressionEvaluator::ExpressionEvaluator(Debugger* debugger, IDebugger* cpuDebug
 	_labelManager = debugger->GetLabelManager();
 	_cpuType = cpuType;
 	_cpuMemory = DebugUtilities::GetCpuMemoryType(cpuType);
+
+	if(_cpuDebugger) {
+		switch(_cpuType) {
+			case CpuType::Snes: _getTokenValue = &ExpressionEvaluator::GetSnesTokenValue; break;
+			case CpuType::Spc: _getTokenValue = &ExpressionEvaluator::GetSpcTokenValue; break;
+			case CpuType::NecDsp: _getTokenValue = &ExpressionEvaluator::GetNecDspTokenValue; break;
+			case CpuType::Sa1: _getTokenValue = &ExpressionEvaluator::GetSnesTokenValue; break;
+			case CpuType::Gsu: _getTokenValue = &ExpressionEvaluator::GetGsuTokenValue; break;
+			case CpuType::Cx4: _getTokenValue = &ExpressionEvaluator::GetCx4TokenValue; break;
+			case CpuType::St018: _getTokenValue = &ExpressionEvaluator::GetSt018TokenValue; break;
+			case CpuType::Gameboy: _getTokenValue = &ExpressionEvaluator::GetGameboyTokenValue; break;
+			case CpuType::Nes: _getTokenValue = &ExpressionEvaluator::GetNesTokenValue; break;
+			case CpuType::Pce: _getTokenValue = &ExpressionEvaluator::GetPceTokenValue; break;
+			case CpuType::Sms: _getTokenValue = &ExpressionEvaluator::GetSmsTokenValue; break;
+			case CpuType::Gba: _getTokenValue = &ExpressionEvaluator::GetGbaTokenValue; break;
+			case CpuType::Ws: _getTokenValue = &ExpressionEvaluator::GetWsTokenValue; break;
+		}
+	}
 }
 
 bool ExpressionEvaluator::ReturnBool(int64_t value, EvalResultType& resultType)
@@ -572,6 +675,7 @@ ExpressionData* ExpressionEvaluator::PrivateGetRpnList(string expression, bool&
 		ExpressionData data;
 		success = ToRpn(fixedExp, data);
 		if(success) {
+			Compile(data);
 			LockHandler lock = _cacheLock.AcquireSafe();
 			_cache[expression] = data;
 			cachedData = &_cache[expression];
@@ -224,10 +224,44 @@ public:
 	}
 };
 
+enum class ExpressionOpCode : uint8_t
+{
+	Constant,
+
+	//Result of an operation on constants that was computed when the expression was compiled
+	NumericConstant,
+	BooleanConstant,
+
+	Value,
+	Address,
+	MemoryAddress,
+	IsWrite,
+	IsRead,
+	IsDma,
+	IsDummy,
+	OpProgramCounter,
+	CpuToken,
+	Label,
+	Operator,
+	ConstantOperator
+};
+
+struct ExpressionInstruction
+{
+	ExpressionOpCode OpCode;
+	int64_t Param;
+
+	//Right operand of ConstantOperator instructions
+	int64_t Operand;
+};
+
 struct ExpressionData
 {
 	vector<int64_t> RpnQueue;
 	vector<string> Labels;
+
+	//RpnQueue compiled into pre-decoded instructions, this is what Evaluate runs
+	vector<ExpressionInstruction> Program;
 };
 
 class ExpressionEvaluator
@@ -248,6 +282,9 @@ private:
 	CpuType _cpuType;
 	MemoryType _cpuMemory;
 
+	typedef int64_t(ExpressionEvaluator::*TokenValueGetter)(int64_t token, EvalResultType& resultType);
+	TokenValueGetter _getTokenValue = nullptr;
+
 	bool IsOperator(string token, int &precedence, bool unaryOperator);
 	EvalOperators GetOperator(string token, bool unaryOperator);
 	unordered_map<string, int64_t>* GetAvailableTokens();
@@ -296,6 +333,8 @@ private:
 	string GetNextToken(string expression, size_t &pos, ExpressionData &data, bool &success, bool previousTokenIsOp);
 	bool ProcessSpecialOperator(EvalOperators evalOp, std::stack<EvalOperators> &opStack, std::stack<int> &precedenceStack, vector<int64_t> &outputQueue);
 	bool ToRpn(string expression, ExpressionData &data);
+	void Compile(ExpressionData &data);
+	bool ProcessOperator(int64_t op, int64_t left, int64_t right, int64_t &result, EvalResultType &resultType);
 	int64_t PrivateEvaluate(string expression, EvalResultType &resultType, MemoryOperationInfo &operationInfo, AddressInfo& addressInfo, bool &success);
 	ExpressionData* PrivateGetRpnList(string expression, bool& success);
 
@@ -31,6 +31,7 @@ public:
 
 	virtual int64_t GetRowId(uint32_t offset) = 0;
 	virtual void GetExecutionTrace(TraceRow& row, uint32_t offset) = 0;
+	virtual bool FormatBinaryRecord(uint8_t* data, uint32_t stateSize, string& output) = 0;
 	virtual void Clear() = 0;
 	virtual void SetOptions(TraceLoggerOptions options) = 0;
 
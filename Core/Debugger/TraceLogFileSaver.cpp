@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "Debugger/TraceLogFileSaver.h"
+#include "Debugger/Debugger.h"
+#include "Debugger/DebugBreakHelper.h"
+#include "Debugger/DebugUtilities.h"
+#include "Debugger/DisassemblyInfo.h"
+#include "Debugger/ITraceLogger.h"
+#include "Debugger/BaseTraceLogger.h"
+
+TraceLogFileSaver::TraceLogFileSaver(Debugger* debugger)
+{
+	_debugger = debugger;
+	_stopFlag = false;
+}
+
+TraceLogFileSaver::~TraceLogFileSaver()
+{
+	InternalStopLogging();
+}
+
+void TraceLogFileSaver::StartLogging(string filename, bool binaryFormat)
+{
+	DebugBreakHelper helper(_debugger);
+	InternalStopLogging();
+
+	_outputFile.open(filename, ios::out | ios::binary);
+	if(!_outputFile) {
+		return;
+	}
+
+	_binaryFormat = binaryFormat;
+	if(_binaryFormat) {
+		BinaryTraceLogHeader header = { { 'M', 'T', 'L', 'B' }, BinaryFormatVersion, sizeof(DisassemblyInfo), sizeof(TraceLogPpuState), sizeof(TraceLogMemoryAccess) };
+		_outputFile.write((char*)&header, sizeof(header));
+	}
+
+	_currentBlock.resize(BlockSize);
+	_blockPos = 0;
+	_stopFlag = false;
+	_writerThread.reset(new std::thread(&TraceLogFileSaver::WriterThread, this));
+	_enabled = true;
+}
+
+void TraceLogFileSaver::StopLogging()
+{
+	DebugBreakHelper helper(_debugger);
+	InternalStopLogging();
+}
+
+void TraceLogFileSaver::InternalStopLogging()
+{
+	if(_enabled) {
+		_enabled = false;
+		SubmitBlock();
+		StopWriter();
+		_outputFile.close();
+
+		_currentBlock = vector<uint8_t>();
+		_freeBlocks.clear();
+	}
+}
+
+void TraceLogFileSaver::StopWriter()
+{
+	if(_writerThread) {
+		_stopFlag = true;
+		_writeSignal.Signal();
+		_writerThread->join();
+		_writerThread.reset();
+	}
+}
+
+void TraceLogFileSaver::SubmitBlock()
+{
+	if(_blockPos == 0) {
+		return;
+	}
+
+	_currentBlock.resize(_blockPos);
+
+	while(true) {
+		auto lock = _lock.AcquireSafe();
+		if(_pendingBlocks.size() < MaxPendingBlocks) {
+			_pendingBlocks.push_back(std::move(_currentBlock));
+			if(_freeBlocks.empty()) {
+				_currentBlock = vector<uint8_t>();
+			} else {
+				_currentBlock = std::move(_freeBlocks.back());
+				_freeBlocks.pop_back();
+			}
+			break;
+		}
+
+		//The writer thread can't keep up, wait for it to write a block to the disk before continuing
+		lock.Release();
+		_writeSignal.Signal();
+		_blockWritten.Wait(100);
+	}
+
+	_currentBlock.resize(BlockSize);
+	_blockPos = 0;
+	_writeSignal.Signal();
+}
+
+void TraceLogFileSaver::WriterThread()
+{
+	while(true) {
+		_writeSignal.Wait();
+
+		while(true) {
+			vector<uint8_t> block;
+			{
+				auto lock = _lock.AcquireSafe();
+				if(_pendingBlocks.empty()) {
+					break;
+				}
+				block = std::move(_pendingBlocks.front());
+				_pendingBlocks.pop_front();
+			}
+
+			_outputFile.write((char*)block.data(), block.size());
+
+			{
+				auto lock = _lock.AcquireSafe();
+				_freeBlocks.push_back(std::move(block));
+			}
+			_blockWritten.Signal();
+		}
+
+		if(_stopFlag) {
+			break;
+		}
+	}
+}
+
+bool TraceLogFileSaver::ConvertBinaryLog(string inputFile, string outputFile)
+{
+	ifstream input(inputFile, ios::in | ios::binary);
+	if(!input) {
+		return false;
+	}
+
+	BinaryTraceLogHeader header = {};
+	input.read((char*)&header, sizeof(header));
+	if(!input || memcmp(header.Magic, "MTLB", 4) != 0 || header.Version != BinaryFormatVersion) {
+		return false;
+	}
+
+	if(header.DisassemblyInfoSize != sizeof(DisassemblyInfo) || header.PpuStateSize != sizeof(TraceLogPpuState) || header.MemoryAccessSize != sizeof(TraceLogMemoryAccess)) {
+		//Log was recorded by an incompatible build
+		return false;
+	}
+
+	ofstream output(outputFile, ios::out | ios::binary);
+	if(!output) {
+		return false;
+	}
+
+	//The trace loggers' format options are used to format the rows, prevent them from being changed during the conversion
+	DebugBreakHelper helper(_debugger);
+
+	vector<uint8_t> data;
+	string row;
+	string outputBuffer;
+	outputBuffer.reserve(BlockSize + 1000);
+
+	while(true) {
+		BinaryTraceRecordHeader record;
+		input.read((char*)&record, sizeof(record));
+		if(!input) {
+			break;
+		}
+
+		data.resize(header.DisassemblyInfoSize + header.PpuStateSize + header.MemoryAccessSize + record.StateSize);
+		input.read((char*)data.data(), data.size());
+		if(!input) {
+			break;
+		}
+
+		if(record.Type > DebugUtilities::GetLastCpuType()) {
+			return false;
+		}
+
+		ITraceLogger* logger = _debugger->GetTraceLogger(record.Type);
+		row.clear();
+		if(logger && logger->FormatBinaryRecord(data.data(), record.StateSize, row)) {
+			outputBuffer += row;
+			outputBuffer += '\n';
+			if(outputBuffer.size() > BlockSize) {
+				output.write(outputBuffer.c_str(), outputBuffer.size());
+				outputBuffer.clear();
+			}
+		}
+	}
+
+	output.write(outputBuffer.c_str(), outputBuffer.size());
+	return true;
+}
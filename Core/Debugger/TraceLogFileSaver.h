@@ -1,48 +1,99 @@
 #pragma once
 #include "pch.h"
+#include <thread>
+#include "Utilities/SimpleLock.h"
+#include "Utilities/AutoResetEvent.h"
+
+class Debugger;
+enum class CpuType : uint8_t;
+
+struct BinaryTraceLogHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t DisassemblyInfoSize;
+	uint32_t PpuStateSize;
+	uint32_t MemoryAccessSize;
+};
+
+//Each record is followed by the DisassemblyInfo, TraceLogPpuState, TraceLogMemoryAccess and cpu state (StateSize bytes) for the instruction
+struct BinaryTraceRecordHeader
+{
+	CpuType Type;
+	uint8_t Reserved;
+	uint16_t StateSize;
+};
 
 class TraceLogFileSaver
 {
 private:
+	static constexpr uint32_t BlockSize = 0x100000;
+	static constexpr uint32_t MaxPendingBlocks = 32;
+	static constexpr uint32_t BinaryFormatVersion = 1;
+
+	Debugger* _debugger;
+
 	bool _enabled = false;
-	string _outputFilepath;
-	string _outputBuffer;
+	bool _binaryFormat = false;
 	ofstream _outputFile;
 
-public:
-	~TraceLogFileSaver()
-	{
-		StopLogging();
-	}
+	//Data is written to the current block by the emulation thread, and full blocks are written to the file by the writer thread
+	vector<uint8_t> _currentBlock;
+	uint32_t _blockPos = 0;
+	deque<vector<uint8_t>> _pendingBlocks;
+	vector<vector<uint8_t>> _freeBlocks;
 
-	void StartLogging(string filename)
-	{
-		_outputBuffer.clear();
-		_outputFile.open(filename, ios::out | ios::binary);
-		_enabled = true;
-	}
+	unique_ptr<std::thread> _writerThread;
+	SimpleLock _lock;
+	AutoResetEvent _writeSignal;
+	AutoResetEvent _blockWritten;
+	atomic<bool> _stopFlag;
+
+	void WriterThread();
+	void SubmitBlock();
+	void StopWriter();
+	void InternalStopLogging();
 
-	void StopLogging()
+	__forceinline uint8_t* Reserve(uint32_t size)
 	{
-		if(_enabled) {
-			_enabled = false;
-			if(_outputFile) {
-				if(!_outputBuffer.empty()) {
-					_outputFile << _outputBuffer;
-				}
-				_outputFile.close();
-			}
+		if(_blockPos + size > BlockSize) {
+			SubmitBlock();
 		}
+		uint8_t* dst = _currentBlock.data() + _blockPos;
+		_blockPos += size;
+		return dst;
 	}
 
+public:
+	TraceLogFileSaver(Debugger* debugger);
+	~TraceLogFileSaver();
+
+	void StartLogging(string filename, bool binaryFormat = false);
+	void StopLogging();
+
 	__forceinline bool IsEnabled() { return _enabled; }
+	__forceinline bool IsBinaryFormat() { return _binaryFormat; }
 
 	void Log(string& log)
 	{
-		_outputBuffer += log + '\n';
-		if(_outputBuffer.size() > 32768) {
-			_outputFile << _outputBuffer;
-			_outputBuffer.clear();
+		if(log.size() + 1 > BlockSize) {
+			return;
 		}
+
+		uint8_t* dst = Reserve((uint32_t)log.size() + 1);
+		memcpy(dst, log.c_str(), log.size());
+		dst[log.size()] = '\n';
 	}
-};
\ No newline at end of file
+
+	//Returns a buffer where the caller writes the record's data (dataSize bytes, after the record header)
+	__forceinline uint8_t* LogBinary(CpuType cpuType, uint16_t stateSize, uint32_t dataSize)
+	{
+		uint8_t* dst = Reserve(sizeof(BinaryTraceRecordHeader) + dataSize);
+		BinaryTraceRecordHeader header = { cpuType, 0, stateSize };
+		memcpy(dst, &header, sizeof(header));
+		return dst + sizeof(BinaryTraceRecordHeader);
+	}
+
+	//Formats a binary trace log file using the trace loggers' current format options and writes the result as a text file
+	bool ConvertBinaryLog(string inputFile, string outputFile);
+};
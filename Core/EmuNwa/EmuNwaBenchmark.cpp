@@ -0,0 +1,324 @@
+#include "pch.h"
+#include "EmuNwa/EmuNwaBenchmark.h"
+#include "EmuNwa/EmuNwaServer.h"
+#include "EmuNwa/EmuNwaMemoryRegistry.h"
+#include "Shared/Emulator.h"
+#include "Shared/EmulatorBenchmark.h"
+#include "Utilities/Socket.h"
+#include "Utilities/Timer.h"
+
+//Minimal NWA client: sends requests and splits the server's output into replies
+class EmuNwaBenchmarkClient
+{
+private:
+	unique_ptr<Socket> _socket;
+	vector<uint8_t> _buffer;
+	size_t _bufferSize = 0;
+
+	//Returns the length of the first reply in the buffer, or 0 if the reply is incomplete
+	size_t GetReplyLength(bool& isError)
+	{
+		if(_bufferSize == 0) {
+			return 0;
+		}
+
+		if(_buffer[0] == 0) {
+			//Binary reply: 0 + 32-bit big endian length + data
+			if(_bufferSize < 5) {
+				return 0;
+			}
+			size_t length = 5 + (((size_t)_buffer[1] << 24) | (_buffer[2] << 16) | (_buffer[3] << 8) | _buffer[4]);
+			isError = false;
+			return _bufferSize >= length ? length : 0;
+		}
+
+		//ASCII reply: \n + key:value lines + \n
+		for(size_t i = 1; i < _bufferSize; i++) {
+			if(_buffer[i] == '\n' && _buffer[i - 1] == '\n') {
+				isError = i > 6 && memcmp(_buffer.data(), "\nerror:", 7) == 0;
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+public:
+	bool Connect()
+	{
+		_socket.reset(new Socket());
+		_buffer.resize(0x10000);
+		_bufferSize = 0;
+		return _socket->Connect("127.0.0.1", EmuNwaServer::ServerPort) && !_socket->ConnectionError();
+	}
+
+	bool SendRequest(const string& request)
+	{
+		string message = request + "\n";
+		_socket->Send((char*)message.c_str(), (int)message.size(), 0);
+		return !_socket->ConnectionError();
+	}
+
+	Socket* GetSocket() { return _socket.get(); }
+
+	//Reads the data that is available without blocking - returns false if the connection was closed
+	bool Receive()
+	{
+		if(_bufferSize == _buffer.size()) {
+			_buffer.resize(_buffer.size() * 2);
+		}
+
+		int received = _socket->Recv((char*)_buffer.data() + _bufferSize, (int)(_buffer.size() - _bufferSize), 0);
+		if(received > 0) {
+			_bufferSize += received;
+		}
+		return !_socket->ConnectionError();
+	}
+
+	//Removes the first reply from the buffer - returns false if no full reply was received yet
+	bool PopReply(bool& isError)
+	{
+		size_t length = GetReplyLength(isError);
+		if(length == 0) {
+			return false;
+		}
+
+		_bufferSize -= length;
+		memmove(_buffer.data(), _buffer.data() + length, _bufferSize);
+		return true;
+	}
+
+	//Waits until a full reply is received - returns false on timeout or if the connection was closed
+	bool ReadReply(bool& isError, uint32_t timeout)
+	{
+		vector<Socket*> sockets = { _socket.get() };
+		vector<uint8_t> events = { Socket::PollRead };
+		vector<uint8_t> results;
+
+		while(!PopReply(isError)) {
+			if(Socket::Poll(sockets, events, results, timeout) <= 0 || !Receive()) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+EmuNwaBenchmark::EmuNwaBenchmark(Emulator* emu)
+{
+	_emu = emu;
+}
+
+vector<std::pair<string, string>> EmuNwaBenchmark::GetRequests()
+{
+	vector<std::pair<string, string>> requests;
+	requests.push_back({ "emulationStatus", "EMULATION_STATUS" });
+
+	const EmuNwaCoreInfo* core = EmuNwaMemoryRegistry::GetCore(_emu->GetConsoleType());
+	if(!core) {
+		return requests;
+	}
+
+	const EmuNwaMemoryInfo* directMemory = nullptr;
+	const EmuNwaMemoryInfo* busMemory = nullptr;
+	for(size_t i = 0; i < core->MemoryCount; i++) {
+		const EmuNwaMemoryInfo& memory = core->Memories[i];
+		if(memory.BusSize > 0) {
+			busMemory = busMemory ? busMemory : &memory;
+		} else if(!directMemory && _emu->GetMemory(memory.Type).Size >= 16) {
+			directMemory = &memory;
+		}
+	}
+
+	if(directMemory) {
+		requests.push_back({ "coreReadDirect", string("CORE_READ ") + directMemory->Name + ";$0;$10" });
+	}
+	if(busMemory) {
+		requests.push_back({ "coreReadBus", string("CORE_READ ") + busMemory->Name + ";$0;$10" });
+	}
+	return requests;
+}
+
+EmuNwaBenchmarkResult EmuNwaBenchmark::RunRequestReply(const string& name, const string& request, uint32_t requestCount)
+{
+	EmuNwaBenchmarkResult result = {};
+	result.Name = name;
+	result.Request = request;
+	result.ClientCount = 1;
+
+	EmuNwaBenchmarkClient client;
+	if(!client.Connect()) {
+		result.ErrorCount = requestCount;
+		return result;
+	}
+
+	bool isError = false;
+	for(uint32_t i = 0; i < WarmupRequestCount; i++) {
+		if(!client.SendRequest(request) || !client.ReadReply(isError, ReplyTimeout)) {
+			result.ErrorCount = requestCount;
+			return result;
+		}
+	}
+
+	vector<double> latencies;
+	latencies.reserve(requestCount);
+
+	Timer runTimer;
+	Timer timer;
+	for(uint32_t i = 0; i < requestCount; i++) {
+		timer.Reset();
+		if(!client.SendRequest(request) || !client.ReadReply(isError, ReplyTimeout)) {
+			//Connection lost or reply timed out, the remaining requests can't be sent
+			result.ErrorCount += requestCount - i;
+			break;
+		}
+		latencies.push_back(timer.GetElapsedMS() * 1000);
+		if(isError) {
+			result.ErrorCount++;
+		} else {
+			result.RequestCount++;
+		}
+	}
+	result.ElapsedMs = runTimer.GetElapsedMS();
+
+	SetLatencyStats(result, latencies);
+	return result;
+}
+
+EmuNwaBenchmarkResult EmuNwaBenchmark::RunLoadTest(const string& name, const string& request, uint32_t clientCount, uint32_t requestsPerClient)
+{
+	EmuNwaBenchmarkResult result = {};
+	result.Name = name;
+	result.Request = request;
+	result.ClientCount = clientCount;
+
+	vector<unique_ptr<EmuNwaBenchmarkClient>> clients;
+	bool isError = false;
+	for(uint32_t i = 0; i < clientCount; i++) {
+		unique_ptr<EmuNwaBenchmarkClient> client(new EmuNwaBenchmarkClient());
+		if(!client->Connect() || !client->SendRequest(request) || !client->ReadReply(isError, ReplyTimeout)) {
+			result.ErrorCount = clientCount * requestsPerClient;
+			return result;
+		}
+		clients.push_back(std::move(client));
+	}
+
+	//All clients are driven by this thread: each one has a single request in flight, and sends
+	//its next request as soon as its reply is received
+	vector<Socket*> sockets(clientCount);
+	vector<uint8_t> events(clientCount, Socket::PollRead);
+	vector<uint8_t> pollResults;
+	vector<uint32_t> remaining(clientCount, requestsPerClient);
+	vector<Timer> sendTimers(clientCount);
+	vector<double> latencies;
+	latencies.reserve((size_t)clientCount * requestsPerClient);
+
+	uint32_t activeCount = 0;
+	Timer runTimer;
+	for(uint32_t i = 0; i < clientCount && requestsPerClient > 0; i++) {
+		sockets[i] = clients[i]->GetSocket();
+		sendTimers[i].Reset();
+		clients[i]->SendRequest(request);
+		activeCount++;
+	}
+
+	while(activeCount > 0) {
+		if(Socket::Poll(sockets, events, pollResults, ReplyTimeout) <= 0) {
+			//No reply for too long, the requests that are left count as errors
+			break;
+		}
+
+		for(uint32_t i = 0; i < clientCount; i++) {
+			if(!sockets[i] || !pollResults[i]) {
+				continue;
+			}
+
+			bool connected = clients[i]->Receive();
+			while(remaining[i] > 0 && clients[i]->PopReply(isError)) {
+				latencies.push_back(sendTimers[i].GetElapsedMS() * 1000);
+				if(isError) {
+					result.ErrorCount++;
+				} else {
+					result.RequestCount++;
+				}
+
+				remaining[i]--;
+				if(remaining[i] > 0) {
+					sendTimers[i].Reset();
+					connected &= clients[i]->SendRequest(request);
+				}
+			}
+
+			if(remaining[i] == 0 || !connected) {
+				result.ErrorCount += remaining[i];
+				remaining[i] = 0;
+				sockets[i] = nullptr;
+				activeCount--;
+			}
+		}
+	}
+	result.ElapsedMs = runTimer.GetElapsedMS();
+
+	for(uint32_t i = 0; i < clientCount; i++) {
+		result.ErrorCount += remaining[i];
+	}
+
+	SetLatencyStats(result, latencies);
+	return result;
+}
+
+void EmuNwaBenchmark::SetLatencyStats(EmuNwaBenchmarkResult& result, vector<double>& latencies)
+{
+	result.RequestsPerSecond = result.ElapsedMs > 0 ? latencies.size() * 1000 / result.ElapsedMs : 0;
+	result.LatencyMedian = EmulatorBenchmark::Median(latencies);
+	result.LatencyP99 = EmulatorBenchmark::Percentile(latencies, 99);
+	result.LatencyMax = EmulatorBenchmark::Percentile(latencies, 100);
+}
+
+static void WriteResult(stringstream& out, EmuNwaBenchmarkResult& r)
+{
+	out << "\"request\": \"" << EmulatorBenchmark::EscapeJson(r.Request) << "\", ";
+	out << "\"replies\": " << r.RequestCount << ", \"errors\": " << r.ErrorCount << ", \"elapsedMs\": " << r.ElapsedMs << ", ";
+	out << "\"requestsPerSecond\": " << r.RequestsPerSecond << ", ";
+	out << "\"latencyUs\": { \"median\": " << r.LatencyMedian << ", \"p99\": " << r.LatencyP99 << ", \"max\": " << r.LatencyMax << " } }";
+}
+
+string EmuNwaBenchmark::ToJson(vector<EmuNwaBenchmarkRomResult>& results, string version, uint32_t requestCount)
+{
+	stringstream out;
+	out << std::fixed << std::setprecision(4);
+	out << "{\n";
+	out << "  \"version\": \"" << EmulatorBenchmark::EscapeJson(version) << "\",\n";
+	out << "  \"requests\": " << requestCount << ",\n";
+	out << "  \"roms\": [";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		EmuNwaBenchmarkRomResult& rom = results[i];
+		const EmuNwaCoreInfo* core = EmuNwaMemoryRegistry::GetCore(rom.Console);
+
+		out << (i > 0 ? "," : "") << "\n    {\n";
+		out << "      \"name\": \"" << EmulatorBenchmark::EscapeJson(rom.RomName) << "\",\n";
+		out << "      \"core\": \"" << (core ? core->Name : "") << "\",\n";
+		out << "      \"requestReply\": {";
+
+		for(size_t j = 0; j < rom.Requests.size(); j++) {
+			EmuNwaBenchmarkResult& r = rom.Requests[j];
+			out << (j > 0 ? "," : "") << "\n        \"" << r.Name << "\": { ";
+			WriteResult(out, r);
+		}
+		out << "\n      }";
+
+		if(!rom.LoadTests.empty()) {
+			out << ",\n      \"loadTest\": [";
+			for(size_t j = 0; j < rom.LoadTests.size(); j++) {
+				EmuNwaBenchmarkResult& r = rom.LoadTests[j];
+				out << (j > 0 ? "," : "") << "\n        { \"clients\": " << r.ClientCount << ", ";
+				WriteResult(out, r);
+			}
+			out << "\n      ]";
+		}
+		out << "\n    }";
+	}
+
+	out << "\n  ]\n}\n";
+	return out.str();
+}
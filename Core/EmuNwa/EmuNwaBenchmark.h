@@ -0,0 +1,59 @@
+#pragma once
+#include "pch.h"
+
+class Emulator;
+enum class ConsoleType;
+
+struct EmuNwaBenchmarkResult
+{
+	string Name;
+	string Request;
+	uint32_t ClientCount = 0;
+
+	uint32_t RequestCount = 0; //Requests that received a valid reply
+	uint32_t ErrorCount = 0; //Error replies, or requests that never received a reply
+	double ElapsedMs = 0;
+	double RequestsPerSecond = 0;
+
+	//Round trip time of each request (from the send to the end of the reply), in microseconds
+	double LatencyMedian = 0;
+	double LatencyP99 = 0;
+	double LatencyMax = 0;
+};
+
+struct EmuNwaBenchmarkRomResult
+{
+	string RomName;
+	ConsoleType Console = {};
+	vector<EmuNwaBenchmarkResult> Requests;
+	vector<EmuNwaBenchmarkResult> LoadTests;
+};
+
+//Measures the EmuNwa server's request/reply overhead by connecting to it like a regular client would
+//The server must be started and a game must be loaded before running the benchmark
+class EmuNwaBenchmark
+{
+private:
+	static constexpr uint32_t ReplyTimeout = 5000;
+	static constexpr uint32_t WarmupRequestCount = 100;
+
+	Emulator* _emu;
+
+	static void SetLatencyStats(EmuNwaBenchmarkResult& result, vector<double>& latencies);
+
+public:
+	EmuNwaBenchmark(Emulator* emu);
+
+	//Returns the requests to benchmark for the loaded game's core: a request that doesn't lock the emulator,
+	//and small CORE_READs from a memory that is mapped directly and from a CPU's bus
+	vector<std::pair<string, string>> GetRequests();
+
+	//Sends the same request requestCount times, waiting for each reply before sending the next request
+	EmuNwaBenchmarkResult RunRequestReply(const string& name, const string& request, uint32_t requestCount);
+
+	//Opens clientCount connections that each send requestsPerClient requests (each client waits for its reply before
+	//sending its next request), to measure the server's throughput and latency with many clients connected at once
+	EmuNwaBenchmarkResult RunLoadTest(const string& name, const string& request, uint32_t clientCount, uint32_t requestsPerClient);
+
+	static string ToJson(vector<EmuNwaBenchmarkRomResult>& results, string version, uint32_t requestCount);
+};
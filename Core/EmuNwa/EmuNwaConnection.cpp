@@ -1,15 +1,14 @@
 #include "pch.h"
 #include "EmuNwa/EmuNwaConnection.h"
 #include "EmuNwa/EmuNwaServer.h"
+#include "EmuNwa/EmuNwaSnapshot.h"
 #include "Shared/MessageManager.h"
 #include "Shared/Emulator.h"
 #include "Shared/SaveStateManager.h"
+#include "EmuNwa/EmuNwaMemoryRegistry.h"
 #include "Utilities/FolderUtilities.h"
-#include <sstream>
 #include <cstring>
-#include <map>
-#include <cstdint> // For fixed-size integer types (uint8_t, etc.)
-#include <algorithm> // For std::copy_n
+#include <charconv>
 
 // Platform-specific headers for endianness conversion (replace with appropriate headers)
 #ifdef _WIN32
@@ -18,30 +17,78 @@
 #include <arpa/inet.h>
 #endif
 
-std::string toLower(const std::string& str)
+static bool EqualsIgnoreCase(std::string_view str, std::string_view lowerCaseValue)
 {
-	std::string result = str;
-	std::transform(result.begin(), result.end(), result.begin(),
-						[](unsigned char c) { return std::tolower(c); });
-	return result;
+	if(str.size() != lowerCaseValue.size()) {
+		return false;
+	}
+
+	for(size_t i = 0; i < str.size(); i++) {
+		if(std::tolower((unsigned char)str[i]) != lowerCaseValue[i]) {
+			return false;
+		}
+	}
+	return true;
 }
 
-// Utility function to check if a string starts with a prefix
-bool startsWith(const std::string& str, const std::string& prefix)
+// Splits the string on ';' into views of the original string (a trailing empty argument is ignored)
+static void SplitArguments(std::string_view str, vector<std::string_view>& arguments)
+{
+	arguments.clear();
+	size_t start = 0;
+	while(start < str.size()) {
+		size_t end = str.find(';', start);
+		if(end == std::string_view::npos) {
+			arguments.push_back(str.substr(start));
+			break;
+		}
+		arguments.push_back(str.substr(start, end - start));
+		start = end + 1;
+	}
+}
+
+static const EmuNwaMemoryInfo* FindMemory(Emulator* emu, std::string_view memoryName)
+{
+	return EmuNwaMemoryRegistry::FindMemory(emu->GetConsoleType(), memoryName);
+}
+// Converts the name of a memory that is directly mapped in the emulator's memory (i.e not CPUBUS/APUBUS)
+static bool TryGetMemoryType(Emulator* emu, std::string_view memoryName, MemoryType& type)
 {
-	return str.compare(0, prefix.size(), prefix) == 0;
+	const EmuNwaMemoryInfo* info = FindMemory(emu, memoryName);
+	if(!info || info->BusSize != 0) {
+		return false;
+	}
+	type = info->Type;
+	return true;
 }
 
-// Utility function to split a string into a vector based on a delimiter
-std::vector<std::string> split(const std::string& s, char delimiter)
+// Parses a decimal value, or a hexadecimal value when prefixed with $
+static bool TryParseNumber(std::string_view str, size_t& value)
 {
-	std::vector<std::string> tokens;
-	std::string token;
-	std::istringstream tokenStream(s);
-	while(std::getline(tokenStream, token, delimiter)) {
-		tokens.push_back(token);
+	while(!str.empty() && str[0] == ' ') {
+		str.remove_prefix(1);
+	}
+
+	int base = 10;
+	if(!str.empty() && str[0] == '$') {
+		str.remove_prefix(1);
+		base = 16;
 	}
-	return tokens;
+
+	return !str.empty() && std::from_chars(str.data(), str.data() + str.size(), value, base).ec == std::errc();
+}
+
+static uint32_t ReadBigEndian(const uint8_t* data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static void WriteBigEndian(uint8_t* out, uint32_t value)
+{
+	out[0] = (uint8_t)(value >> 24);
+	out[1] = (uint8_t)(value >> 16);
+	out[2] = (uint8_t)(value >> 8);
+	out[3] = (uint8_t)value;
 }
 
 EmuNwaConnection::EmuNwaConnection(EmuNwaServer* server, Emulator *emu, unique_ptr<Socket> socket)
@@ -50,24 +97,52 @@ EmuNwaConnection::EmuNwaConnection(EmuNwaServer* server, Emulator *emu, unique_p
 	_emu = emu;
 	_socket = std::move(socket);
 	_connectionId = server->GetNextConnectionId();
+	_server->AcquireReadBuffer(_readBuffer);
+	_stats = server->GetStats();
+	_stats->ConnectionCount++;
+	_pendingCommandIndex = _stats->GetCommandIndex("");
 	MessageManager::DisplayMessage("EmuNwa", "Client connected");
 }
 
 EmuNwaConnection::~EmuNwaConnection()
 {
 	MessageManager::DisplayMessage("EmuNwa", "Client disconnected");
+	_server->AddWatchCount(-(int32_t)_watches.size());
+	_server->ReleaseReadBuffer(_readBuffer);
+	_stats->ConnectionCount--;
 	Disconnect();
 }
 
 void EmuNwaConnection::ReadSocket()
 {
+	if(_readPosition == _readBuffer.size() && _readBuffer.size() < EmuNwaConnection::MaxMsgLength) {
+		//Buffer is full and only contains an incomplete message, make room for the rest of it
+		_readBuffer.resize(std::min(_readBuffer.size() * 2, EmuNwaConnection::MaxMsgLength));
+	}
+
 	auto lock = _socketLock.AcquireSafe();
-	int bytesReceived = _socket->Recv((char*)_readBuffer + _readPosition, (int)(EmuNwaConnection::MaxMsgLength - _readPosition), 0);
+	int bytesReceived = _socket->Recv((char*)_readBuffer.data() + _readPosition, (int)(_readBuffer.size() - _readPosition), 0);
 	if(bytesReceived > 0) {
 		_readPosition += (size_t)bytesReceived;
+		_receiveTime = std::chrono::steady_clock::now();
 	}
 }
 
+EmulatorLock EmuNwaConnection::AcquireEmulatorLock()
+{
+	//Measures how long the request waited for the emulation thread to reach the end of the frame
+	EmuNwaStopwatch stopwatch(_requestLockWaitNs);
+	return _emu->AcquireLock();
+}
+
+void EmuNwaConnection::RecordRequest(uint32_t commandIndex, uint64_t bytesIn, uint64_t handlerNs)
+{
+	uint64_t latencyNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _receiveTime).count();
+	_stats->Record(commandIndex, bytesIn, _requestBytesOut, _requestLockWaitNs, handlerNs, latencyNs);
+	_requestBytesOut = 0;
+	_requestLockWaitNs = 0;
+}
+
 bool EmuNwaConnection::ConnectionError()
 {
 	return _socket->ConnectionError();
@@ -79,162 +154,214 @@ void EmuNwaConnection::Disconnect()
 	_socket->Close();
 }
 
-void EmuNwaConnection::ProcessMessages()
+void EmuNwaConnection::ProcessMessages(bool readable)
 {
-	ReadSocket();
+	if(readable) {
+		ReadSocket();
+	}
+
+	//Messages are parsed in place, any incomplete message is moved back to the start of the buffer at the end
+	size_t position = 0;
+	uint32_t messageCount = 0;
+	_hasPendingMessages = false;
+	while(position < _readPosition && !ConnectionError()) {
+		if(messageCount == EmuNwaConnection::MaxMessagesPerTurn || !CanReceive()) {
+			//Let the other clients go first, the remaining messages are processed on the next turn
+			_hasPendingMessages = true;
+			break;
+		}
+
+		uint8_t* data = _readBuffer.data() + position;
+		size_t length = _readPosition - position;
 
-	while(_readPosition > 0) {
-		if(_readBuffer[0] == '\0') {
+		if(data[0] == '\0') {
 			// Binary Message Handling:
-			if(_readPosition < 5) {
+			if(length < 5) {
 				// Not enough data for size prefix, wait for more
 				break;
 			}
 
 			// Get message size from the next 4 bytes
-			uint32_t messageSize = ntohl(*reinterpret_cast<uint32_t*>(_readBuffer + 1));
+			uint32_t messageSize = ReadBigEndian(data + 1);
 
-			if(_readPosition < messageSize + 5) {
+			if(messageSize > EmuNwaConnection::MaxMsgLength - 5) {
+				SendError("protocol_error", "Binary message is too large.");
+				Disconnect();
+				return;
+			}
+
+			if(length < messageSize + 5) {
 				// Not enough data for the entire message, wait for more
+				if(_readBuffer.size() < messageSize + 5) {
+					//The size is known, grow the buffer once instead of doubling it repeatedly
+					memmove(_readBuffer.data(), data, length);
+					_readPosition = length;
+					position = 0;
+					_readBuffer.resize(messageSize + 5);
+					return;
+				}
 				break;
 			}
 
-			// Extract the binary data
-			std::vector<uint8_t> messageData(_readBuffer + 5, _readBuffer + 5 + messageSize);
-
-			// Process the binary message
-			HandleBinaryMessage(messageData);
-
-			// Adjust read buffer position
-			_readPosition -= messageSize + 5;
-			memmove(_readBuffer, _readBuffer + messageSize + 5, _readPosition);
-
+			uint64_t handlerNs = 0;
+			{
+				EmuNwaStopwatch stopwatch(handlerNs);
+				HandleBinaryMessage(data + 5, messageSize);
+			}
+			RecordRequest(_pendingCommandIndex, _pendingBytesIn + messageSize + 5, _pendingHandlerNs + handlerNs);
+			_pendingCommandIndex = _stats->GetCommandIndex("");
+			_pendingBytesIn = 0;
+			_pendingHandlerNs = 0;
+			position += messageSize + 5;
 		} else {
 			// ASCII Message Handling:
-			char* newLinePtr = (char*)memchr(_readBuffer, '\n', _readPosition);
-			if(newLinePtr != nullptr) {
-				// Copy the message to a new buffer
-				int messageLength = newLinePtr - (char*)_readBuffer;
-				char* messageBuffer = new char[messageLength + 1];
-				memcpy(messageBuffer, _readBuffer, messageLength);
-				messageBuffer[messageLength] = '\0';
-
-				// Process the message
-				HandleMessage(messageBuffer);
-
-				// Free the allocated message buffer
-				delete[] messageBuffer;
+			uint8_t* newLinePtr = (uint8_t*)memchr(data, '\n', length);
+			if(newLinePtr == nullptr) {
+				// No complete ASCII message yet, wait for more data
+				break;
+			}
 
-				// Move the rest of the buffer to the beginning of _readBuffer
-				size_t remainingLength = _readPosition - messageLength - 1;
-				memmove(_readBuffer, newLinePtr + 1, remainingLength);
-				_readPosition = remainingLength;
+			size_t messageLength = newLinePtr - data;
+			std::string_view message((char*)data, messageLength);
+			uint64_t handlerNs = 0;
+			{
+				EmuNwaStopwatch stopwatch(handlerNs);
+				HandleMessage(message);
+			}
 
+			uint32_t commandIndex = _stats->GetCommandIndex(message.substr(0, message.find(' ')));
+			if(_binaryMessageType != BinaryMessageType::INVALID) {
+				//Wait for the binary block before recording the request
+				_pendingCommandIndex = commandIndex;
+				_pendingBytesIn = messageLength + 1;
+				_pendingHandlerNs = handlerNs;
 			} else {
-				// No complete ASCII message yet, wait for more data
-				break;
+				RecordRequest(commandIndex, messageLength + 1, handlerNs);
 			}
+			position += messageLength + 1;
+		}
+		messageCount++;
+	}
+
+	if(position > 0) {
+		_readPosition -= position;
+		memmove(_readBuffer.data(), _readBuffer.data() + position, _readPosition);
+		if(_readPosition == 0 && _readBuffer.size() > EmuNwaServer::ReadBufferSize) {
+			//Done with the large message, give the memory back
+			_server->ReleaseReadBuffer(_readBuffer);
+			_server->AcquireReadBuffer(_readBuffer);
 		}
+	} else if(_readPosition == EmuNwaConnection::MaxMsgLength) {
+		SendError("protocol_error", "Message is too large.");
+		Disconnect();
 	}
 }
 
-void EmuNwaConnection::HandleMessage(const char* message)
+void EmuNwaConnection::HandleMessage(std::string_view message)
 {
-	// Parse the incoming message
-	std::string messageStr(message);
-	std::istringstream iss(messageStr);
-	std::string command;
-	std::string argumentsStr;
-	std::getline(iss, command, ' ');
-	std::getline(iss, argumentsStr); 
-
-	// Split the arguments
-	std::vector<std::string> arguments = split(argumentsStr, ';');
-
-	// Convert the command to lowercase for case-insensitive comparison
-	command = toLower(command);
-
-	// Handle commands
-	if(command == "my_name_is") {
+	// Parse the incoming message (arguments are views into the read buffer)
+	size_t separator = message.find(' ');
+	std::string_view command = message.substr(0, separator);
+	SplitArguments(separator == std::string_view::npos ? std::string_view() : message.substr(separator + 1), _arguments);
+	vector<std::string_view>& arguments = _arguments;
+
+	// Handle commands (case-insensitive) - CORE_READ is by far the most frequent command, check it first
+	if(EqualsIgnoreCase(command, "core_read")) {
+		if(arguments.size() < 1) {
+			SendError("invalid_argument", "CORE_READ requires at least a memory name.");
+			return;
+		}
+		HandleCoreRead(arguments);
+	} else if(EqualsIgnoreCase(command, "my_name_is")) {
 		if(arguments.size() == 0)
 		{
 			SendError("invalid_argument", "MY_NAME_IS requires a name argument");
 			return;
 		}
 		HandleMyNameIs(arguments[0]);
-	} else if(command == "emulator_info") {
+	} else if(EqualsIgnoreCase(command, "emulator_info")) {
 		HandleEmulatorInfo();
-	} else if(command == "emulation_status") {
+	} else if(EqualsIgnoreCase(command, "emulation_status")) {
 		HandleEmulationStatus();
-	} else if(command == "game_info") {
+	} else if(EqualsIgnoreCase(command, "game_info")) {
 		HandleGameInfo();
-	} else if(command == "cores_list") {
+	} else if(EqualsIgnoreCase(command, "cores_list")) {
 		HandleCoresList(arguments.size() > 0 ? arguments[0] : "");
-	} else if(command == "core_memories") {
+	} else if(EqualsIgnoreCase(command, "core_memories")) {
 		HandleCoreMemories();
-	} else if(command == "core_info") {
+	} else if(EqualsIgnoreCase(command, "core_info")) {
 		if(arguments.size() == 0) {
 			SendError("invalid_argument", "CORE_INFO requires a core name argument");
 			return;
 		}
 		HandleCoreInfo(arguments[0]);
-	} else if(command == "core_current_info") {
+	} else if(EqualsIgnoreCase(command, "core_current_info")) {
 		HandleCoreCurrentInfo();
-	} else if(command == "core_reset" || command == "emulation_reset") {
+	} else if(EqualsIgnoreCase(command, "core_reset") || EqualsIgnoreCase(command, "emulation_reset")) {
 		HandleCoreReset();
-	} else if(command == "emulation_stop") {
+	} else if(EqualsIgnoreCase(command, "emulation_stop")) {
 		HandleEmulationStop();
-	} else if(command == "emulation_pause") {
+	} else if(EqualsIgnoreCase(command, "emulation_pause")) {
 		HandleEmulationPause();
-	} else if(command == "emulation_resume") {
+	} else if(EqualsIgnoreCase(command, "emulation_resume")) {
 		HandleEmulationResume();
-	} else if(command == "emulation_reload") {
+	} else if(EqualsIgnoreCase(command, "emulation_reload")) {
 		HandleEmulationReload();
-	} else if(command == "debug_break") {
+	} else if(EqualsIgnoreCase(command, "debug_break")) {
 		HandleDebugBreak();
-	} else if(command == "debug_resume") {
+	} else if(EqualsIgnoreCase(command, "debug_resume")) {
 		HandleDebugResume();
-	} else if(command == "core_read") {		
-		if(arguments.size() < 1) {
-			SendError("invalid_argument", "CORE_READ requires at least a memory name.");
-			return;
-		}
-		std::string memoryName = arguments[0];
-		arguments.erase(arguments.begin()); // Remove memory name from arguments
-		HandleCoreRead(memoryName, arguments);
-	} else if(command == "bcore_write") {
+	} else if(EqualsIgnoreCase(command, "memory_subscribe")) {
+		HandleMemorySubscribe(arguments);
+	} else if(EqualsIgnoreCase(command, "memory_unsubscribe")) {
+		HandleMemoryUnsubscribe(arguments);
+	} else if(EqualsIgnoreCase(command, "snapshot_add")) {
+		HandleSnapshotAdd(arguments);
+	} else if(EqualsIgnoreCase(command, "snapshot_clear")) {
+		HandleSnapshotClear();
+	} else if(EqualsIgnoreCase(command, "snapshot_read")) {
+		HandleSnapshotRead(arguments);
+	} else if(EqualsIgnoreCase(command, "snapshot_share")) {
+		HandleSnapshotShare();
+	} else if(EqualsIgnoreCase(command, "server_stats")) {
+		HandleServerStats(arguments);
+	} else if(EqualsIgnoreCase(command, "bcore_write")) {
 		if(arguments.size() < 1) {
 			SendError("invalid_argument", "bCORE_WRITE requires at least a memory name.");
 			return;
 		}
+		//The read buffer is reused for the binary message, keep a copy of the arguments until it arrives
 		_binaryMessageType = BinaryMessageType::CORE_WRITE;
-		_binaryMessageArguments = arguments;
+		_binaryMessageArguments.assign(message.substr(separator + 1));
+	} else if(EqualsIgnoreCase(command, "bcore_batch")) {
+		_binaryMessageType = BinaryMessageType::CORE_BATCH;
 	} else {
 		SendError("invalid_command", "Unknown command");
 	}
 }
 
-void EmuNwaConnection::HandleBinaryMessage(const std::vector<uint8_t>& messageData)
+void EmuNwaConnection::HandleBinaryMessage(const uint8_t* data, uint32_t size)
 {
 	if(_binaryMessageType == BinaryMessageType::CORE_WRITE) {
-		if(_binaryMessageArguments.size() < 1) {
+		_binaryMessageType = BinaryMessageType::INVALID;
+		SplitArguments(_binaryMessageArguments, _arguments);
+		if(_arguments.size() < 1) {
 			SendError("protocol_error", "bCORE_WRITE requires at least a memory name.");
 			return;
 		}
-		std::vector<std::string> arguments(_binaryMessageArguments.begin() + 1, _binaryMessageArguments.end());
-		HandleCoreWrite(_binaryMessageArguments[0], arguments, messageData);
+		HandleCoreWrite(_arguments, data, size);
+	} else if(_binaryMessageType == BinaryMessageType::CORE_BATCH) {
 		_binaryMessageType = BinaryMessageType::INVALID;
+		HandleCoreBatch(data, size);
 	} else {
-		  SendError("protocol_error", "Unknown binary command");
-		  Disconnect();
+		SendError("protocol_error", "Unknown binary command");
+		Disconnect();
 	}
-
-	SendResponse("\n\n");
 }
 
-void EmuNwaConnection::HandleMyNameIs(const std::string& clientName)
+void EmuNwaConnection::HandleMyNameIs(std::string_view clientName)
 {
-	_clientName = clientName;
+	_clientName = std::string(clientName);
 	MessageManager::DisplayMessage("EmuNwa", "Client set the name to: " + _clientName);
 
 	// Send success response
@@ -247,7 +374,7 @@ void EmuNwaConnection::HandleEmulatorInfo()
 	std::string version = "2.0";
 	std::string nwaVersion = "1.0";
 	std::string id = std::to_string(_connectionId);
-	std::string commands = "EMULATOR_INFO,EMULATION_STATUS,CORES_LIST,CORE_MEMORIES,CORE_INFO,CORE_CURRENT_INFO,MY_NAME_IS,CORE_READ,bCORE_WRITE,CORE_RESET,EMULATION_PAUSE,EMULATION_STOP,EMULATION_RESET,EMULATION_RESUME,EMULATION_RELOAD";
+	std::string commands = "EMULATOR_INFO,EMULATION_STATUS,CORES_LIST,CORE_MEMORIES,CORE_INFO,CORE_CURRENT_INFO,MY_NAME_IS,CORE_READ,bCORE_WRITE,bCORE_BATCH,CORE_RESET,EMULATION_PAUSE,EMULATION_STOP,EMULATION_RESET,EMULATION_RESUME,EMULATION_RELOAD,MEMORY_SUBSCRIBE,MEMORY_UNSUBSCRIBE,SNAPSHOT_ADD,SNAPSHOT_CLEAR,SNAPSHOT_READ,SNAPSHOT_SHARE,SERVER_STATS";
 
 	// Send the response
 	SendResponse(
@@ -325,7 +452,7 @@ void EmuNwaConnection::HandleGameInfo()
 
 void EmuNwaConnection::HandleDebugBreak()
 {
-	_emu->BreakIfDebugging(CpuType::Snes, BreakSource::Breakpoint);
+	_emu->BreakIfDebugging(_emu->GetCpuTypes()[0], BreakSource::Breakpoint);
 	SendResponse("\n\n");
 }
 
@@ -346,7 +473,7 @@ void EmuNwaConnection::HandleDebugResume()
  */
 void EmuNwaConnection::HandleSaveState(const std::string& fileName)
 {
-	auto lock = _emu->AcquireLock();
+	auto lock = AcquireEmulatorLock();
 	SaveStateManager* manager = _emu->GetSaveStateManager();
 	manager->SaveState(GetStateFilepath(fileName), true);
 	SendResponse("\n\n");
@@ -354,7 +481,7 @@ void EmuNwaConnection::HandleSaveState(const std::string& fileName)
 
 void EmuNwaConnection::HandleLoadState(const std::string& fileName)
 {
-	auto lock = _emu->AcquireLock();
+	auto lock = AcquireEmulatorLock();
 	SaveStateManager* manager = _emu->GetSaveStateManager();
 	manager->LoadState(GetStateFilepath(fileName), true);
 	SendResponse("\n\n");
@@ -369,352 +496,743 @@ string EmuNwaConnection::GetStateFilepath(const std::string& filePath)
 	return FolderUtilities::CombinePath(folder, filename);
 }
 
-void EmuNwaConnection::HandleCoresList(const std::string& platform)
+void EmuNwaConnection::HandleCoresList(std::string_view platform)
 {
+	size_t coreCount;
+	const EmuNwaCoreInfo* cores = EmuNwaMemoryRegistry::GetCores(coreCount);
 
-	// List of supported cores and their platforms
-	// Only support SNES for now
-	std::vector<std::pair<std::string, std::string>> cores = {
-		//{"NesCore", "NES"},
-		{"SnesCore", "SNES"},
-		//{"GbaCore", "GBA"},
-		//{"GbcCore", "GBC"},
-		//{"PceCore", "PCE"},
-		//{"SmsCore", "SMS"},
-	};
-
-	// Send the response
 	std::string response = "\n";
-	for(auto& core : cores) {		
-		
-		if(!platform.empty() && core.second != platform) {
+	for(size_t i = 0; i < coreCount; i++) {
+		if(!platform.empty() && platform != cores[i].Platform) {
 			continue;
 		}
 
-		response += "name:" + core.first + "\n";
-		response += "platform:" + core.second + "\n";
+		response += "name:" + std::string(cores[i].Name) + "\n";
+		response += "platform:" + std::string(cores[i].Platform) + "\n";
 	}
 	response += "\n";
 
 	SendResponse(response);
-
 }
-
 void EmuNwaConnection::HandleCoreMemories()
 {
-	std::map<MemoryType, std::string> memoryTypes = {
-		{MemoryType::SnesPrgRom, "CARTROM"},
-		{MemoryType::SnesSaveRam, "SRAM"},
-		{MemoryType::SnesWorkRam, "WRAM"},
-		{MemoryType::SnesVideoRam, "VRAM"},
-		{MemoryType::SnesSpriteRam, "OAM"},
-		{MemoryType::SnesCgRam, "CGRAM"},
-		{MemoryType::SnesMemory, "CPUBUS"},
-		{MemoryType::SpcMemory, "APUBUS"},
-	};
-
 	std::string response = "\n";
-	for(auto& memoryType : memoryTypes) {
-		int memory_size = _emu->GetMemory(memoryType.first).Size;
-		
-		if(memoryType.second == "CPUBUS") {
-			memory_size = 0x1000000;
-		} else if(memoryType.second == "APUBUS") {
-			memory_size = 0x10000;
-		}
-
-		std::string memory_size_str = std::to_string(memory_size);
+	const EmuNwaCoreInfo* core = EmuNwaMemoryRegistry::GetCore(_emu->GetConsoleType());
+	if(core && _emu->IsRunning()) {
+		for(size_t i = 0; i < core->MemoryCount; i++) {
+			const EmuNwaMemoryInfo& info = core->Memories[i];
+			uint32_t memorySize = info.BusSize ? info.BusSize : _emu->GetMemory(info.Type).Size;
+			if(memorySize == 0) {
+				// Skip memories the loaded game doesn't have (e.g CHR RAM on a cart with CHR ROM)
+				continue;
+			}
 
-		response += "name:" + memoryType.second + "\n";
-		response += "access:rw\n";
-		response += "size:" + memory_size_str + "\n";
+			response += "name:" + std::string(info.Name) + "\n";
+			response += "access:rw\n";
+			response += "size:" + std::to_string(memorySize) + "\n";
+		}
 	}
 
 	response += "\n";
 
 	SendResponse(response);
 }
-
-void EmuNwaConnection::HandleCoreInfo(const std::string& coreName)
+void EmuNwaConnection::HandleCoreInfo(std::string_view coreName)
 {
-	// Only support SNES for now
-	if(coreName != "SnesCore") {
+	const EmuNwaCoreInfo* core = EmuNwaMemoryRegistry::FindCore(coreName);
+	if(!core) {
 		SendError("invalid_argument", "Invalid core name");
 		return;
 	}
 
-	// Send the response
 	SendResponse(
-		 "\n"
-		 "platform:SNES\n"
-		 "name:SnesCore\n"
-		 "version:2.0\n"
-		 "file:Mesen.exe\n"
-		 "\n"
+		"\nplatform:" + std::string(core->Platform) +
+		"\nname:" + std::string(core->Name) +
+		"\nversion:2.0"
+		"\nfile:Mesen.exe"
+		"\n\n"
 	);
 }
-
 void EmuNwaConnection::HandleCoreCurrentInfo()
 {
-	if(_emu->GetConsoleType() != ConsoleType::Snes) {
+	const EmuNwaCoreInfo* core = _emu->IsRunning() ? EmuNwaMemoryRegistry::GetCore(_emu->GetConsoleType()) : nullptr;
+	if(!core) {
 		SendError("not_allowed", "Unsupported core loaded");
 		return;
 	}
-	else 
-	{
-		HandleCoreInfo("SnesCore");
+
+	HandleCoreInfo(core->Name);
+}
+bool EmuNwaConnection::ParseRanges(const vector<std::string_view>& arguments, size_t memorySize, size_t dataSize, bool forWrite)
+{
+	// arguments[0] is the memory name, followed by offset/size pairs
+	size_t argCount = arguments.size() - 1;
+	if(argCount > 1 && argCount % 2 != 0) {
+		SendError("invalid_argument", "Invalid number of arguments.");
+		return false;
+	}
+
+	_ranges.clear();
+	size_t pairCount = argCount <= 1 ? 1 : argCount / 2;
+	size_t dataOffset = 0;
+	for(size_t i = 0; i < pairCount; i++) {
+		// Offset defaults to 0, size defaults to the rest of the memory (or all the data, for writes)
+		std::string_view offsetStr = argCount > i * 2 ? arguments[1 + i * 2] : "0";
+		std::string_view sizeStr = argCount > i * 2 + 1 ? arguments[2 + i * 2] : "";
+
+		size_t offset = 0;
+		if(!TryParseNumber(offsetStr, offset)) {
+			SendError("invalid_argument", "Invalid offset: " + std::string(offsetStr));
+			return false;
+		}
+
+		size_t size = 0;
+		if(sizeStr.empty()) {
+			size = forWrite ? dataSize : memorySize - offset;
+		} else if(!TryParseNumber(sizeStr, size)) {
+			SendError("invalid_argument", "Invalid size: " + std::string(sizeStr));
+			return false;
+		}
+
+		//Compared against the remaining space, offset + size could wrap around
+		if(offset >= memorySize || size > memorySize - offset || size > UINT32_MAX) {
+			SendError("invalid_argument", forWrite ? "Memory write out of bounds." : "Memory read out of bounds.");
+			return false;
+		}
+
+		if(forWrite && size > dataSize - dataOffset) {
+			SendError("protocol_error", "Insufficient data received for bCORE_WRITE.");
+			return false;
+		}
+
+		_ranges.push_back({ (uint32_t)offset, (uint32_t)size });
+		dataOffset += size;
 	}
+
+	return true;
 }
 
-void EmuNwaConnection::HandleCoreRead(const std::string& memoryName, const std::vector<std::string>& arguments)
+bool EmuNwaConnection::AccessBus(MemoryType memoryType, uint8_t* buffer, bool forWrite)
 {
+	// Reads/writes each range through the bus (must be called with the emulator locked)
+	for(std::pair<uint32_t, uint32_t>& range : _ranges) {
+		if(!EmuNwaMemoryRegistry::AccessBus(_emu, memoryType, range.first, range.second, buffer, forWrite)) {
+			return false;
+		}
+		buffer += range.second;
+	}
+	return true;
+}
+void EmuNwaConnection::HandleCoreRead(const vector<std::string_view>& arguments)
+{
+	const EmuNwaMemoryInfo* info = FindMemory(_emu, arguments[0]);
+	if(!info) {
+		SendError("invalid_argument", "Invalid memory name: " + std::string(arguments[0]));
+		return;
+	}
 
-	std::map<std::string, MemoryType> memoryTypes = {
-		{"CARTROM", MemoryType::SnesPrgRom},
-		{"SRAM", MemoryType::SnesSaveRam},
-		{"WRAM", MemoryType::SnesWorkRam},
-		{"VRAM", MemoryType::SnesVideoRam},
-		{"OAM", MemoryType::SnesSpriteRam},
-		{"CGRAM", MemoryType::SnesCgRam},
-		{"CPUBUS", MemoryType::SnesMemory},
-		{"APUBUS", MemoryType::SpcMemory},
-	};
+	ConsoleMemoryInfo memory = _emu->GetMemory(info->Type);
+	size_t memorySize = info->BusSize ? info->BusSize : memory.Size;
+	if(!ParseRanges(arguments, memorySize, 0, false)) {
+		return;
+	}
 
-	ConsoleMemoryInfo memory = _emu->GetMemory(memoryTypes[memoryName]);
+	size_t totalSize = 0;
+	for(std::pair<uint32_t, uint32_t>& range : _ranges) {
+		totalSize += range.second;
+	}
+	if(totalSize > EmuNwaConnection::MaxReadLength) {
+		SendError("invalid_argument", "Memory read is too large.");
+		return;
+	}
 
+	if(info->BusSize) {
+		// Bus reads have to go through the console's memory mappings, copy them to the reply buffer
+		_replyBuffer.resize(totalSize);
 
-	std::vector<uint8_t> readData;
-	size_t memory_size = memory.Size;
-	
-	if(memoryName == "CPUBUS")
-	{
-		memory_size = 0x1000000;
+		bool result;
+		{
+			auto lock = AcquireEmulatorLock();
+			result = AccessBus(info->Type, _replyBuffer.data(), false);
+		}
+
+		if(result) {
+			SendBinaryMessage(_replyBuffer.data(), (uint32_t)totalSize);
+		} else {
+			SendError("not_allowed", "Memory is not available: " + std::string(arguments[0]));
+		}
+		return;
 	}
-	else if(memoryName == "APUBUS") 
-	{
-		memory_size = 0x10000;	
+
+	if(!memory.Memory) {
+		SendError("not_allowed", "Memory is not available: " + std::string(arguments[0]));
+		return;
 	}
 
-	std::vector<std::string> addressPairs(arguments);
+	auto lock = AcquireEmulatorLock();
 
-	if(addressPairs.empty()) {
-		addressPairs.push_back("0");
-		addressPairs.push_back("");
-	}
-	else if (addressPairs.size() == 1) {
-		addressPairs.push_back("");
+	// Send the header and each range straight from the emulator's memory, while the emulator is still paused
+	_sendBuffers.clear();
+	_sendBuffers.push_back({ _binaryHeader, sizeof(_binaryHeader) });
+	for(std::pair<uint32_t, uint32_t>& range : _ranges) {
+		_sendBuffers.push_back({ (uint8_t*)memory.Memory + range.first, range.second });
 	}
-	else if(addressPairs.size() % 2 != 0) {
-		SendError("invalid_argument", "Invalid number of arguments.");
+	SendBinaryMessage((uint32_t)totalSize);
+}
+
+void EmuNwaConnection::HandleCoreWrite(const vector<std::string_view>& arguments, const uint8_t* data, uint32_t dataSize)
+{
+	const EmuNwaMemoryInfo* info = FindMemory(_emu, arguments[0]);
+	if(!info) {
+		SendError("invalid_argument", "Invalid memory name: " + std::string(arguments[0]));
 		return;
 	}
 
-	auto lock = _emu->AcquireLock();
+	ConsoleMemoryInfo memory = _emu->GetMemory(info->Type);
+	size_t memorySize = info->BusSize ? info->BusSize : memory.Size;
 
-	// 2. Process Each Offset/Size Pair:
-	for(size_t i = 0; i < addressPairs.size(); i += 2) {
-		const std::string& offsetStr = addressPairs[i];
-		const std::string& sizeStr = addressPairs[i + 1];
+	// All ranges are validated before anything is written
+	if(!ParseRanges(arguments, memorySize, dataSize, true)) {
+		return;
+	}
 
-		size_t offset = 0;
-		try 
-		{
-			if(offsetStr[0] == '$') 
-			{
-				offset = std::stoul(offsetStr.c_str() + 1, nullptr, 16); // Hexadecimal
-			} else {
-				offset = std::stoul(offsetStr, nullptr, 10); // Decimal
-			}
-      }
-		catch(const std::exception&) 
+	if(info->BusSize) {
+		bool result;
 		{
-			SendError("invalid_argument", "Invalid offset: " + offsetStr);
+			auto lock = AcquireEmulatorLock();
+			result = AccessBus(info->Type, const_cast<uint8_t*>(data), true);
+		}
+
+		if(result) {
+			SendResponse("\n\n");
+		} else {
+			SendError("not_allowed", "Memory is not available: " + std::string(arguments[0]));
+		}
+		return;
+	}
+
+	if(!memory.Memory) {
+		SendError("not_allowed", "Memory is not available: " + std::string(arguments[0]));
+		return;
+	}
+
+	{
+		auto lock = AcquireEmulatorLock();
+		for(std::pair<uint32_t, uint32_t>& range : _ranges) {
+			memcpy((uint8_t*)memory.Memory + range.first, data, range.second);
+			data += range.second;
+		}
+	}
+
+	SendResponse("\n\n");
+}
+
+/*
+ * bCORE_BATCH
+ * Followed by a binary block containing any number of operations, each encoded as:
+ *   [type: 1 byte, 0 = read, 1 = write][name length: 1 byte][memory name][offset: 4 bytes][size: 4 bytes][data: <size> bytes, writes only]
+ * (offsets and sizes are big endian)
+ * All operations are validated first, and then executed in order with the emulator locked once (i.e between two frames).
+ * The reply is a single binary block containing the data of every read operation, in order.
+ */
+void EmuNwaConnection::HandleCoreBatch(const uint8_t* data, uint32_t dataSize)
+{
+	_batchOperations.clear();
+	ConsoleType consoleType = _emu->GetConsoleType();
+	uint32_t readSize = 0;
+	uint32_t position = 0;
+	while(position < dataSize) {
+		uint32_t index = (uint32_t)_batchOperations.size();
+		if(dataSize - position < 2 || dataSize - position - 2 < (uint32_t)data[position + 1] + 8) {
+			SendError("protocol_error", "Truncated bCORE_BATCH operation #" + std::to_string(index));
 			return;
 		}
 
-		// Parse size:
-		size_t size = 0;
-		if(sizeStr.empty()) {
-			size = memory_size - offset; // Read to end of memory
+		bool forWrite = data[position] != 0;
+		std::string_view name((const char*)data + position + 2, data[position + 1]);
+		position += 2 + (uint32_t)name.size();
+		uint32_t offset = ReadBigEndian(data + position);
+		uint32_t size = ReadBigEndian(data + position + 4);
+		position += 8;
+
+		const EmuNwaMemoryInfo* info = FindMemory(_emu, name);
+		if(!info) {
+			SendError("invalid_argument", "Invalid memory name: " + std::string(name));
+			return;
+		}
+
+		const uint8_t* writeData = nullptr;
+		if(forWrite) {
+			if(size > dataSize - position) {
+				SendError("protocol_error", "Insufficient data received for bCORE_BATCH operation #" + std::to_string(index));
+				return;
+			}
+			writeData = data + position;
+			position += size;
 		} else {
-			try {
-				if(sizeStr[0] == '$') {
-					size = std::stoul(sizeStr.c_str() + 1, nullptr, 16); // Hexadecimal
+			readSize += size;
+			if(readSize > EmuNwaConnection::MaxMsgLength) {
+				SendError("invalid_argument", "bCORE_BATCH reply is too large.");
+				return;
+			}
+		}
+
+		_batchOperations.push_back({ info, offset, size, writeData });
+	}
+
+	_replyBuffer.resize(readSize);
+
+	{
+		auto lock = AcquireEmulatorLock();
+
+		//Bounds are checked with the emulator locked, so a game can't be loaded between the checks and the accesses
+		if(!_emu->IsRunning() || _emu->GetConsoleType() != consoleType) {
+			SendError("not_allowed", "The loaded game changed while processing bCORE_BATCH.");
+			return;
+		}
+
+		for(size_t i = 0; i < _batchOperations.size(); i++) {
+			EmuNwaBatchOperation& op = _batchOperations[i];
+			size_t memorySize = op.Memory->BusSize ? op.Memory->BusSize : _emu->GetMemory(op.Memory->Type).Size;
+			if((size_t)op.Offset + op.Size > memorySize || (!op.Memory->BusSize && !_emu->GetMemory(op.Memory->Type).Memory)) {
+				SendError("invalid_argument", "Memory access out of bounds for bCORE_BATCH operation #" + std::to_string(i));
+				return;
+			}
+		}
+
+		uint8_t* out = _replyBuffer.data();
+		for(EmuNwaBatchOperation& op : _batchOperations) {
+			if(op.Memory->BusSize) {
+				uint8_t* buffer = op.WriteData ? const_cast<uint8_t*>(op.WriteData) : out;
+				if(!EmuNwaMemoryRegistry::AccessBus(_emu, op.Memory->Type, op.Offset, op.Size, buffer, op.WriteData != nullptr)) {
+					SendError("not_allowed", "Memory is not available: " + std::string(op.Memory->Name));
+					return;
+				}
+			} else {
+				uint8_t* memory = (uint8_t*)_emu->GetMemory(op.Memory->Type).Memory + op.Offset;
+				if(op.WriteData) {
+					memcpy(memory, op.WriteData, op.Size);
 				} else {
-					size = std::stoul(sizeStr, nullptr, 10); // Decimal
+					memcpy(out, memory, op.Size);
 				}
 			}
-			catch(const std::exception&) 
-			{
-				SendError("invalid_argument", "Invalid size: " + sizeStr);
-				return;
+
+			if(!op.WriteData) {
+				out += op.Size;
 			}
 		}
+	}
 
-		// 3. Bounds Checking:
-		if(offset >= memory_size || (offset + size) > memory_size) {
-			SendError("invalid_argument", "Memory read out of bounds.");
+	SendBinaryMessage(_replyBuffer.data(), readSize);
+}
+
+/*
+ * MEMORY_SUBSCRIBE <memory>;<offset>;<size>
+ * Registers a range that the emulation thread compares against its previous content at the
+ * end of every frame. Replies with the watch's id. Whenever any watched byte changes, an
+ * unsolicited message is pushed to the client:
+ *   0x01, payload size (4 bytes, big endian), payload
+ * The payload starts with the frame number (4 bytes), followed by one or more entries:
+ *   watch id (2 bytes), offset in memory (4 bytes), length (2 bytes), <length> bytes of data
+ * (all values are big endian). The full range is sent once after the watch is created.
+ */
+void EmuNwaConnection::HandleMemorySubscribe(const vector<std::string_view>& arguments)
+{
+	if(arguments.size() != 3) {
+		SendError("invalid_argument", "MEMORY_SUBSCRIBE requires a memory name, an offset and a size.");
+		return;
+	}
+
+	MemoryType memoryType;
+	if(!TryGetMemoryType(_emu, arguments[0], memoryType)) {
+		SendError("invalid_argument", "Invalid memory name: " + std::string(arguments[0]));
+		return;
+	}
+
+	size_t offset = 0;
+	size_t size = 0;
+	if(!TryParseNumber(arguments[1], offset) || !TryParseNumber(arguments[2], size)) {
+		SendError("invalid_argument", "Invalid offset or size.");
+		return;
+	}
+
+	uint32_t memorySize = _emu->GetMemory(memoryType).Size;
+	if(size == 0 || size > EmuNwaConnection::MaxWatchSize || offset >= memorySize || offset + size > memorySize) {
+		SendError("invalid_argument", "Memory watch out of bounds.");
+		return;
+	}
+
+	uint32_t id;
+	{
+		auto lock = _watchLock.AcquireSafe();
+		if(_watches.size() >= EmuNwaConnection::MaxWatchCount) {
+			lock.Release();
+			SendError("not_allowed", "Too many memory watches.");
 			return;
 		}
 
+		//Ids are sent as 16-bit values in notifications, skip 0 and any id that is still in use when wrapping around
+		do {
+			id = _nextWatchId;
+			_nextWatchId = (_nextWatchId % 0xFFFF) + 1;
+		} while(std::any_of(_watches.begin(), _watches.end(), [=](const EmuNwaMemoryWatch& watch) { return watch.Id == id; }));
+
+		_watches.push_back({ id, memoryType, (uint32_t)offset, (uint32_t)size, false, vector<uint8_t>(size) });
+	}
+	_server->AddWatchCount(1);
+
+	SendResponse("\nid:" + std::to_string(id) + "\n\n");
+}
+
+void EmuNwaConnection::HandleMemoryUnsubscribe(const vector<std::string_view>& arguments)
+{
+	if(arguments.size() != 1) {
+		SendError("invalid_argument", "MEMORY_UNSUBSCRIBE requires a watch id.");
+		return;
+	}
+
+	size_t id = 0;
+	TryParseNumber(arguments[0], id);
+	bool removed = false;
+	{
+		auto lock = _watchLock.AcquireSafe();
+		for(size_t i = 0; i < _watches.size(); i++) {
+			if(_watches[i].Id == id) {
+				_watches.erase(_watches.begin() + i);
+				removed = true;
+				break;
+			}
+		}
+	}
 
-		// 4. Perform Memory Read:
-		readData.resize(readData.size() + size); // Ensure enough space
-		std::copy_n((uint8_t*)memory.Memory + offset, size, readData.data() + readData.size() - size);
+	if(!removed) {
+		SendError("invalid_argument", "Invalid watch id: " + std::string(arguments[0]));
+		return;
 	}
 
-	// 5. Send Binary Reply:
-	SendBinaryMessage(readData);
+	_server->AddWatchCount(-1);
+	SendResponse("\n\n");
 }
 
-void EmuNwaConnection::HandleCoreWrite(const std::string& memoryName,
-													const std::vector<std::string>& arguments,
-												   const std::vector<uint8_t>& data)
+/*
+ * SNAPSHOT_ADD <memory>[;<offset>;<size>]
+ * Adds a region (or a whole memory) to the snapshot that the emulation thread publishes at the end
+ * of every frame. Snapshot regions are shared by all clients, until SNAPSHOT_CLEAR is called.
+ *
+ * SNAPSHOT_READ <memory>;<offset>;<size>[;<offset>;<size>...]
+ * Same as CORE_READ, but served from the latest published snapshot without locking the emulator.
+ * The binary reply starts with the frame number (4 bytes, big endian) the data was captured on.
+ *
+ * SNAPSHOT_SHARE
+ * Exposes the snapshot in a shared memory block (see EmuNwaSharedHeader for its layout) that local clients
+ * can map, to read the regions at frame rate without sending any request. Replies with the block's name and size.
+ */
+void EmuNwaConnection::HandleSnapshotAdd(const vector<std::string_view>& arguments)
 {
-	std::map<std::string, MemoryType> memoryTypes = {
-		 {"CARTROM", MemoryType::SnesPrgRom},
-		 {"SRAM", MemoryType::SnesSaveRam},
-		 {"WRAM", MemoryType::SnesWorkRam},
-		 {"VRAM", MemoryType::SnesVideoRam},
-		 {"OAM", MemoryType::SnesSpriteRam},
-		 {"CGRAM", MemoryType::SnesCgRam},
-		 {"CPUBUS", MemoryType::SnesMemory},
-		 {"APUBUS", MemoryType::SpcMemory},
-	};
+	if(arguments.size() != 1 && arguments.size() != 3) {
+		SendError("invalid_argument", "SNAPSHOT_ADD requires a memory name, and optionally an offset and a size.");
+		return;
+	}
 
-	if(memoryTypes.find(memoryName) == memoryTypes.end()) {
-		SendError("invalid_argument", "Invalid memory name: " + memoryName);
+	const EmuNwaMemoryInfo* info = FindMemory(_emu, arguments[0]);
+	if(!info || info->BusSize) {
+		SendError("invalid_argument", "Invalid memory name: " + std::string(arguments[0]));
 		return;
 	}
 
-	ConsoleMemoryInfo memory = _emu->GetMemory(memoryTypes[memoryName]);
+	uint32_t memorySize = _emu->GetMemory(info->Type).Size;
+	size_t offset = 0;
+	size_t size = memorySize;
+	if(arguments.size() == 3 && (!TryParseNumber(arguments[1], offset) || !TryParseNumber(arguments[2], size))) {
+		SendError("invalid_argument", "Invalid offset or size.");
+		return;
+	}
 
-	size_t memory_size = memory.Size;
+	if(size == 0 || offset >= memorySize || size > memorySize - offset) {
+		SendError("invalid_argument", "Snapshot region out of bounds.");
+		return;
+	}
 
-	if(memoryName == "CPUBUS") {
-		memory_size = 0x1000000;
-	} else if(memoryName == "APUBUS") {
-		memory_size = 0x10000;
+	if(!_server->GetSnapshot()->AddRegion(info->Name, info->Type, (uint32_t)offset, (uint32_t)size)) {
+		SendError("not_allowed", "Snapshot size limit reached.");
+		return;
 	}
 
-	size_t dataOffset = 0;
+	SendResponse("\n\n");
+}
 
-	std::vector<std::string> addressPairs(arguments);
+void EmuNwaConnection::HandleSnapshotShare()
+{
+	string name;
+	uint32_t size;
+	if(!_server->GetSnapshot()->EnableSharedMemory(name, size)) {
+		SendError("not_allowed", "Could not create the shared memory block.");
+		return;
+	}
 
-	if(addressPairs.empty()) {
-		addressPairs.push_back("0");
-		addressPairs.push_back("");
-	} else if(addressPairs.size() == 1) {
-		addressPairs.push_back("");
-	} else if(addressPairs.size() % 2 != 0) {
-		SendError("invalid_argument", "Invalid number of arguments.");
+	SendResponse("\nname:" + name + "\nsize:" + std::to_string(size) + "\n\n");
+}
+
+/*
+ * SERVER_STATS [reset]
+ * Returns the number of connections, followed by the counters of each command received since the server
+ * started (requests, bytes received/sent, time spent waiting for the emulator lock and in the handler,
+ * p50/p99 latency between the request being received and its reply being sent). "reset" clears the counters.
+ */
+void EmuNwaConnection::HandleServerStats(const vector<std::string_view>& arguments)
+{
+	if(arguments.size() > 0 && EqualsIgnoreCase(arguments[0], "reset")) {
+		_stats->Reset();
+		SendResponse("\n\n");
 		return;
 	}
 
-	auto lock = _emu->AcquireLock();	
+	SendResponse(_stats->ToString());
+}
 
-	for(size_t i = 0; i < addressPairs.size(); i += 2) {
-		const std::string& offsetStr = addressPairs[i];
-		const std::string& sizeStr = addressPairs[i + 1];
+void EmuNwaConnection::HandleSnapshotClear()
+{
+	_server->GetSnapshot()->ClearRegions();
+	SendResponse("\n\n");
+}
+
+void EmuNwaConnection::HandleSnapshotRead(const vector<std::string_view>& arguments)
+{
+	if(arguments.size() < 3 || arguments.size() % 2 != 1) {
+		SendError("invalid_argument", "SNAPSHOT_READ requires a memory name and offset/size pairs.");
+		return;
+	}
 
+	MemoryType memoryType;
+	if(!TryGetMemoryType(_emu, arguments[0], memoryType)) {
+		SendError("invalid_argument", "Invalid memory name: " + std::string(arguments[0]));
+		return;
+	}
+
+	//Every range is validated against the snapshot's regions before the reply buffer is allocated
+	EmuNwaSnapshot* snapshot = _server->GetSnapshot();
+	_ranges.clear();
+	size_t totalSize = 0;
+	for(size_t i = 1; i < arguments.size(); i += 2) {
 		size_t offset = 0;
-		try 
-		{
-			if(offsetStr[0] == '$') {
-				offset = std::stoul(offsetStr.c_str() + 1, nullptr, 16); // Hexadecimal
-			} else {
-				offset = std::stoul(offsetStr, nullptr, 10); // Decimal
-			}
-		} 
-		catch(const std::exception&) 
-		{
-			SendError("invalid_argument", "Invalid offset: " + offsetStr);
+		size_t size = 0;
+		if(!TryParseNumber(arguments[i], offset) || !TryParseNumber(arguments[i + 1], size) || offset > UINT32_MAX || size > UINT32_MAX - offset) {
+			SendError("invalid_argument", "Invalid offset or size.");
+			return;
+		}
+		if(!snapshot->Contains(memoryType, (uint32_t)offset, (uint32_t)size)) {
+			SendError("invalid_argument", "Range is not part of the snapshot.");
 			return;
 		}
+		totalSize += size;
+		if(totalSize > EmuNwaConnection::MaxReadLength) {
+			SendError("invalid_argument", "Snapshot read is too large.");
+			return;
+		}
+		_ranges.push_back({ (uint32_t)offset, (uint32_t)size });
+	}
 
-		size_t size = 0;
-		if(sizeStr.empty()) {
-			size = data.size(); // Read all binary data
-		} else {
-			try 
-			{
-				if(sizeStr[0] == '$') {
-					size = std::stoul(sizeStr.c_str() + 1, nullptr, 16); // Hexadecimal
-				} else {
-					size = std::stoul(sizeStr, nullptr, 10); // Decimal
-				}
-			}
-			catch(const std::exception&)
-			{
-				SendError("invalid_argument", "Invalid size: " + sizeStr);
+	_replyBuffer.resize(4 + totalSize);
+
+	//All ranges must come from the same frame - start over if a new frame was published between reads
+	bool sameFrame;
+	uint32_t frameCount = 0;
+	do {
+		sameFrame = true;
+		uint8_t* dst = _replyBuffer.data() + 4;
+		for(size_t i = 0; i < _ranges.size(); i++) {
+			uint32_t rangeFrameCount;
+			if(!snapshot->Read(memoryType, _ranges[i].first, _ranges[i].second, dst, rangeFrameCount)) {
+				SendError("invalid_argument", "Range is not part of the snapshot, or no frame has been captured yet.");
 				return;
 			}
+
+			if(i == 0) {
+				frameCount = rangeFrameCount;
+			} else if(rangeFrameCount != frameCount) {
+				sameFrame = false;
+				break;
+			}
+			dst += _ranges[i].second;
 		}
+	} while(!sameFrame);
 
-		// Bounds Checking
-		if(offset >= memory_size || (offset + size) > memory_size) {
-			SendError("invalid_argument", "Memory write out of bounds.");
-			return;
+	WriteBigEndian(_replyBuffer.data(), frameCount);
+	SendBinaryMessage(_replyBuffer.data(), (uint32_t)_replyBuffer.size());
+}
+
+static void AppendBigEndian(vector<uint8_t>& out, uint32_t value, int byteCount)
+{
+	for(int i = byteCount - 1; i >= 0; i--) {
+		out.push_back((uint8_t)(value >> (i * 8)));
+	}
+}
+
+void EmuNwaConnection::AppendWatchChanges(EmuNwaMemoryWatch& watch, uint8_t* memory, vector<uint8_t>& out)
+{
+	//Unchanged gaps shorter than an entry header are included in the surrounding entry
+	constexpr uint32_t mergeDistance = 8;
+	constexpr uint32_t maxEntryLength = 0xFFFF;
+
+	uint8_t* snapshot = watch.Snapshot.data();
+	uint32_t i = 0;
+	while(i < watch.Size) {
+		if(watch.Initialized && memory[i] == snapshot[i]) {
+			i++;
+			continue;
 		}
 
-		// Check if enough data has been received
-		if((dataOffset + size) > data.size()) {
-			SendError("protocol_error", "Insufficient data received for bCORE_WRITE.");
-			return;
+		uint32_t start = i;
+		uint32_t end = i + 1;
+		for(uint32_t j = end; j < watch.Size && j - start < maxEntryLength && j - end < mergeDistance; j++) {
+			if(!watch.Initialized || memory[j] != snapshot[j]) {
+				end = j + 1;
+			}
 		}
 
-		// Copy the data to the memory
-		std::copy_n(data.begin() + dataOffset, size, (uint8_t*)memory.Memory + offset);
+		uint32_t length = end - start;
+		AppendBigEndian(out, watch.Id, 2);
+		AppendBigEndian(out, watch.Offset + start, 4);
+		AppendBigEndian(out, length, 2);
+		out.insert(out.end(), memory + start, memory + end);
+		memcpy(snapshot + start, memory + start, length);
+		i = end;
+	}
 
-		dataOffset += size;
+	watch.Initialized = true;
+}
+
+bool EmuNwaConnection::ProcessEndOfFrame(uint32_t frameCount)
+{
+	auto lock = _watchLock.AcquireSafe();
+	if(_watches.empty() || _pendingNotifications.size() >= EmuNwaConnection::MaxQueuedSendSize) {
+		//When the client falls behind, skip comparing until it catches up - the next notification
+		//will contain all the changes that occurred in the meantime
+		return false;
+	}
+
+	_notificationBuffer.clear();
+	AppendBigEndian(_notificationBuffer, frameCount, 4);
+
+	for(EmuNwaMemoryWatch& watch : _watches) {
+		ConsoleMemoryInfo memory = _emu->GetMemory(watch.Type);
+		if(memory.Memory == nullptr || (size_t)watch.Offset + watch.Size > memory.Size) {
+			//Memory no longer exists (e.g a different game was loaded)
+			continue;
+		}
+		AppendWatchChanges(watch, (uint8_t*)memory.Memory + watch.Offset, _notificationBuffer);
 	}
 
+	if(_notificationBuffer.size() <= 4) {
+		return false;
+	}
+
+	_pendingNotifications.push_back(EmuNwaConnection::NotificationPrefix);
+	AppendBigEndian(_pendingNotifications, (uint32_t)_notificationBuffer.size(), 4);
+	_pendingNotifications.insert(_pendingNotifications.end(), _notificationBuffer.begin(), _notificationBuffer.end());
+	return true;
 }
 
+void EmuNwaConnection::SendPendingNotifications()
+{
+	if(!CanReceive()) {
+		return;
+	}
 
-// Example helper function to send an error response
-void EmuNwaConnection::SendError(const std::string& errorType, const std::string& message)
+	{
+		auto lock = _watchLock.AcquireSafe();
+		if(_pendingNotifications.empty()) {
+			return;
+		}
+		_sendingNotifications.clear();
+		_sendingNotifications.swap(_pendingNotifications);
+	}
+
+	SocketBuffer buffer = { _sendingNotifications.data(), (uint32_t)_sendingNotifications.size() };
+	QueueSend(&buffer, 1);
+}
+
+void EmuNwaConnection::QueueSend(const SocketBuffer* buffers, int count)
 {
-	SendResponse(
-		 "\n"
-		 "error:" + errorType + "\n"
-		 "reason:" + message + "\n"
-		 "\n"
-	);
+	auto lock = _socketLock.AcquireSafe();
+
+	int sent = 0;
+	if(!HasPendingSend()) {
+		//Nothing queued, send as much as possible right away
+		sent = _socket->SendVectored(buffers, count, false);
+		if(sent < 0) {
+			_socket->Close();
+			return;
+		}
+	}
+
+	//Copy whatever could not be sent to the queue, to send it once the socket is writable again
+	for(int i = 0; i < count; i++) {
+		uint32_t skip = std::min((uint32_t)sent, buffers[i].Length);
+		sent -= (int)skip;
+		const uint8_t* data = (const uint8_t*)buffers[i].Data;
+		_sendQueue.insert(_sendQueue.end(), data + skip, data + buffers[i].Length);
+	}
 }
 
-void EmuNwaConnection::SendResponse(const std::string& response)
+void EmuNwaConnection::FlushSendQueue()
 {
 	auto lock = _socketLock.AcquireSafe();
-	int bytesSent = _socket->Send(const_cast<char*>(response.c_str()), (int)response.size(), 0);
-	if(bytesSent < 0) {
-		Disconnect();
+	if(!HasPendingSend()) {
 		return;
 	}
-}
 
-void EmuNwaConnection::SendBinaryMessage(const std::vector<uint8_t>& data)
+	SocketBuffer buffer = { _sendQueue.data() + _sendQueueOffset, (uint32_t)(_sendQueue.size() - _sendQueueOffset) };
+	int sent = _socket->SendVectored(&buffer, 1, false);
+	if(sent < 0) {
+		_socket->Close();
+		return;
+	}
+
+	_sendQueueOffset += (size_t)sent;
+	if(_sendQueueOffset == _sendQueue.size()) {
+		_sendQueue.clear();
+		_sendQueueOffset = 0;
+	} else if(_sendQueueOffset >= _sendQueue.size() / 2) {
+		_sendQueue.erase(_sendQueue.begin(), _sendQueue.begin() + _sendQueueOffset);
+		_sendQueueOffset = 0;
+	}
+}
+// Example helper function to send an error response
+void EmuNwaConnection::SendError(std::string_view errorType, std::string_view message)
 {
-	// 1. Prepare the complete message buffer
-	std::vector<uint8_t> message(data.size() + 5); // 1 byte indicator + 4 bytes size + data
+	std::string response;
+	response.reserve(20 + errorType.size() + message.size());
+	response += "\nerror:";
+	response += errorType;
+	response += "\nreason:";
+	response += message;
+	response += "\n\n";
+	SendResponse(response);
+}
 
-	// 2. Set the binary reply indicator (0x00)
-	message[0] = '\0';
+void EmuNwaConnection::SendResponse(std::string_view response)
+{
+	_requestBytesOut += response.size();
+	SocketBuffer buffer = { response.data(), (uint32_t)response.size() };
+	QueueSend(&buffer, 1);
+}
+void EmuNwaConnection::SendBinaryMessage(uint32_t size)
+{
+	// Binary reply indicator (0x00) followed by the size (in network byte order)
+	_binaryHeader[0] = '\0';
+	WriteBigEndian(_binaryHeader + 1, size);
 
-	// 3. Set the size prefix (in network byte order)
-	uint32_t size = htonl((u_long)data.size());
-	std::memcpy(&message[1], &size, sizeof(size));
+	_requestBytesOut += size + sizeof(_binaryHeader);
 
-	// 4. Copy the actual data
-	std::copy(data.begin(), data.end(), message.begin() + 5);
+	// Send the header and all of the payload's buffers with a single call
+	QueueSend(_sendBuffers.data(), (int)_sendBuffers.size());
+}
 
-	// 5. Send the entire message in one go
-	{
-		auto lock = _socketLock.AcquireSafe();
-		int bytesSent = _socket->Send(reinterpret_cast<char*>(message.data()), (int)message.size(), 0);
-		if(bytesSent < 0) {
-			Disconnect();
-			return;
-		}
-	}
+void EmuNwaConnection::SendBinaryMessage(const uint8_t* data, uint32_t size)
+{
+	_sendBuffers.clear();
+	_sendBuffers.push_back({ _binaryHeader, sizeof(_binaryHeader) });
+	_sendBuffers.push_back({ data, size });
+	SendBinaryMessage(size);
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "pch.h"
+#include <string_view>
 #include "EmuNwa/EmuNwaServer.h"
+#include "EmuNwa/EmuNwaStats.h"
 #include "Shared/Emulator.h"
 #include "Utilities/Socket.h"
 
@@ -8,6 +10,27 @@ enum BinaryMessageType
 {
 	INVALID = 0,
 	CORE_WRITE = 1,
+	CORE_BATCH = 2,
+};
+
+struct EmuNwaMemoryWatch
+{
+	uint32_t Id;
+	MemoryType Type;
+	uint32_t Offset;
+	uint32_t Size;
+	bool Initialized;
+	vector<uint8_t> Snapshot;
+};
+
+struct EmuNwaMemoryInfo;
+
+struct EmuNwaBatchOperation
+{
+	const EmuNwaMemoryInfo* Memory;
+	uint32_t Offset;
+	uint32_t Size;
+	const uint8_t* WriteData;
 };
 
 class EmuNwaConnection final
@@ -15,22 +38,73 @@ class EmuNwaConnection final
 private:
 	static constexpr size_t MaxMsgLength = 1500000;
 
+	//Largest reply CORE_READ can produce (all ranges combined) - large enough for a full SNES bus or a 32 MB GBA ROM
+	static constexpr size_t MaxReadLength = 0x2000000;
+
+	//Messages are handled in turns to keep a client that pipelines a lot of requests from delaying the others
+	static constexpr uint32_t MaxMessagesPerTurn = 16;
+
+	//Requests are no longer read from a client that has this much data waiting to be sent to it, until it catches up
+	static constexpr size_t MaxQueuedSendSize = 0x400000;
+	static constexpr uint32_t MaxWatchCount = 64;
+	static constexpr uint32_t MaxWatchSize = 0x40000;
+
+	//Prefix byte of the unsolicited messages pushed to clients with active memory watches
+	//(regular replies use '\n' for ASCII and '\0' for binary replies)
+	static constexpr uint8_t NotificationPrefix = 0x01;
+
 	EmuNwaServer* _server = nullptr;
 	Emulator* _emu = nullptr;
 	unique_ptr<Socket> _socket;
 	int _connectionId = 0;
 
-	uint8_t _readBuffer[EmuNwaConnection::MaxMsgLength] = {};
+	//Starts with a buffer from the server's pool, and grows up to MaxMsgLength for large messages
+	vector<uint8_t> _readBuffer;
 	size_t _readPosition = 0;
-	size_t _lastPosition = 0;
+	bool _hasPendingMessages = false;
 	SimpleLock _socketLock;
 
+	//Data that could not be sent yet without blocking, sent once the socket becomes writable
+	vector<uint8_t> _sendQueue;
+	size_t _sendQueueOffset = 0;
+
 	std::string _clientName;
 
+	//Stats for the request being processed (binary commands are recorded once their binary block is received)
+	EmuNwaStats* _stats = nullptr;
+	std::chrono::steady_clock::time_point _receiveTime;
+	uint64_t _requestLockWaitNs = 0;
+	uint64_t _requestBytesOut = 0;
+	uint32_t _pendingCommandIndex = 0;
+	uint64_t _pendingBytesIn = 0;
+	uint64_t _pendingHandlerNs = 0;
+
 	BinaryMessageType _binaryMessageType = BinaryMessageType::INVALID;
-	std::vector<std::string> _binaryMessageArguments;
+	std::string _binaryMessageArguments;
+
+	//Reused for every message to avoid allocations once the connection is warmed up
+	vector<std::string_view> _arguments;
+	vector<std::pair<uint32_t, uint32_t>> _ranges;
+	vector<SocketBuffer> _sendBuffers;
+	vector<uint8_t> _replyBuffer;
+	uint8_t _binaryHeader[5] = {};
+	vector<EmuNwaBatchOperation> _batchOperations;
+
+	//Watches are modified by the server thread and read by the emulation thread at the end of each frame
+	SimpleLock _watchLock;
+	vector<EmuNwaMemoryWatch> _watches;
+	vector<uint8_t> _pendingNotifications;
+	vector<uint8_t> _sendingNotifications;
+	vector<uint8_t> _notificationBuffer;
+	uint32_t _nextWatchId = 1;
 
 	void ReadSocket();
+	EmulatorLock AcquireEmulatorLock();
+	void RecordRequest(uint32_t commandIndex, uint64_t bytesIn, uint64_t handlerNs);
+	void QueueSend(const SocketBuffer* buffers, int count);
+	bool ParseRanges(const vector<std::string_view>& arguments, size_t memorySize, size_t dataSize, bool forWrite);
+	bool AccessBus(MemoryType memoryType, uint8_t* buffer, bool forWrite);
+	void AppendWatchChanges(EmuNwaMemoryWatch& watch, uint8_t* memory, vector<uint8_t>& out);
 	void Disconnect();
 
 public:
@@ -38,10 +112,20 @@ public:
 	virtual ~EmuNwaConnection();
 
 	bool ConnectionError();
-	void ProcessMessages();
-	void HandleMessage(const char* message);
-	void HandleBinaryMessage(const std::vector<uint8_t>& messageData);
-	void HandleMyNameIs(const std::string& clientName);
+	Socket* GetSocket() { return _socket.get(); }
+
+	//False while the client isn't reading its replies fast enough (backpressure)
+	bool CanReceive() { return _sendQueue.size() - _sendQueueOffset < EmuNwaConnection::MaxQueuedSendSize; }
+	bool HasPendingSend() { return _sendQueueOffset < _sendQueue.size(); }
+	bool HasPendingMessages() { return _hasPendingMessages; }
+
+	void ProcessMessages(bool readable);
+	void FlushSendQueue();
+	bool ProcessEndOfFrame(uint32_t frameCount);
+	void SendPendingNotifications();
+	void HandleMessage(std::string_view message);
+	void HandleBinaryMessage(const uint8_t* data, uint32_t size);
+	void HandleMyNameIs(std::string_view clientName);
 	void HandleEmulatorInfo();
 	void HandleEmulationStatus();
 	void HandleCoreReset();
@@ -55,13 +139,22 @@ public:
 	void HandleSaveState(const std::string& fileName);
 	void HandleLoadState(const std::string& fileName);
 	string GetStateFilepath(const std::string& filePath);
-	void HandleCoresList(const std::string& platform);
+	void HandleCoresList(std::string_view platform);
 	void HandleCoreMemories();
-	void HandleCoreInfo(const std::string& coreName);
+	void HandleCoreInfo(std::string_view coreName);
 	void HandleCoreCurrentInfo();
-	void HandleCoreRead(const std::string& memoryName, const std::vector<std::string>& arguments);
-	void HandleCoreWrite(const std::string& memoryName, const std::vector<std::string>& arguments, const std::vector<uint8_t>& data);
-	void SendError(const std::string& errorType, const std::string& message);
-	void SendResponse(const std::string& response);
-	void SendBinaryMessage(const std::vector<uint8_t>& data);
+	void HandleCoreRead(const vector<std::string_view>& arguments);
+	void HandleCoreWrite(const vector<std::string_view>& arguments, const uint8_t* data, uint32_t dataSize);
+	void HandleCoreBatch(const uint8_t* data, uint32_t dataSize);
+	void HandleMemorySubscribe(const vector<std::string_view>& arguments);
+	void HandleMemoryUnsubscribe(const vector<std::string_view>& arguments);
+	void HandleSnapshotAdd(const vector<std::string_view>& arguments);
+	void HandleSnapshotClear();
+	void HandleSnapshotRead(const vector<std::string_view>& arguments);
+	void HandleSnapshotShare();
+	void HandleServerStats(const vector<std::string_view>& arguments);
+	void SendError(std::string_view errorType, std::string_view message);
+	void SendResponse(std::string_view response);
+	void SendBinaryMessage(uint32_t size);
+	void SendBinaryMessage(const uint8_t* data, uint32_t size);
 };
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "pch.h"
+#include "EmuNwa/EmuNwaMemoryRegistry.h"
+#include "Shared/Emulator.h"
+#include "SNES/SnesConsole.h"
+#include "SNES/SnesMemoryManager.h"
+#include "SNES/MemoryMappings.h"
+#include "SNES/Spc.h"
+#include "NES/NesConsole.h"
+#include "Gameboy/Gameboy.h"
+#include "Gameboy/GbMemoryManager.h"
+#include "PCE/PceConsole.h"
+#include "PCE/PceMemoryManager.h"
+#include "SMS/SmsConsole.h"
+#include "SMS/SmsMemoryManager.h"
+#include "GBA/GbaConsole.h"
+#include "GBA/GbaMemoryManager.h"
+#include "WS/WsConsole.h"
+#include "WS/WsMemoryManager.h"
+
+static constexpr EmuNwaMemoryInfo _snesMemories[] = {
+	{ "CPUBUS", MemoryType::SnesMemory, 0x1000000 },
+	{ "APUBUS", MemoryType::SpcMemory, 0x10000 },
+	{ "CARTROM", MemoryType::SnesPrgRom, 0 },
+	{ "WRAM", MemoryType::SnesWorkRam, 0 },
+	{ "SRAM", MemoryType::SnesSaveRam, 0 },
+	{ "VRAM", MemoryType::SnesVideoRam, 0 },
+	{ "OAM", MemoryType::SnesSpriteRam, 0 },
+	{ "CGRAM", MemoryType::SnesCgRam, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _nesMemories[] = {
+	{ "CPUBUS", MemoryType::NesMemory, 0x10000 },
+	{ "PPUBUS", MemoryType::NesPpuMemory, 0x4000 },
+	{ "CARTROM", MemoryType::NesPrgRom, 0 },
+	{ "CHRROM", MemoryType::NesChrRom, 0 },
+	{ "CHRRAM", MemoryType::NesChrRam, 0 },
+	{ "WRAM", MemoryType::NesInternalRam, 0 },
+	{ "CARTRAM", MemoryType::NesWorkRam, 0 },
+	{ "SRAM", MemoryType::NesSaveRam, 0 },
+	{ "NAMETABLES", MemoryType::NesNametableRam, 0 },
+	{ "OAM", MemoryType::NesSpriteRam, 0 },
+	{ "PALETTE", MemoryType::NesPaletteRam, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _gbMemories[] = {
+	{ "CPUBUS", MemoryType::GameboyMemory, 0x10000 },
+	{ "CARTROM", MemoryType::GbPrgRom, 0 },
+	{ "WRAM", MemoryType::GbWorkRam, 0 },
+	{ "SRAM", MemoryType::GbCartRam, 0 },
+	{ "HRAM", MemoryType::GbHighRam, 0 },
+	{ "VRAM", MemoryType::GbVideoRam, 0 },
+	{ "OAM", MemoryType::GbSpriteRam, 0 },
+	{ "BOOTROM", MemoryType::GbBootRom, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _gbaMemories[] = {
+	{ "CPUBUS", MemoryType::GbaMemory, 0x10000000 },
+	{ "CARTROM", MemoryType::GbaPrgRom, 0 },
+	{ "BIOS", MemoryType::GbaBootRom, 0 },
+	{ "SRAM", MemoryType::GbaSaveRam, 0 },
+	{ "IWRAM", MemoryType::GbaIntWorkRam, 0 },
+	{ "EWRAM", MemoryType::GbaExtWorkRam, 0 },
+	{ "VRAM", MemoryType::GbaVideoRam, 0 },
+	{ "OAM", MemoryType::GbaSpriteRam, 0 },
+	{ "PALETTE", MemoryType::GbaPaletteRam, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _pceMemories[] = {
+	{ "CPUBUS", MemoryType::PceMemory, 0x10000 },
+	{ "CARTROM", MemoryType::PcePrgRom, 0 },
+	{ "WRAM", MemoryType::PceWorkRam, 0 },
+	{ "SRAM", MemoryType::PceSaveRam, 0 },
+	{ "CDRAM", MemoryType::PceCdromRam, 0 },
+	{ "CARDRAM", MemoryType::PceCardRam, 0 },
+	{ "ADPCMRAM", MemoryType::PceAdpcmRam, 0 },
+	{ "ARCADERAM", MemoryType::PceArcadeCardRam, 0 },
+	{ "VRAM", MemoryType::PceVideoRam, 0 },
+	{ "VRAM2", MemoryType::PceVideoRamVdc2, 0 },
+	{ "SAT", MemoryType::PceSpriteRam, 0 },
+	{ "SAT2", MemoryType::PceSpriteRamVdc2, 0 },
+	{ "PALETTE", MemoryType::PcePaletteRam, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _smsMemories[] = {
+	{ "CPUBUS", MemoryType::SmsMemory, 0x10000 },
+	{ "CARTROM", MemoryType::SmsPrgRom, 0 },
+	{ "WRAM", MemoryType::SmsWorkRam, 0 },
+	{ "SRAM", MemoryType::SmsCartRam, 0 },
+	{ "BOOTROM", MemoryType::SmsBootRom, 0 },
+	{ "VRAM", MemoryType::SmsVideoRam, 0 },
+	{ "PALETTE", MemoryType::SmsPaletteRam, 0 },
+};
+
+static constexpr EmuNwaMemoryInfo _wsMemories[] = {
+	{ "CPUBUS", MemoryType::WsMemory, 0x100000 },
+	{ "CARTROM", MemoryType::WsPrgRom, 0 },
+	{ "WRAM", MemoryType::WsWorkRam, 0 },
+	{ "SRAM", MemoryType::WsCartRam, 0 },
+	{ "EEPROM", MemoryType::WsCartEeprom, 0 },
+	{ "BOOTROM", MemoryType::WsBootRom, 0 },
+	{ "INTERNALEEPROM", MemoryType::WsInternalEeprom, 0 },
+};
+
+template<size_t size>
+static constexpr EmuNwaCoreInfo MakeCore(const char* name, const char* platform, ConsoleType console, const EmuNwaMemoryInfo (&memories)[size])
+{
+	return { name, platform, console, memories, size };
+}
+
+static constexpr EmuNwaCoreInfo _cores[] = {
+	MakeCore("SnesCore", "SNES", ConsoleType::Snes, _snesMemories),
+	MakeCore("NesCore", "NES", ConsoleType::Nes, _nesMemories),
+	MakeCore("GbcCore", "GBC", ConsoleType::Gameboy, _gbMemories),
+	MakeCore("GbaCore", "GBA", ConsoleType::Gba, _gbaMemories),
+	MakeCore("PceCore", "PCE", ConsoleType::PcEngine, _pceMemories),
+	MakeCore("SmsCore", "SMS", ConsoleType::Sms, _smsMemories),
+	MakeCore("WsCore", "WS", ConsoleType::Ws, _wsMemories),
+};
+
+const EmuNwaCoreInfo* EmuNwaMemoryRegistry::GetCores(size_t& count)
+{
+	count = std::size(_cores);
+	return _cores;
+}
+
+const EmuNwaCoreInfo* EmuNwaMemoryRegistry::FindCore(std::string_view coreName)
+{
+	for(const EmuNwaCoreInfo& core : _cores) {
+		if(coreName == core.Name) {
+			return &core;
+		}
+	}
+	return nullptr;
+}
+
+const EmuNwaCoreInfo* EmuNwaMemoryRegistry::GetCore(ConsoleType console)
+{
+	for(const EmuNwaCoreInfo& core : _cores) {
+		if(core.Console == console) {
+			return &core;
+		}
+	}
+	return nullptr;
+}
+
+const EmuNwaMemoryInfo* EmuNwaMemoryRegistry::FindMemory(ConsoleType console, std::string_view memoryName)
+{
+	const EmuNwaCoreInfo* core = GetCore(console);
+	if(core) {
+		for(size_t i = 0; i < core->MemoryCount; i++) {
+			if(memoryName == core->Memories[i].Name) {
+				return &core->Memories[i];
+			}
+		}
+	}
+	return nullptr;
+}
+
+template<typename T>
+static void AccessBusByte(T* memoryManager, uint32_t address, uint32_t length, uint8_t* buffer, bool forWrite)
+{
+	if(forWrite) {
+		for(uint32_t i = 0; i < length; i++) {
+			memoryManager->DebugWrite(address + i, buffer[i]);
+		}
+	} else {
+		for(uint32_t i = 0; i < length; i++) {
+			buffer[i] = memoryManager->DebugRead(address + i);
+		}
+	}
+}
+
+bool EmuNwaMemoryRegistry::AccessBus(Emulator* emu, MemoryType memoryType, uint32_t address, uint32_t length, uint8_t* buffer, bool forWrite)
+{
+	IConsole* console = emu->GetConsoleUnsafe();
+
+	switch(memoryType) {
+		case MemoryType::SnesMemory:
+		case MemoryType::SpcMemory:
+			if(SnesConsole* snes = dynamic_cast<SnesConsole*>(console)) {
+				if(memoryType == MemoryType::SnesMemory) {
+					MemoryMappings* mappings = snes->GetMemoryManager()->GetMemoryMappings();
+					if(forWrite) {
+						mappings->DebugWriteRange(address, length, buffer);
+					} else {
+						mappings->PeekRange(address, length, buffer);
+					}
+				} else {
+					if(forWrite) {
+						snes->GetSpc()->DebugWriteRange((uint16_t)address, length, buffer);
+					} else {
+						snes->GetSpc()->DebugReadRange((uint16_t)address, length, buffer);
+					}
+				}
+				return true;
+			}
+			break;
+
+		case MemoryType::NesMemory:
+		case MemoryType::NesPpuMemory:
+			if(NesConsole* nes = dynamic_cast<NesConsole*>(console)) {
+				for(uint32_t i = 0; i < length; i++) {
+					uint16_t addr = (uint16_t)(address + i);
+					if(memoryType == MemoryType::NesMemory) {
+						if(forWrite) {
+							nes->DebugWrite(addr, buffer[i], true);
+						} else {
+							buffer[i] = nes->DebugRead(addr);
+						}
+					} else {
+						if(forWrite) {
+							nes->DebugWriteVram(addr, buffer[i]);
+						} else {
+							buffer[i] = nes->DebugReadVram(addr);
+						}
+					}
+				}
+				return true;
+			}
+			break;
+
+		case MemoryType::GameboyMemory:
+			if(Gameboy* gb = dynamic_cast<Gameboy*>(console)) {
+				AccessBusByte(gb->GetMemoryManager(), address, length, buffer, forWrite);
+				return true;
+			}
+			break;
+
+		case MemoryType::GbaMemory:
+			if(GbaConsole* gba = dynamic_cast<GbaConsole*>(console)) {
+				AccessBusByte(gba->GetMemoryManager(), address, length, buffer, forWrite);
+				return true;
+			}
+			break;
+
+		case MemoryType::PceMemory:
+			if(PceConsole* pce = dynamic_cast<PceConsole*>(console)) {
+				AccessBusByte(pce->GetMemoryManager(), address, length, buffer, forWrite);
+				return true;
+			}
+			break;
+
+		case MemoryType::SmsMemory:
+			if(SmsConsole* sms = dynamic_cast<SmsConsole*>(console)) {
+				AccessBusByte(sms->GetMemoryManager(), address, length, buffer, forWrite);
+				return true;
+			}
+			break;
+
+		case MemoryType::WsMemory:
+			if(WsConsole* ws = dynamic_cast<WsConsole*>(console)) {
+				AccessBusByte(ws->GetMemoryManager(), address, length, buffer, forWrite);
+				return true;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return false;
+}
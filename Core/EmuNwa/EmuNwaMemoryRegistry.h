@@ -0,0 +1,39 @@
+#pragma once
+#include "pch.h"
+#include <string_view>
+#include "Shared/MemoryType.h"
+#include "Shared/SettingTypes.h"
+
+class Emulator;
+
+struct EmuNwaMemoryInfo
+{
+	const char* Name;
+	MemoryType Type;
+
+	//Size of the address space for memories accessed through a CPU's bus, 0 for memories that are mapped directly
+	uint32_t BusSize;
+};
+
+struct EmuNwaCoreInfo
+{
+	const char* Name;
+	const char* Platform;
+	ConsoleType Console;
+	const EmuNwaMemoryInfo* Memories;
+	size_t MemoryCount;
+};
+
+//Maps the NWA core/memory names to each console's memory types
+class EmuNwaMemoryRegistry
+{
+public:
+	static const EmuNwaCoreInfo* GetCores(size_t& count);
+	static const EmuNwaCoreInfo* FindCore(std::string_view coreName);
+	static const EmuNwaCoreInfo* GetCore(ConsoleType console);
+
+	static const EmuNwaMemoryInfo* FindMemory(ConsoleType console, std::string_view memoryName);
+
+	//Reads or writes a range through a CPU's bus, the same way the debugger's memory viewer does (the emulator must be locked)
+	static bool AccessBus(Emulator* emu, MemoryType memoryType, uint32_t address, uint32_t length, uint8_t* buffer, bool forWrite);
+};
@@ -4,12 +4,18 @@
 #include "Shared/Emulator.h"
 #include "Shared/MessageManager.h"
 #include "Utilities/Socket.h"
+#include <cstdlib>
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
 
 EmuNwaServer::EmuNwaServer(Emulator* emu)
 {
 	_emu = emu;
 	_stop = false;
 	_initialized = false;
+	_watchCount = 0;
 }
 
 EmuNwaServer::~EmuNwaServer()
@@ -17,45 +23,161 @@ EmuNwaServer::~EmuNwaServer()
 		StopServer();
 }
 
-void EmuNwaServer::AcceptConnections()
+void EmuNwaServer::AcceptConnections(Socket* listener)
 {
 	while(true) {
-		unique_ptr<Socket> socket = _listener->Accept();
+		unique_ptr<Socket> socket = listener->Accept();
 		if(!socket->ConnectionError()) {
+			auto lock = _connectionLock.AcquireSafe();
 			_openConnections.push_back(unique_ptr<EmuNwaConnection>(new EmuNwaConnection(this, _emu, std::move(socket))));
 		} else {
 			break;
 		}
 	}
-	_listener->Listen(10);
+	listener->Listen(10);
 }
 
 void EmuNwaServer::UpdateConnections()
 {
-	vector<unique_ptr<EmuNwaConnection>> connectionsToRemove;
 	for(int i = (int)_openConnections.size() - 1; i >= 0; i--) {
+		EmuNwaConnection* connection = _openConnections[i].get();
+		uint8_t result = _pollResults[i + EmuNwaServer::FirstConnectionIndex];
+
+		if(!connection->ConnectionError() && (result & Socket::PollWrite)) {
+			connection->FlushSendQueue();
+		}
+
+		if(!connection->ConnectionError() && ((result & Socket::PollRead) || connection->HasPendingMessages())) {
+			connection->ProcessMessages((result & Socket::PollRead) != 0);
+		}
+
+		if(!connection->ConnectionError()) {
+			connection->SendPendingNotifications();
+		}
+
 		if(_openConnections[i]->ConnectionError()) {
+			auto lock = _connectionLock.AcquireSafe();
 			_openConnections.erase(_openConnections.begin() + i);
-		} else {
-			_openConnections[i]->ProcessMessages();
 		}
 	}
 }
 
+void EmuNwaServer::InitWakeSocket()
+{
+	//Private socket pair - connecting through the public listener could pick up a client's connection instead
+	if(!Socket::CreateLoopbackPair(_wakeSender, _wakeReceiver)) {
+		//Server still works without the wake up socket, but stopping it may take up to MaxPollDelay
+		_wakeSender.reset();
+		_wakeReceiver.reset();
+	}
+}
+
+void EmuNwaServer::InitLocalListener()
+{
+	const char* path = std::getenv(EmuNwaServer::LocalSocketPathVariable);
+	if(!path || !path[0]) {
+		return;
+	}
+
+	_localListener = Socket::CreateLocalListener(path, 10);
+	if(_localListener) {
+		_localSocketPath = path;
+		MessageManager::DisplayMessage("EmuNwa", "ServerStarted", _localSocketPath);
+	}
+}
+
+void EmuNwaServer::WaitForEvents()
+{
+	//Sleep until a client connects, sends data or disconnects - requests are processed as
+	//soon as they arrive, and the server uses no CPU while all clients are idle
+	_pollSockets.clear();
+	_pollSockets.push_back(_listener->ConnectionError() ? nullptr : _listener.get());
+	_pollSockets.push_back(_wakeReceiver.get());
+	_pollSockets.push_back(_localListener.get());
+	_pollEvents.assign(EmuNwaServer::FirstConnectionIndex, Socket::PollRead);
+
+	int timeout = EmuNwaServer::MaxPollDelay;
+	for(unique_ptr<EmuNwaConnection>& connection : _openConnections) {
+		//Stop reading from clients that don't read their replies (backpressure), and wait
+		//for their socket to be writable again to send the rest of the queued data
+		_pollSockets.push_back(connection->GetSocket());
+		_pollEvents.push_back((connection->CanReceive() ? Socket::PollRead : 0) | (connection->HasPendingSend() ? Socket::PollWrite : 0));
+		if(connection->HasPendingMessages() && connection->CanReceive()) {
+			//Messages that were left unprocessed on the previous turn, don't sleep
+			timeout = 0;
+		}
+	}
+
+	Socket::Poll(_pollSockets, _pollEvents, _pollResults, timeout);
+
+	if(_pollResults[1]) {
+		//Drain the wake up bytes
+		char buffer[256];
+		_wakeReceiver->Recv(buffer, sizeof(buffer), 0);
+	}
+}
+
+void EmuNwaServer::WakeServerThread()
+{
+	auto lock = _connectionLock.AcquireSafe();
+	if(_wakeSender) {
+		char value = 0;
+		_wakeSender->Send(&value, 1, 0);
+	}
+}
+
+void EmuNwaServer::ProcessEndOfFrame()
+{
+	if(!_initialized) {
+		return;
+	}
+
+	uint32_t frameCount = _emu->GetFrameCount();
+	if(_snapshot.IsEnabled()) {
+		_snapshot.Update(_emu, frameCount);
+	}
+
+	if(_watchCount == 0) {
+		return;
+	}
+
+	bool hasNotifications = false;
+	{
+		auto lock = _connectionLock.AcquireSafe();
+		for(unique_ptr<EmuNwaConnection>& connection : _openConnections) {
+			hasNotifications |= connection->ProcessEndOfFrame(frameCount);
+		}
+	}
+
+	if(hasNotifications) {
+		WakeServerThread();
+	}
+}
+
 void EmuNwaServer::Exec()
 {
 	_listener.reset(new Socket());
-	_listener->Bind(0xBEEF);
+	_listener->Bind(EmuNwaServer::ServerPort);
 	_listener->Listen(10);
+	InitWakeSocket();
+	InitLocalListener();
 	_stop = false;
 	_initialized = true;
-	MessageManager::DisplayMessage("EmuNwa", "ServerStarted", std::to_string(0xBEEF));
+	MessageManager::DisplayMessage("EmuNwa", "ServerStarted", std::to_string(EmuNwaServer::ServerPort));
 
 	while(!_stop) {
-		AcceptConnections();
-		UpdateConnections();
+		WaitForEvents();
+		if(_stop) {
+			break;
+		}
 
-		std::this_thread::sleep_for(std::chrono::duration<int, std::milli>(1));
+		UpdateConnections();
+		if(_pollResults[0]) {
+			AcceptConnections(_listener.get());
+		}
+		if(_pollResults[2]) {
+			AcceptConnections(_localListener.get());
+		}
 	}
 }
 
@@ -71,19 +193,54 @@ void EmuNwaServer::StopServer()
 	}
 
 	_stop = true;
+	WakeServerThread();
 
 	if(_serverThread) {
 		_serverThread->join();
 		_serverThread.reset();
 	}
 
-	_openConnections.clear();
-	_initialized = false;
+	{
+		auto lock = _connectionLock.AcquireSafe();
+		_initialized = false;
+		_openConnections.clear();
+		_wakeSender.reset();
+	}
+	_snapshot.ClearRegions();
+	_snapshot.DisableSharedMemory();
+	_wakeReceiver.reset();
 	_listener.reset();
+	if(_localListener) {
+		_localListener.reset();
+		#ifndef _WIN32
+			unlink(_localSocketPath.c_str());
+		#endif
+		_localSocketPath.clear();
+	}
 	MessageManager::DisplayMessage("EmuNwa", "ServerStopped");
 
 }
 
+void EmuNwaServer::AcquireReadBuffer(vector<uint8_t>& buffer)
+{
+	auto lock = _bufferPoolLock.AcquireSafe();
+	if(_bufferPool.empty()) {
+		buffer.resize(EmuNwaServer::ReadBufferSize);
+	} else {
+		buffer.swap(_bufferPool.back());
+		_bufferPool.pop_back();
+	}
+}
+
+void EmuNwaServer::ReleaseReadBuffer(vector<uint8_t>& buffer)
+{
+	auto lock = _bufferPoolLock.AcquireSafe();
+	if(buffer.size() == EmuNwaServer::ReadBufferSize && _bufferPool.size() < EmuNwaServer::MaxPooledBufferCount) {
+		_bufferPool.push_back(std::move(buffer));
+	}
+	vector<uint8_t>().swap(buffer);
+}
+
 bool EmuNwaServer::Started()
 {
 	return _initialized;
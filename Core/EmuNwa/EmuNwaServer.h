@@ -2,26 +2,70 @@
 #include "pch.h"
 #include <thread>
 #include "EmuNwa/EmuNwaConnection.h"
+#include "EmuNwa/EmuNwaSnapshot.h"
+#include "EmuNwa/EmuNwaStats.h"
 #include "Shared/Emulator.h"
 #include "Utilities/Socket.h"
+#include "Utilities/SimpleLock.h"
 
 class EmuNwaConnection;
 
 class EmuNwaServer : public std::enable_shared_from_this<EmuNwaServer>
 {
 private:
+	//Upper bound on how long the server thread sleeps while idle, in case the wake up socket could not be created
+	static constexpr int MaxPollDelay = 1000;
+
+	//Index of the first client connection in _pollSockets (after the listeners and the wake up socket)
+	static constexpr size_t FirstConnectionIndex = 3;
+
+	//When set, the server also listens on a Unix domain socket at this path (for local clients, on Linux/macOS)
+	static constexpr const char* LocalSocketPathVariable = "EMUNWA_SOCKET_PATH";
+
 	Emulator* _emu;
 	unique_ptr<thread> _serverThread;
 	unique_ptr<Socket> _listener;
+	unique_ptr<Socket> _localListener;
+	string _localSocketPath;
 	atomic<bool> _stop;
 	vector<unique_ptr<EmuNwaConnection>> _openConnections;
 	int _nextConnectionId = 1;
 	bool _initialized = false;
+
+	//Private socket pair used by other threads to wake up the server thread while it is waiting in Poll()
+	unique_ptr<Socket> _wakeSender;
+	unique_ptr<Socket> _wakeReceiver;
+
+	//Protects _openConnections (add/remove) and _wakeSender against access from the emulation thread
+	SimpleLock _connectionLock;
+	atomic<uint32_t> _watchCount;
+
+	EmuNwaSnapshot _snapshot;
+	EmuNwaStats _stats;
+
+	vector<Socket*> _pollSockets;
+	vector<uint8_t> _pollEvents;
+	vector<uint8_t> _pollResults;
+
+	//Read buffers of closed connections, reused for new connections
+	SimpleLock _bufferPoolLock;
+	vector<vector<uint8_t>> _bufferPool;
+
 	void Exec();
-	void AcceptConnections();
+	void InitWakeSocket();
+	void WaitForEvents();
+	void InitLocalListener();
+	void AcceptConnections(Socket* listener);
 	void UpdateConnections();
+	void WakeServerThread();
 
 public:
+	static constexpr uint16_t ServerPort = 0xBEEF;
+
+	//Initial size of each connection's read buffer (buffers grow as needed for larger messages)
+	static constexpr size_t ReadBufferSize = 0x10000;
+	static constexpr size_t MaxPooledBufferCount = 16;
+
 	EmuNwaServer(Emulator* emu);
 	virtual ~EmuNwaServer();
 
@@ -29,5 +73,14 @@ public:
 	void StopServer();
 	bool Started();
 	int GetNextConnectionId();
-};
 
+	void AddWatchCount(int32_t delta) { _watchCount += delta; }
+	EmuNwaSnapshot* GetSnapshot() { return &_snapshot; }
+	EmuNwaStats* GetStats() { return &_stats; }
+
+	void AcquireReadBuffer(vector<uint8_t>& buffer);
+	void ReleaseReadBuffer(vector<uint8_t>& buffer);
+
+	//Called by the emulation thread at the end of each frame
+	void ProcessEndOfFrame();
+};
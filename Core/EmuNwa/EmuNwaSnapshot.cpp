@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "EmuNwa/EmuNwaSnapshot.h"
+#include "Shared/Emulator.h"
+#include "Utilities/SharedMemory.h"
+
+#ifndef _WIN32
+	#include <unistd.h>
+#else
+	#include <process.h>
+#endif
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t) && sizeof(atomic<int32_t>) == sizeof(int32_t), "Shared memory layout requires lock-free 32-bit atomics");
+
+EmuNwaSnapshot::EmuNwaSnapshot()
+{
+	_enabled = false;
+}
+
+EmuNwaSnapshot::~EmuNwaSnapshot()
+{
+}
+
+bool EmuNwaSnapshot::AddRegion(const char* name, MemoryType type, uint32_t offset, uint32_t size)
+{
+	shared_ptr<EmuNwaSnapshotData> current = GetData();
+	vector<EmuNwaSnapshotRegion> regions;
+	uint32_t bufferSize = 0;
+	if(current) {
+		for(EmuNwaSnapshotRegion& region : current->Regions) {
+			if(region.Type == type && region.Offset <= offset && (size_t)region.Offset + region.Size >= (size_t)offset + size) {
+				//Already covered by an existing region
+				return true;
+			}
+		}
+		regions = current->Regions;
+		bufferSize = (uint32_t)current->Buffers[0].size();
+	}
+
+	if(size > EmuNwaSnapshot::MaxBufferSize - bufferSize || regions.size() >= EmuNwaSnapshot::MaxRegionCount) {
+		return false;
+	}
+
+	regions.push_back({ name, type, offset, size, bufferSize });
+
+	//Regions are immutable once published - build a new set of buffers and swap it in.
+	//Readers that still hold the previous data keep it alive until they are done with it.
+	shared_ptr<EmuNwaSnapshotData> data(new EmuNwaSnapshotData());
+	data->Regions = regions;
+	data->Buffers[0].resize(bufferSize + size);
+	data->Buffers[1].resize(bufferSize + size);
+	for(int i = 0; i < 2; i++) {
+		data->Sequence[i] = 0;
+		data->FrameCount[i] = 0;
+	}
+	data->Front = -1;
+
+	std::atomic_store(&_data, data);
+	_enabled = true;
+	return true;
+}
+
+void EmuNwaSnapshot::ClearRegions()
+{
+	_enabled = false;
+	std::atomic_store(&_data, shared_ptr<EmuNwaSnapshotData>());
+
+	auto lock = _sharedMemoryLock.AcquireSafe();
+	if(_sharedMemory) {
+		((EmuNwaSharedHeader*)_sharedMemory->GetData())->Front.store(-1, std::memory_order_release);
+	}
+}
+
+bool EmuNwaSnapshot::EnableSharedMemory(string& name, uint32_t& size)
+{
+	static_assert(sizeof(EmuNwaSharedHeader) <= EmuNwaSnapshot::SlotHeaderSize && sizeof(EmuNwaSharedSlot) <= EmuNwaSnapshot::SlotHeaderSize, "Invalid shared memory layout");
+	static_assert(std::size(EmuNwaSharedSlot{}.Regions) == EmuNwaSnapshot::MaxRegionCount, "Invalid shared memory layout");
+
+	auto lock = _sharedMemoryLock.AcquireSafe();
+	if(!_sharedMemory) {
+		#ifdef _WIN32
+			string shmName = "Local\\MesenEmuNwa" + std::to_string(_getpid());
+		#else
+			string shmName = "/mesen-emunwa-" + std::to_string(getpid());
+		#endif
+
+		uint32_t slotSize = EmuNwaSnapshot::SlotHeaderSize + EmuNwaSnapshot::MaxBufferSize;
+		unique_ptr<SharedMemory> shm(new SharedMemory());
+		if(!shm->Create(shmName, EmuNwaSnapshot::SlotHeaderSize + slotSize * 2)) {
+			return false;
+		}
+
+		EmuNwaSharedHeader* header = (EmuNwaSharedHeader*)shm->GetData();
+		memcpy(header->Magic, "EMUNWASH", sizeof(header->Magic));
+		header->Version = 1;
+		header->SlotSize = slotSize;
+		header->SlotOffset[0] = EmuNwaSnapshot::SlotHeaderSize;
+		header->SlotOffset[1] = EmuNwaSnapshot::SlotHeaderSize + slotSize;
+		header->Front.store(-1, std::memory_order_release);
+		_sharedMemory = std::move(shm);
+	}
+
+	name = _sharedMemory->GetName();
+	size = (uint32_t)_sharedMemory->GetSize();
+	return true;
+}
+
+void EmuNwaSnapshot::DisableSharedMemory()
+{
+	auto lock = _sharedMemoryLock.AcquireSafe();
+	_sharedMemory.reset();
+}
+
+void EmuNwaSnapshot::UpdateSharedMemory(EmuNwaSnapshotData* data, int32_t slot, uint32_t frameCount)
+{
+	auto lock = _sharedMemoryLock.AcquireSafe();
+	if(!_sharedMemory) {
+		return;
+	}
+
+	EmuNwaSharedHeader* header = (EmuNwaSharedHeader*)_sharedMemory->GetData();
+	int32_t back = header->Front.load(std::memory_order_relaxed) == 0 ? 1 : 0;
+	uint8_t* slotStart = _sharedMemory->GetData() + header->SlotOffset[back];
+	EmuNwaSharedSlot* sharedSlot = (EmuNwaSharedSlot*)slotStart;
+
+	uint32_t sequence = sharedSlot->Sequence.load(std::memory_order_relaxed);
+	sharedSlot->Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	sharedSlot->RegionCount = (uint32_t)data->Regions.size();
+	for(size_t i = 0; i < data->Regions.size(); i++) {
+		EmuNwaSnapshotRegion& region = data->Regions[i];
+		EmuNwaSharedRegion& sharedRegion = sharedSlot->Regions[i];
+		memset(sharedRegion.Name, 0, sizeof(sharedRegion.Name));
+		strncpy(sharedRegion.Name, region.Name, sizeof(sharedRegion.Name) - 1);
+		sharedRegion.Offset = region.Offset;
+		sharedRegion.Size = region.Size;
+		sharedRegion.DataOffset = region.BufferOffset;
+		sharedRegion.Reserved = 0;
+	}
+
+	//The snapshot's regions are stored contiguously, copy the buffer that was just published as is
+	vector<uint8_t>& buffer = data->Buffers[slot];
+	sharedSlot->DataSize = (uint32_t)buffer.size();
+	memcpy(slotStart + EmuNwaSnapshot::SlotHeaderSize, buffer.data(), buffer.size());
+
+	sharedSlot->FrameCount = frameCount;
+	sharedSlot->Sequence.store(sequence + 2, std::memory_order_release);
+	header->Front.store(back, std::memory_order_release);
+}
+
+void EmuNwaSnapshot::Update(Emulator* emu, uint32_t frameCount)
+{
+	shared_ptr<EmuNwaSnapshotData> data = GetData();
+	if(!data) {
+		return;
+	}
+
+	int32_t back = data->Front == 0 ? 1 : 0;
+	uint8_t* buffer = data->Buffers[back].data();
+
+	uint32_t sequence = data->Sequence[back].load(std::memory_order_relaxed);
+	data->Sequence[back].store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for(EmuNwaSnapshotRegion& region : data->Regions) {
+		ConsoleMemoryInfo memory = emu->GetMemory(region.Type);
+		if(memory.Memory && (size_t)region.Offset + region.Size <= memory.Size) {
+			memcpy(buffer + region.BufferOffset, (uint8_t*)memory.Memory + region.Offset, region.Size);
+		} else {
+			memset(buffer + region.BufferOffset, 0, region.Size);
+		}
+	}
+
+	data->FrameCount[back].store(frameCount, std::memory_order_relaxed);
+	data->Sequence[back].store(sequence + 2, std::memory_order_release);
+	data->Front.store(back, std::memory_order_release);
+
+	UpdateSharedMemory(data.get(), back, frameCount);
+}
+
+const EmuNwaSnapshotRegion* EmuNwaSnapshot::FindRegion(const EmuNwaSnapshotData& data, MemoryType type, uint32_t offset, uint32_t size)
+{
+	for(const EmuNwaSnapshotRegion& region : data.Regions) {
+		if(region.Type == type && region.Offset <= offset && (size_t)region.Offset + region.Size >= (size_t)offset + size) {
+			return &region;
+		}
+	}
+	return nullptr;
+}
+
+bool EmuNwaSnapshot::Contains(MemoryType type, uint32_t offset, uint32_t size) const
+{
+	shared_ptr<EmuNwaSnapshotData> data = GetData();
+	return data && FindRegion(*data, type, offset, size) != nullptr;
+}
+
+bool EmuNwaSnapshot::Read(MemoryType type, uint32_t offset, uint32_t size, uint8_t* dst, uint32_t& frameCount) const
+{
+	shared_ptr<EmuNwaSnapshotData> data = GetData();
+	if(!data) {
+		return false;
+	}
+
+	const EmuNwaSnapshotRegion* source = FindRegion(*data, type, offset, size);
+	if(!source) {
+		return false;
+	}
+
+	while(true) {
+		int32_t front = data->Front.load(std::memory_order_acquire);
+		if(front < 0) {
+			return false;
+		}
+
+		uint32_t sequence = data->Sequence[front].load(std::memory_order_acquire);
+		if(sequence & 0x01) {
+			//Emulation thread is already writing the next frame into this buffer, reload the front index
+			continue;
+		}
+
+		memcpy(dst, data->Buffers[front].data() + source->BufferOffset + (offset - source->Offset), size);
+		frameCount = data->FrameCount[front].load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(data->Sequence[front].load(std::memory_order_relaxed) == sequence) {
+			return true;
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "pch.h"
+#include "Shared/MemoryType.h"
+#include "Utilities/SimpleLock.h"
+
+class Emulator;
+class SharedMemory;
+
+struct EmuNwaSnapshotRegion
+{
+	const char* Name;
+	MemoryType Type;
+	uint32_t Offset;
+	uint32_t Size;
+	uint32_t BufferOffset;
+};
+
+struct EmuNwaSnapshotData
+{
+	vector<EmuNwaSnapshotRegion> Regions;
+	vector<uint8_t> Buffers[2];
+
+	//Odd while the emulation thread is writing to the buffer, incremented again once the copy is complete
+	atomic<uint32_t> Sequence[2];
+	atomic<uint32_t> FrameCount[2];
+
+	//Index of the most recently published buffer (-1 until the first frame is published)
+	atomic<int32_t> Front;
+};
+
+//Layout of the shared memory block that local clients can map to read the snapshot without any request/syscall.
+//The block starts with EmuNwaSharedHeader, followed by 2 slots (at SlotOffset[0/1]) - each slot starts with
+//EmuNwaSharedSlot, followed by the slot's data (at SlotHeaderSize). All values are in the host's byte order.
+//Clients read the slot given by Front, the same way as EmuNwaSnapshot::Read: wait until Sequence is even, copy
+//the data, and retry if Sequence changed in the meantime. Front is -1 while there is nothing to read.
+struct EmuNwaSharedRegion
+{
+	char Name[16];
+	uint32_t Offset;
+	uint32_t Size;
+	uint32_t DataOffset;
+	uint32_t Reserved;
+};
+
+struct EmuNwaSharedSlot
+{
+	atomic<uint32_t> Sequence;
+	uint32_t FrameCount;
+	uint32_t RegionCount;
+	uint32_t DataSize;
+	EmuNwaSharedRegion Regions[64];
+};
+
+struct EmuNwaSharedHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t SlotSize;
+	uint32_t SlotOffset[2];
+	atomic<int32_t> Front;
+};
+
+//Double-buffered copy of a set of memory regions, published by the emulation thread at the end of each frame.
+//Readers never block the emulation thread: they copy from the latest published buffer and retry if the
+//emulation thread started overwriting it in the meantime (which only happens if a read takes more than a frame).
+class EmuNwaSnapshot
+{
+private:
+	static constexpr uint32_t MaxBufferSize = 0x800000;
+	static constexpr uint32_t MaxRegionCount = 64;
+	static constexpr uint32_t SlotHeaderSize = 0x1000;
+
+	shared_ptr<EmuNwaSnapshotData> _data;
+	atomic<bool> _enabled;
+
+	//Protects _sharedMemory, which is written to by the emulation thread
+	SimpleLock _sharedMemoryLock;
+	unique_ptr<SharedMemory> _sharedMemory;
+
+	void UpdateSharedMemory(EmuNwaSnapshotData* data, int32_t slot, uint32_t frameCount);
+
+	shared_ptr<EmuNwaSnapshotData> GetData() const { return std::atomic_load(&_data); }
+	static const EmuNwaSnapshotRegion* FindRegion(const EmuNwaSnapshotData& data, MemoryType type, uint32_t offset, uint32_t size);
+
+public:
+	EmuNwaSnapshot();
+	~EmuNwaSnapshot();
+
+	bool AddRegion(const char* name, MemoryType type, uint32_t offset, uint32_t size);
+	void ClearRegions();
+	bool IsEnabled() { return _enabled; }
+
+	//Creates the shared memory block (if needed) and returns its name and size
+	bool EnableSharedMemory(string& name, uint32_t& size);
+	void DisableSharedMemory();
+
+	//Called by the emulation thread at the end of each frame
+	void Update(Emulator* emu, uint32_t frameCount);
+
+	//Returns true if the range is covered by one of the regions
+	bool Contains(MemoryType type, uint32_t offset, uint32_t size) const;
+
+	//Returns false if the range is not covered by a region, or if no frame has been published yet
+	bool Read(MemoryType type, uint32_t offset, uint32_t size, uint8_t* dst, uint32_t& frameCount) const;
+};
@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "EmuNwa/EmuNwaStats.h"
+
+const char* const EmuNwaStats::_commandNames[] = {
+	"CORE_READ", "bCORE_WRITE", "bCORE_BATCH", "SNAPSHOT_READ", "EMULATOR_INFO", "EMULATION_STATUS", "GAME_INFO",
+	"CORES_LIST", "CORE_MEMORIES", "CORE_INFO", "CORE_CURRENT_INFO", "MY_NAME_IS", "CORE_RESET", "EMULATION_RESET",
+	"EMULATION_STOP", "EMULATION_PAUSE", "EMULATION_RESUME", "EMULATION_RELOAD", "DEBUG_BREAK", "DEBUG_RESUME",
+	"MEMORY_SUBSCRIBE", "MEMORY_UNSUBSCRIBE", "SNAPSHOT_ADD", "SNAPSHOT_CLEAR", "SNAPSHOT_SHARE", "SERVER_STATS",
+	"UNKNOWN"
+};
+
+const uint32_t EmuNwaStats::_commandCount = (uint32_t)std::size(EmuNwaStats::_commandNames);
+
+EmuNwaStats::EmuNwaStats()
+{
+	_commands.reset(new EmuNwaCommandStats[_commandCount]);
+	ConnectionCount = 0;
+	Reset();
+}
+
+uint32_t EmuNwaStats::GetCommandIndex(std::string_view command)
+{
+	for(uint32_t i = 0; i < _commandCount - 1; i++) {
+		const char* name = _commandNames[i];
+		size_t j = 0;
+		while(j < command.size() && name[j] && std::tolower((unsigned char)command[j]) == std::tolower((unsigned char)name[j])) {
+			j++;
+		}
+		if(j == command.size() && name[j] == 0) {
+			return i;
+		}
+	}
+	return _commandCount - 1;
+}
+
+uint32_t EmuNwaStats::GetLatencyBucket(uint64_t latencyUs)
+{
+	if(latencyUs < 4) {
+		return (uint32_t)latencyUs;
+	}
+
+	uint32_t msb = 0;
+	while((latencyUs >> (msb + 1)) != 0) {
+		msb++;
+	}
+	uint32_t bucket = (msb - 1) * 4 + (uint32_t)((latencyUs >> (msb - 2)) & 0x03);
+	return std::min(bucket, EmuNwaStats::LatencyBucketCount - 1);
+}
+
+uint64_t EmuNwaStats::GetLatencyBucketLimit(uint32_t bucket)
+{
+	if(bucket < 4) {
+		return bucket;
+	}
+
+	uint32_t msb = bucket / 4 + 1;
+	uint64_t start = (uint64_t)(4 + (bucket & 0x03)) << (msb - 2);
+	return start + ((uint64_t)1 << (msb - 2)) - 1;
+}
+
+uint32_t EmuNwaStats::GetPercentile(const uint64_t* histogram, uint64_t count, double percentile)
+{
+	uint64_t target = (uint64_t)(count * percentile);
+	uint64_t total = 0;
+	for(uint32_t i = 0; i < EmuNwaStats::LatencyBucketCount; i++) {
+		total += histogram[i];
+		if(total > target) {
+			return (uint32_t)GetLatencyBucketLimit(i);
+		}
+	}
+	return (uint32_t)GetLatencyBucketLimit(EmuNwaStats::LatencyBucketCount - 1);
+}
+
+void EmuNwaStats::Record(uint32_t commandIndex, uint64_t bytesIn, uint64_t bytesOut, uint64_t lockWaitNs, uint64_t handlerNs, uint64_t latencyNs)
+{
+	EmuNwaCommandStats& stats = _commands[commandIndex];
+	stats.Requests.fetch_add(1, std::memory_order_relaxed);
+	stats.BytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+	stats.BytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+	stats.LockWaitNs.fetch_add(lockWaitNs, std::memory_order_relaxed);
+	stats.HandlerNs.fetch_add(handlerNs, std::memory_order_relaxed);
+	stats.Latency[GetLatencyBucket(latencyNs / 1000)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void EmuNwaStats::Reset()
+{
+	for(uint32_t i = 0; i < _commandCount; i++) {
+		EmuNwaCommandStats& stats = _commands[i];
+		stats.Requests = 0;
+		stats.BytesIn = 0;
+		stats.BytesOut = 0;
+		stats.LockWaitNs = 0;
+		stats.HandlerNs = 0;
+		for(atomic<uint32_t>& bucket : stats.Latency) {
+			bucket = 0;
+		}
+	}
+}
+
+EmuNwaStatsTotals EmuNwaStats::GetTotals()
+{
+	EmuNwaStatsTotals totals = {};
+	uint64_t histogram[EmuNwaStats::LatencyBucketCount] = {};
+	uint64_t latencyCount = 0;
+
+	for(uint32_t i = 0; i < _commandCount; i++) {
+		EmuNwaCommandStats& stats = _commands[i];
+		totals.Requests += stats.Requests.load(std::memory_order_relaxed);
+		totals.BytesIn += stats.BytesIn.load(std::memory_order_relaxed);
+		totals.BytesOut += stats.BytesOut.load(std::memory_order_relaxed);
+		totals.LockWaitNs += stats.LockWaitNs.load(std::memory_order_relaxed);
+		totals.HandlerNs += stats.HandlerNs.load(std::memory_order_relaxed);
+		for(uint32_t j = 0; j < EmuNwaStats::LatencyBucketCount; j++) {
+			uint32_t value = stats.Latency[j].load(std::memory_order_relaxed);
+			histogram[j] += value;
+			latencyCount += value;
+		}
+	}
+
+	totals.P99LatencyUs = latencyCount ? GetPercentile(histogram, latencyCount, 0.99) : 0;
+	totals.ConnectionCount = ConnectionCount;
+	return totals;
+}
+
+string EmuNwaStats::ToString()
+{
+	std::string result = "\nconnections:" + std::to_string(ConnectionCount) + "\n";
+	uint64_t histogram[EmuNwaStats::LatencyBucketCount];
+
+	for(uint32_t i = 0; i < _commandCount; i++) {
+		EmuNwaCommandStats& stats = _commands[i];
+		uint64_t requests = stats.Requests.load(std::memory_order_relaxed);
+		if(requests == 0) {
+			continue;
+		}
+
+		uint64_t latencyCount = 0;
+		for(uint32_t j = 0; j < EmuNwaStats::LatencyBucketCount; j++) {
+			histogram[j] = stats.Latency[j].load(std::memory_order_relaxed);
+			latencyCount += histogram[j];
+		}
+
+		result += "command:" + std::string(_commandNames[i]) + "\n";
+		result += "requests:" + std::to_string(requests) + "\n";
+		result += "bytes_in:" + std::to_string(stats.BytesIn.load(std::memory_order_relaxed)) + "\n";
+		result += "bytes_out:" + std::to_string(stats.BytesOut.load(std::memory_order_relaxed)) + "\n";
+		result += "lock_wait_us:" + std::to_string(stats.LockWaitNs.load(std::memory_order_relaxed) / 1000) + "\n";
+		result += "handler_us:" + std::to_string(stats.HandlerNs.load(std::memory_order_relaxed) / 1000) + "\n";
+		result += "p50_us:" + std::to_string(GetPercentile(histogram, latencyCount, 0.5)) + "\n";
+		result += "p99_us:" + std::to_string(GetPercentile(histogram, latencyCount, 0.99)) + "\n";
+	}
+
+	result += "\n";
+	return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "pch.h"
+#include <chrono>
+#include <string_view>
+
+struct EmuNwaCommandStats
+{
+	atomic<uint64_t> Requests;
+	atomic<uint64_t> BytesIn;
+	atomic<uint64_t> BytesOut;
+	atomic<uint64_t> LockWaitNs;
+	atomic<uint64_t> HandlerNs;
+
+	//Latency histogram (time between the request being received and its reply being sent/queued)
+	//4 buckets per power of 2 (in microseconds), to get percentiles within ~25% of the actual value
+	atomic<uint32_t> Latency[96];
+};
+
+struct EmuNwaStatsTotals
+{
+	uint64_t Requests;
+	uint64_t BytesIn;
+	uint64_t BytesOut;
+	uint64_t LockWaitNs;
+	uint64_t HandlerNs;
+	uint32_t P99LatencyUs;
+	uint32_t ConnectionCount;
+};
+
+//Adds the time elapsed during its lifetime to a counter
+class EmuNwaStopwatch
+{
+private:
+	std::chrono::steady_clock::time_point _start;
+	uint64_t& _counter;
+
+public:
+	EmuNwaStopwatch(uint64_t& counter) : _start(std::chrono::steady_clock::now()), _counter(counter) {}
+	~EmuNwaStopwatch() { _counter += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count(); }
+};
+
+//Per-command counters shared by all connections - written by the server thread, read by the
+//emulation thread (DebugStats overlay) and the SERVER_STATS command
+class EmuNwaStats
+{
+private:
+	static constexpr uint32_t LatencyBucketCount = 96;
+	static const char* const _commandNames[];
+	static const uint32_t _commandCount;
+
+	unique_ptr<EmuNwaCommandStats[]> _commands;
+
+	static uint32_t GetLatencyBucket(uint64_t latencyUs);
+	static uint64_t GetLatencyBucketLimit(uint32_t bucket);
+	static uint32_t GetPercentile(const uint64_t* histogram, uint64_t count, double percentile);
+
+public:
+	atomic<uint32_t> ConnectionCount;
+
+	EmuNwaStats();
+
+	//Returns the index used to record stats for a command (unknown commands share a single entry)
+	uint32_t GetCommandIndex(std::string_view command);
+
+	void Record(uint32_t commandIndex, uint64_t bytesIn, uint64_t bytesOut, uint64_t lockWaitNs, uint64_t handlerNs, uint64_t latencyNs);
+	void Reset();
+
+	EmuNwaStatsTotals GetTotals();
+	string ToString();
+};
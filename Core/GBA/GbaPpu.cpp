@@ -1515,7 +1515,15 @@ void GbaPpu::Serialize(Serializer& s)
 
 		//Convert data to plain arrays to improve serialization performance
 		GbaPixelData* src[6] = { _oamOutputBuffers[0], _oamOutputBuffers[1], _layerOutput[0], _layerOutput[1], _layerOutput[2], _layerOutput[3] };
-		string names[6] = { "oamOutputBuffers[0]", "oamOutputBuffers[1]", "layerOutput[0]", "layerOutput[1]", "layerOutput[2]", "layerOutput[3]" };
+		//Names must be string literals (the packed state format identifies values by their name's address)
+		static constexpr const char* names[6][3] = {
+			{ "oamOutputBuffers[0]_color", "oamOutputBuffers[0]_layer", "oamOutputBuffers[0]_priority" },
+			{ "oamOutputBuffers[1]_color", "oamOutputBuffers[1]_layer", "oamOutputBuffers[1]_priority" },
+			{ "layerOutput[0]_color", "layerOutput[0]_layer", "layerOutput[0]_priority" },
+			{ "layerOutput[1]_color", "layerOutput[1]_layer", "layerOutput[1]_priority" },
+			{ "layerOutput[2]_color", "layerOutput[2]_layer", "layerOutput[2]_priority" },
+			{ "layerOutput[3]_color", "layerOutput[3]_layer", "layerOutput[3]_priority" }
+		};
 		for(int i = 0; i < 6; i++) {
 			GbaPixelData* data = src[i];
 			uint16_t color[GbaConstants::ScreenWidth];
@@ -1528,9 +1536,9 @@ void GbaPpu::Serialize(Serializer& s)
 					priority[j] = data[j].Priority;
 				}
 			}
-			s.StreamArray(color, GbaConstants::ScreenWidth, (names[i] + "_color").c_str());
-			s.StreamArray(layer, GbaConstants::ScreenWidth, (names[i] + "_layer").c_str());
-			s.StreamArray(priority, GbaConstants::ScreenWidth, (names[i] + "_priority").c_str());
+			s.StreamArray(color, GbaConstants::ScreenWidth, names[i][0]);
+			s.StreamArray(layer, GbaConstants::ScreenWidth, names[i][1]);
+			s.StreamArray(priority, GbaConstants::ScreenWidth, names[i][2]);
 			if(!s.IsSaving()) {
 				for(int j = 0; j < GbaConstants::ScreenWidth; j++) {
 					data[j].Color = color[j];
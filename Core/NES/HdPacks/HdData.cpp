@@ -0,0 +1,244 @@
+#include "pch.h"
+#include "NES/HdPacks/HdData.h"
+#include "Shared/MessageManager.h"
+#include "Utilities/FolderUtilities.h"
+#include "Utilities/PNGHelper.h"
+#include "Utilities/sha1.h"
+#include "Utilities/Timer.h"
+
+void HdPackBitmapInfo::Decode(const string& cacheFolder)
+{
+	auto lock = _lock.AcquireSafe();
+	if(_initDone) {
+		return;
+	}
+
+	string cachePath;
+	if(!cacheFolder.empty()) {
+		cachePath = FolderUtilities::CombinePath(cacheFolder, SHA1::GetHash(FileData) + ".bin");
+		LoadedFromCache = LoadFromCache(cachePath);
+	}
+
+	if(!LoadedFromCache) {
+		if(PNGHelper::ReadPNG(FileData, PixelData, Width, Height)) {
+			PremultiplyAlpha();
+			if(!cachePath.empty()) {
+				SaveToCache(cachePath);
+			}
+		} else {
+			MessageManager::Log("[HDPack] PNG file " + PngName + " is invalid.");
+		}
+	}
+
+	FileData = {};
+	_initDone = true;
+}
+
+bool HdPackBitmapInfo::LoadFromCache(const string& cachePath)
+{
+	ifstream file(cachePath, ios::in | ios::binary);
+	if(!file) {
+		return false;
+	}
+
+	uint32_t header[4] = {};
+	file.read((char*)header, sizeof(header));
+	if(!file || header[0] != CacheFileMagic || header[1] != CacheFileVersion) {
+		return false;
+	}
+
+	uint32_t width = header[2];
+	uint32_t height = header[3];
+
+	file.seekg(0, ios::end);
+	uint64_t pixelBytes = (uint64_t)file.tellg() - sizeof(header);
+	if(pixelBytes != (uint64_t)width * height * sizeof(uint32_t)) {
+		//Truncated or invalid file, the PNG will be decoded and the file will be overwritten
+		return false;
+	}
+
+	file.seekg(sizeof(header), ios::beg);
+	vector<uint32_t> pixels((size_t)width * height);
+	file.read((char*)pixels.data(), pixelBytes);
+	if(!file) {
+		return false;
+	}
+
+	PixelData = std::move(pixels);
+	Width = width;
+	Height = height;
+	return true;
+}
+
+void HdPackBitmapInfo::SaveToCache(const string& cachePath)
+{
+	//Write to a temporary file first - the file is only renamed once it's complete,
+	//to avoid leaving a truncated file behind (or reading it from another thread)
+	string tmpPath = cachePath + ".tmp" + std::to_string((uintptr_t)this);
+	{
+		ofstream file(tmpPath, ios::out | ios::binary);
+		if(!file) {
+			return;
+		}
+
+		uint32_t header[4] = { CacheFileMagic, CacheFileVersion, Width, Height };
+		file.write((char*)header, sizeof(header));
+		file.write((char*)PixelData.data(), PixelData.size() * sizeof(uint32_t));
+		if(!file) {
+			file.close();
+			std::remove(tmpPath.c_str());
+			return;
+		}
+	}
+
+	if(std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+		//Can fail on Windows if another thread already created the same file (2 identical PNG files in the pack)
+		std::remove(tmpPath.c_str());
+	}
+}
+
+void HdPackBitmapInfo::PremultiplyAlpha()
+{
+	for(size_t i = 0; i < PixelData.size(); i++) {
+		if(PixelData[i] < 0xFF000000) {
+			uint8_t* output = (uint8_t*)(PixelData.data() + i);
+			uint8_t alpha = output[3] + 1;
+			output[0] = (uint8_t)((alpha * output[0]) >> 8);
+			output[1] = (uint8_t)((alpha * output[1]) >> 8);
+			output[2] = (uint8_t)((alpha * output[2]) >> 8);
+		}
+	}
+}
+
+void HdPackData::LoadAsync(bool useCache)
+{
+	Timer timer;
+
+	//Backgrounds first, they are typically needed before the tiles' bitmaps
+	vector<HdPackBitmapInfo*> bitmaps;
+	for(auto& bitmap : BackgroundFileData) {
+		bitmaps.push_back(bitmap.get());
+	}
+	for(auto& bitmap : ImageFileData) {
+		bitmaps.push_back(bitmap.get());
+	}
+
+	if(bitmaps.empty()) {
+		return;
+	}
+
+	string cacheFolder = useCache ? FolderUtilities::GetHdPackCacheFolder() : "";
+
+	atomic<uint32_t> nextIndex(0);
+	auto decodeBitmaps = [&]() {
+		while(!_cancelLoad) {
+			uint32_t index = nextIndex++;
+			if(index >= bitmaps.size()) {
+				break;
+			}
+			bitmaps[index]->Init(cacheFolder);
+		}
+	};
+
+	//The current thread also decodes bitmaps, so start 1 thread less than the number of cores
+	uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(std::min(threadCount, MaxLoadThreads), (uint32_t)bitmaps.size());
+
+	vector<unique_ptr<std::thread>> threads;
+	for(uint32_t i = 1; i < threadCount; i++) {
+		threads.push_back(unique_ptr<std::thread>(new std::thread(decodeBitmaps)));
+	}
+	decodeBitmaps();
+	for(unique_ptr<std::thread>& thread : threads) {
+		thread->join();
+	}
+
+	if(!_cancelLoad) {
+		uint32_t cachedCount = 0;
+		for(HdPackBitmapInfo* bitmap : bitmaps) {
+			cachedCount += bitmap->LoadedFromCache ? 1 : 0;
+		}
+
+		string cacheInfo = useCache ? ", " + std::to_string(cachedCount) + " from cache" : "";
+		MessageManager::Log("[HDPack] " + std::to_string(bitmaps.size()) + " PNG files loaded in " + std::to_string((int)timer.GetElapsedMS()) + " ms (" + std::to_string(threadCount) + " threads" + cacheInfo + ")");
+	}
+}
+
+void HdTileIndex::Build(unordered_map<HdTileKey, vector<HdPackTileInfo*>>& tilesByKey)
+{
+	//Assign a bit to each frame-constant condition used by the tiles
+	unordered_map<HdPackCondition*, uint32_t> conditionBits;
+	_frameConditions.clear();
+	for(auto& keyTiles : tilesByKey) {
+		for(HdPackTileInfo* tile : keyTiles.second) {
+			for(HdPackCondition* condition : tile->Conditions) {
+				if(condition->IsFrameConstant() && conditionBits.find(condition) == conditionBits.end()) {
+					conditionBits[condition] = (uint32_t)_frameConditions.size();
+					_frameConditions.push_back(condition);
+				}
+			}
+		}
+	}
+
+	_frameResults.clear();
+	_frameResults.resize((_frameConditions.size() + 63) / 64);
+	_frameId = 1;
+
+	//Keep the load factor under 50%, misses (tiles that aren't in the pack) are the most common case
+	uint32_t bits = 4;
+	while((1u << bits) < tilesByKey.size() * 2) {
+		bits++;
+	}
+
+	_entries.clear();
+	_entries.resize((size_t)1 << bits);
+	_shift = 32 - bits;
+	_candidates.clear();
+	_conditionBits.clear();
+
+	uint32_t mask = (uint32_t)_entries.size() - 1;
+	for(auto& keyTiles : tilesByKey) {
+		uint32_t hash = keyTiles.first.GetHashCode();
+		uint32_t slot = GetSlot(hash);
+		while(_entries[slot].Count) {
+			slot = (slot + 1) & mask;
+		}
+
+		Entry& entry = _entries[slot];
+		entry.Key = keyTiles.first;
+		entry.Hash = hash;
+		entry.Start = (uint32_t)_candidates.size();
+		entry.Count = (uint32_t)keyTiles.second.size();
+
+		for(HdPackTileInfo* tile : keyTiles.second) {
+			Candidate candidate = {};
+			candidate.Tile = tile;
+			candidate.ConditionStart = (uint32_t)_conditionBits.size();
+			candidate.HasPixelConditions = tile->HasPixelConditions();
+			candidate.ForceDisableCache = tile->ForceDisableCache;
+			for(HdPackCondition* condition : tile->Conditions) {
+				if(condition->IsFrameConstant()) {
+					_conditionBits.push_back(conditionBits[condition]);
+					candidate.ConditionCount++;
+				}
+			}
+			_candidates.push_back(candidate);
+		}
+	}
+}
+
+void HdTileIndex::StartFrame()
+{
+	_frameId++;
+	if(_frameId == 0) {
+		//0 is the initial value for all entries, skip it
+		_frameId++;
+	}
+
+	std::fill(_frameResults.begin(), _frameResults.end(), 0);
+	for(uint32_t i = 0; i < (uint32_t)_frameConditions.size(); i++) {
+		if(_frameConditions[i]->CheckCondition(0, 0, nullptr)) {
+			_frameResults[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
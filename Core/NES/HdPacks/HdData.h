@@ -183,6 +183,12 @@ public:
 		_resultCache = -1;
 	}
 
+	//Conditions that don't depend on the tile or its position, their result can be reused for the whole frame
+	bool IsFrameConstant()
+	{
+		return _useCache;
+	}
+
 	bool CheckCondition(int x, int y, HdPpuTileInfo* tile)
 	{
 		if(_resultCache >= 0) {
@@ -211,49 +217,32 @@ protected:
 struct HdPackBitmapInfo
 {
 private:
-	bool _initDone = false;
+	static constexpr uint32_t CacheFileMagic = 0x42444D48; //HMDB
+	static constexpr uint32_t CacheFileVersion = 1;
+
+	atomic<bool> _initDone = false;
 	SimpleLock _lock;
 
+	void Decode(const string& cacheFolder);
+	bool LoadFromCache(const string& cachePath);
+	void SaveToCache(const string& cachePath);
+	void PremultiplyAlpha();
+
 public:
 	string PngName;
 	vector<uint8_t> FileData;
 	vector<uint32_t> PixelData;
 	uint32_t Width;
 	uint32_t Height;
+	bool LoadedFromCache = false;
 
-	void Init()
+	//When cacheFolder is set, the decoded pixel data is read from (or saved to) a file in that folder, named after the PNG file's hash
+	void Init(const string& cacheFolder = "")
 	{
 		if(_initDone) {
 			return;
 		}
-
-		auto lock = _lock.AcquireSafe();
-		if(_initDone) {
-			return;
-		}
-
-		//Timer tmr;
-		if(PNGHelper::ReadPNG(FileData, PixelData, Width, Height)) {
-			//MessageManager::Log("[HDPack] PNG file loaded: " + PngName + " (" + std::to_string(tmr.GetElapsedMS()) + ")");
-			PremultiplyAlpha();
-		} else {
-			MessageManager::Log("[HDPack] PNG file " + PngName + " is invalid.");
-		}
-		FileData = {};
-		_initDone = true;
-	}
-
-	void PremultiplyAlpha()
-	{
-		for(size_t i = 0; i < PixelData.size(); i++) {
-			if(PixelData[i] < 0xFF000000) {
-				uint8_t* output = (uint8_t*)(PixelData.data() + i);
-				uint8_t alpha = output[3] + 1;
-				output[0] = (uint8_t)((alpha * output[0]) >> 8);
-				output[1] = (uint8_t)((alpha * output[1]) >> 8);
-				output[2] = (uint8_t)((alpha * output[2]) >> 8);
-			}
-		}
+		Decode(cacheFolder);
 	}
 };
 
@@ -262,6 +251,10 @@ struct HdPackTileInfo : public HdTileKey
 private:
 	bool _needInit = true;
 
+	//Conditions that can change within a frame (e.g because they depend on the tile's position)
+	//The other conditions are checked by HdTileIndex, once per frame
+	vector<HdPackCondition*> _pixelConditions;
+
 public:
 	uint32_t X;
 	uint32_t Y;
@@ -281,9 +274,24 @@ public:
 	vector<HdPackCondition*> Conditions;
 	bool ForceDisableCache;
 
-	bool MatchesCondition(int x, int y, HdPpuTileInfo* tile)
+	void InitConditions()
 	{
+		_pixelConditions.clear();
 		for(HdPackCondition* condition : Conditions) {
+			if(!condition->IsFrameConstant()) {
+				_pixelConditions.push_back(condition);
+			}
+		}
+	}
+
+	bool HasPixelConditions()
+	{
+		return _pixelConditions.size() > 0;
+	}
+
+	bool MatchesPixelConditions(int x, int y, HdPpuTileInfo* tile)
+	{
+		for(HdPackCondition* condition : _pixelConditions) {
 			if(!condition->CheckCondition(x, y, tile)) {
 				return false;
 			}
@@ -457,6 +465,124 @@ struct HdPackAdditionalSpriteInfo
 	bool IgnorePalette;
 };
 
+//Open addressing hash table used to find the tiles that match a tile key
+//The tiles for each key are stored in a single array, in the same order as in the pack's definition file.
+//Each frame-constant condition (memory checks, etc.) is assigned a bit in a bitset that is updated once per frame,
+//and each tile has a list of the bits it requires - this allows checking those conditions without accessing the tile/condition objects.
+class HdTileIndex
+{
+public:
+	struct Candidate
+	{
+		HdPackTileInfo* Tile;
+		uint32_t ConditionStart;
+		uint32_t ConditionCount;
+		bool HasPixelConditions;
+		bool ForceDisableCache;
+	};
+
+	struct Entry
+	{
+		HdTileKey Key;
+		uint32_t Hash = 0;
+		uint32_t Count = 0; //0 = unused slot
+		uint32_t Start = 0;
+
+		//Result of the last search for this key, only set when the result can't change until the next frame
+		uint32_t MatchFrameId = 0;
+		HdPackTileInfo* Match = nullptr;
+	};
+
+private:
+	vector<Entry> _entries;
+	vector<Candidate> _candidates;
+	uint32_t _shift = 32;
+
+	vector<HdPackCondition*> _frameConditions;
+	vector<uint64_t> _frameResults;
+	vector<uint32_t> _conditionBits;
+	uint32_t _frameId = 0;
+
+	__forceinline uint32_t GetSlot(uint32_t hash) const
+	{
+		//Multiplicative hashing - the key's hash code is mostly XORed values, its low bits are not well distributed
+		return (uint32_t)((hash * 0x9E3779B1u) >> _shift);
+	}
+
+	__forceinline bool MatchesFrameConditions(Candidate& candidate)
+	{
+		uint32_t* bits = _conditionBits.data() + candidate.ConditionStart;
+		for(uint32_t i = 0; i < candidate.ConditionCount; i++) {
+			if(!(_frameResults[bits[i] >> 6] & ((uint64_t)1 << (bits[i] & 0x3F)))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	void Build(unordered_map<HdTileKey, vector<HdPackTileInfo*>>& tilesByKey);
+
+	//Evaluates all frame-constant conditions, must be called at the start of each frame (after the conditions are initialized)
+	void StartFrame();
+
+	//Returns nullptr when no tiles match the key
+	__forceinline Entry* Find(const HdTileKey& key)
+	{
+		if(_candidates.empty()) {
+			return nullptr;
+		}
+
+		uint32_t hash = key.GetHashCode();
+		uint32_t mask = (uint32_t)_entries.size() - 1;
+		for(uint32_t slot = GetSlot(hash); _entries[slot].Count; slot = (slot + 1) & mask) {
+			Entry& entry = _entries[slot];
+			if(entry.Hash == hash && entry.Key == key) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	//Returns the first of the entry's tiles whose conditions are met (or nullptr)
+	__forceinline HdPackTileInfo* GetMatch(Entry& entry, int x, int y, HdPpuTileInfo* tile, bool* disableCache)
+	{
+		if(entry.MatchFrameId == _frameId) {
+			//This key was already processed during this frame, and the result doesn't depend on the tile's position
+			return entry.Match;
+		}
+
+		HdPackTileInfo* match = nullptr;
+		bool isFrameConstant = true;
+		for(uint32_t i = entry.Start, end = entry.Start + entry.Count; i < end; i++) {
+			Candidate& candidate = _candidates[i];
+			if(disableCache != nullptr && candidate.ForceDisableCache) {
+				*disableCache = true;
+			}
+
+			if(!MatchesFrameConditions(candidate)) {
+				continue;
+			}
+
+			if(candidate.HasPixelConditions) {
+				isFrameConstant = false;
+				if(!candidate.Tile->MatchesPixelConditions(x, y, tile)) {
+					continue;
+				}
+			}
+
+			match = candidate.Tile;
+			break;
+		}
+
+		if(isFrameConstant) {
+			entry.MatchFrameId = _frameId;
+			entry.Match = match;
+		}
+		return match;
+	}
+};
+
 struct FallbackTileInfo
 {
 	int32_t TileIndex;
@@ -472,7 +598,9 @@ struct BgmTrackInfo
 struct HdPackData
 {
 private:
-	bool _cancelLoad = false;
+	static constexpr uint32_t MaxLoadThreads = 8;
+
+	atomic<bool> _cancelLoad = false;
 
 public:
 	static constexpr int BgLayerCount = 40;
@@ -485,7 +613,7 @@ public:
 	vector<HdPackAdditionalSpriteInfo> AdditionalSprites;
 	vector<FallbackTileInfo> FallbackTiles;
 	unordered_set<uint32_t> WatchedMemoryAddresses;
-	unordered_map<HdTileKey, vector<HdPackTileInfo*>> TileByKey;
+	HdTileIndex TileIndex;
 	unordered_map<string, string> PatchesByHash;
 	unordered_map<int, BgmTrackInfo> BgmFilesById;
 	unordered_map<int, string> SfxFilesById;
@@ -504,21 +632,8 @@ public:
 	HdPackData(const HdPackData&) = delete;
 	HdPackData& operator=(const HdPackData&) = delete;
 
-	void LoadAsync()
-	{
-		for(auto& bitmap : BackgroundFileData) {
-			bitmap->Init();
-			if(_cancelLoad) {
-				return;
-			}
-		}
-		for(auto& bitmap : ImageFileData) {
-			bitmap->Init();
-			if(_cancelLoad) {
-				return;
-			}
-		}
-	}
+	//Decodes all bitmaps using multiple threads, to avoid decoding them on the emulation thread while the game is running
+	void LoadAsync(bool useCache);
 
 	void CancelLoad()
 	{
@@ -290,6 +290,8 @@ void HdNesPack<scale>::OnBeforeApplyFilter()
 		condition->Initialize(_hdScreenInfo, this);
 	}
 
+	_hdData->TileIndex.StartFrame();
+
 	if(_hdData->Palette.size() == 0x40) {
 		memcpy(_palette, _hdData->Palette.data(), 0x40 * sizeof(uint32_t));
 	} else {
@@ -441,42 +443,35 @@ HdPackTileInfo* HdNesPack<scale>::GetCachedMatchingTile(uint32_t x, uint32_t y,
 template<uint32_t scale>
 HdPackTileInfo* HdNesPack<scale>::GetMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo* tile, bool* disableCache)
 {
-	auto hdTile = _hdData->TileByKey.find(*tile);
-	if(hdTile == _hdData->TileByKey.end()) {
+	HdTileIndex::Entry* hdTile = _hdData->TileIndex.Find(*tile);
+	if(!hdTile) {
 		int32_t fallbackTileIndex = GetFallbackTile(tile->TileIndex);
 		if(fallbackTileIndex >= 0) {
 			int32_t orgIndex = tile->TileIndex;
 			tile->TileIndex = fallbackTileIndex;
-			hdTile = _hdData->TileByKey.find(*tile);
-			if(hdTile == _hdData->TileByKey.end()) {
-				hdTile = _hdData->TileByKey.find(tile->GetKey(true));
-				if(hdTile == _hdData->TileByKey.end()) {
+			hdTile = _hdData->TileIndex.Find(*tile);
+			if(!hdTile) {
+				hdTile = _hdData->TileIndex.Find(tile->GetKey(true));
+				if(!hdTile) {
 					tile->TileIndex = orgIndex;
 				}
 			}
 		}
 	
-		if(hdTile == _hdData->TileByKey.end()) {
-			hdTile = _hdData->TileByKey.find(tile->GetKey(true));
+		if(!hdTile) {
+			hdTile = _hdData->TileIndex.Find(tile->GetKey(true));
 		}
 	}
 
-	if(hdTile != _hdData->TileByKey.end()) {
-		for(HdPackTileInfo* hdPackTile : hdTile->second) {
-			if(disableCache != nullptr && hdPackTile->ForceDisableCache) {
-				*disableCache = true;
-			}
-
-			if(hdPackTile->MatchesCondition(x, y, tile)) {
-				if(hdPackTile->NeedInit()) {
-					hdPackTile->Init();
-				}
-				return hdPackTile;
-			}
-		}
+	if(!hdTile) {
+		return nullptr;
 	}
 
-	return nullptr;
+	HdPackTileInfo* match = _hdData->TileIndex.GetMatch(*hdTile, x, y, tile, disableCache);
+	if(match && match->NeedInit()) {
+		match->Init();
+	}
+	return match;
 }
 
 template<uint32_t scale>
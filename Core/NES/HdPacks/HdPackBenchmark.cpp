@@ -0,0 +1,229 @@
+#include "pch.h"
+#include <random>
+#include "NES/HdPacks/HdPackBenchmark.h"
+#include "NES/HdPacks/HdData.h"
+#include "NES/HdPacks/HdNesPack.h"
+#include "NES/HdPacks/HdPackLoader.h"
+#include "Shared/EmulatorBenchmark.h"
+#include "Utilities/FolderUtilities.h"
+#include "Utilities/HexUtilities.h"
+#include "Utilities/PNGHelper.h"
+#include "Utilities/Timer.h"
+
+//Only used to give the conditions access to the screen's content
+class HdPackBenchmarkPack final : public BaseHdNesPack
+{
+public:
+	HdPackBenchmarkPack(HdScreenInfo* screenInfo) { _hdScreenInfo = screenInfo; }
+
+	uint32_t GetScale() override { return 4; }
+	void Process(HdScreenInfo* hdScreenInfo, uint32_t* outputBuffer, OverscanDimensions& overscan) override {}
+};
+
+bool HdPackBenchmark::GeneratePack(string definitionFile, uint32_t variantCount)
+{
+	//Fixed seed, the pack is identical for every run
+	std::mt19937 rng(5);
+	constexpr uint32_t imageSize = 512;
+	constexpr uint32_t tileSize = 8 * PackScale;
+
+	vector<uint32_t> image(imageSize * imageSize, 0xFF4080FF);
+	if(!PNGHelper::WritePNG(FolderUtilities::CombinePath(FolderUtilities::GetFolderName(definitionFile), "tiles.png"), image.data(), imageSize, imageSize, 32)) {
+		return false;
+	}
+
+	stringstream pack;
+	pack << "<ver>" << BaseHdNesPack::CurrentVersion << "\n";
+	pack << "<scale>" << PackScale << "\n";
+	pack << "<img>tiles.png\n";
+
+	for(uint32_t i = 0; i < MemoryConditionCount; i++) {
+		pack << "<condition>m" << i << ",memoryCheckConstant," << HexUtilities::ToHex((uint16_t)(0x10 + (i % 16))) << ",==," << HexUtilities::ToHex((uint8_t)(i % 4)) << "\n";
+	}
+
+	int32_t offsets[3] = { -8, 0, 8 };
+	for(uint32_t i = 0; i < NearbyConditionCount; i++) {
+		int32_t x = offsets[rng() % 3];
+		int32_t y = rng() % 2 ? 8 : -8;
+		uint32_t tileIndex = rng() % PackTileCount;
+		uint32_t palette = 0x0F101112 + rng() % 4;
+		pack << "<condition>n" << i << ",tileNearby," << x << "," << y << "," << HexUtilities::ToHex((uint16_t)tileIndex) << "," << HexUtilities::ToHex32(palette) << "\n";
+	}
+
+	uint32_t tileNumber = 0;
+	for(uint32_t tileIndex = 0; tileIndex < PackTileCount; tileIndex++) {
+		for(uint32_t palette = 0; palette < PackPaletteCount; palette++) {
+			for(uint32_t variant = 0; variant < variantCount; variant++) {
+				uint32_t x = (tileNumber % (imageSize / tileSize)) * tileSize;
+				uint32_t y = ((tileNumber / (imageSize / tileSize)) % (imageSize / tileSize)) * tileSize;
+				tileNumber++;
+
+				if(variant < variantCount - 1) {
+					//Conditional replacements, the last variant is the default tile
+					pack << "[m" << (rng() % MemoryConditionCount);
+					if(rng() % 10 < 3) {
+						pack << "&" << (rng() % 2 ? "!" : "") << "m" << (rng() % MemoryConditionCount);
+					}
+					if(rng() % 10 < 3) {
+						pack << "&n" << (rng() % NearbyConditionCount);
+					}
+					pack << "]";
+				}
+				pack << "<tile>0," << HexUtilities::ToHex((uint16_t)tileIndex) << "," << HexUtilities::ToHex32(0x0F101112 + palette) << "," << x << "," << y << ",1,N\n";
+			}
+		}
+	}
+
+	ofstream file(definitionFile, ios::out | ios::binary);
+	if(!file) {
+		return false;
+	}
+	file << pack.str();
+	return true;
+}
+
+void HdPackBenchmark::InitScreen(HdScreenInfo& screen)
+{
+	std::mt19937 rng(3);
+
+	//32x30 background tiles, around 85% of them have a replacement in the pack
+	for(uint32_t tileY = 0; tileY < 30; tileY++) {
+		for(uint32_t tileX = 0; tileX < 32; tileX++) {
+			int32_t tileIndex = rng() % 600;
+			uint32_t palette = 0x0F101112 + rng() % 9;
+			for(uint32_t y = 0; y < 8; y++) {
+				for(uint32_t x = 0; x < 8; x++) {
+					HdPpuTileInfo& tile = screen.ScreenTiles[(tileY * 8 + y) * 256 + tileX * 8 + x].Tile;
+					tile.TileIndex = tileIndex;
+					tile.PaletteColors = palette;
+					tile.OffsetX = x;
+					tile.OffsetY = y;
+				}
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < SpriteCount; i++) {
+		uint32_t spriteX = rng() % 248;
+		uint32_t spriteY = rng() % 232;
+		int32_t tileIndex = rng() % PackTileCount;
+		uint32_t palette = 0x0F101112 + rng() % PackPaletteCount;
+		for(uint32_t y = 0; y < 8; y++) {
+			for(uint32_t x = 0; x < 8; x++) {
+				HdPpuPixelInfo& pixel = screen.ScreenTiles[(spriteY + y) * 256 + spriteX + x];
+				if(pixel.SpriteCount < 4) {
+					HdPpuTileInfo& tile = pixel.Sprite[pixel.SpriteCount++];
+					tile.TileIndex = tileIndex;
+					tile.PaletteColors = palette;
+					tile.OffsetX = x;
+					tile.OffsetY = y;
+				}
+			}
+		}
+	}
+}
+
+HdPackTileInfo* HdPackBenchmark::GetMatchingTile(HdPackData& data, uint32_t x, uint32_t y, HdPpuTileInfo* tile, bool* disableCache)
+{
+	//Same lookups as HdNesPack::GetMatchingTile (the pack has no fallback tiles)
+	HdTileIndex::Entry* entry = data.TileIndex.Find(*tile);
+	if(!entry) {
+		entry = data.TileIndex.Find(tile->GetKey(true));
+		if(!entry) {
+			return nullptr;
+		}
+	}
+	return data.TileIndex.GetMatch(*entry, x, y, tile, disableCache);
+}
+
+HdPackBenchmarkResult HdPackBenchmark::Run(string folder, uint32_t variantCount, uint32_t frameCount)
+{
+	HdPackBenchmarkResult result = {};
+	result.VariantCount = std::max<uint32_t>(variantCount, 1);
+
+	FolderUtilities::CreateFolder(folder);
+	string definitionFile = FolderUtilities::CombinePath(folder, "hires.txt");
+	if(!GeneratePack(definitionFile, result.VariantCount)) {
+		return result;
+	}
+
+	HdPackData data;
+	Timer timer;
+	if(!HdPackLoader::LoadHdNesPack(definitionFile, data)) {
+		return result;
+	}
+	result.LoadTime = timer.GetElapsedMS();
+	result.TileCount = (uint32_t)data.Tiles.size();
+	result.ConditionCount = (uint32_t)data.Conditions.size();
+	result.Loaded = true;
+
+	HdScreenInfo screen(false);
+	HdPackBenchmarkPack pack(&screen);
+	InitScreen(screen);
+
+	result.FrameTimes.reserve(frameCount);
+	for(uint32_t frame = 0; frame < frameCount; frame++) {
+		//Change the memory values every 20 frames, to change which replacements are active
+		for(uint32_t i = 0; i < 16; i++) {
+			screen.WatchedAddressValues[0x10 + i] = (frame / 20 + i) % 4;
+		}
+
+		uint32_t matchCount = 0;
+		timer.Reset();
+		for(unique_ptr<HdPackCondition>& condition : data.Conditions) {
+			condition->Initialize(&screen, &pack);
+		}
+		data.TileIndex.StartFrame();
+
+		for(uint32_t y = 0; y < 240; y++) {
+			HdPackTileInfo* cachedTile = nullptr;
+			bool useCache = false;
+			for(uint32_t x = 0; x < 256; x++) {
+				HdPpuPixelInfo& pixel = screen.ScreenTiles[y * 256 + x];
+
+				//Background matches are reused for the rest of the tile's row, like HdNesPack does
+				if((x & 0x07) == 0) {
+					useCache = false;
+				}
+				if(!useCache) {
+					bool disableCache = false;
+					cachedTile = GetMatchingTile(data, x, y, &pixel.Tile, &disableCache);
+					useCache = !disableCache;
+				}
+				matchCount += cachedTile ? 1 : 0;
+				result.Checksum = result.Checksum * 31 + (cachedTile ? cachedTile->X * 7919 + cachedTile->Y + 1 : 0);
+
+				for(uint32_t i = 0; i < pixel.SpriteCount; i++) {
+					HdPackTileInfo* spriteTile = GetMatchingTile(data, x, y, &pixel.Sprite[i], nullptr);
+					matchCount += spriteTile ? 1 : 0;
+					result.Checksum = result.Checksum * 31 + (spriteTile ? spriteTile->X * 7919 + spriteTile->Y + 1 : 0);
+				}
+			}
+		}
+		result.FrameTimes.push_back(timer.GetElapsedMS());
+		result.MatchCount = matchCount;
+	}
+
+	return result;
+}
+
+string HdPackBenchmark::ToJson(vector<HdPackBenchmarkResult>& results, string version, uint32_t frameCount)
+{
+	stringstream out;
+	out << std::fixed << std::setprecision(4);
+	out << "{\n";
+	out << "  \"version\": \"" << EmulatorBenchmark::EscapeJson(version) << "\",\n";
+	out << "  \"frames\": " << frameCount << ",\n";
+	out << "  \"packs\": [";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		HdPackBenchmarkResult& r = results[i];
+		out << (i > 0 ? "," : "") << "\n    { \"variants\": " << r.VariantCount << ", \"loaded\": " << (r.Loaded ? "true" : "false");
+		out << ", \"tiles\": " << r.TileCount << ", \"conditions\": " << r.ConditionCount << ", \"loadMs\": " << r.LoadTime;
+		out << ", \"msPerFrame\": { \"median\": " << EmulatorBenchmark::Median(r.FrameTimes) << ", \"p99\": " << EmulatorBenchmark::Percentile(r.FrameTimes, 99) << ", \"max\": " << EmulatorBenchmark::Percentile(r.FrameTimes, 100) << " }";
+		out << ", \"matches\": " << r.MatchCount << ", \"checksum\": \"" << HexUtilities::ToHex(r.Checksum) << "\" }";
+	}
+
+	out << "\n  ]\n}\n";
+	return out.str();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "pch.h"
+
+struct HdPackData;
+struct HdPackTileInfo;
+struct HdPpuTileInfo;
+struct HdScreenInfo;
+
+struct HdPackBenchmarkResult
+{
+	bool Loaded = false;
+	uint32_t VariantCount = 0;
+	uint32_t TileCount = 0;
+	uint32_t ConditionCount = 0;
+
+	//Time needed to parse the pack's definition file and build the tile index, in ms
+	double LoadTime = 0;
+
+	//Time needed to find the HD tile of every pixel (background + sprites), for each frame, in ms
+	vector<double> FrameTimes;
+
+	//Tiles that matched a replacement on the last frame, and a checksum of every frame's matches (should
+	//not change when optimizing the tile matching code)
+	uint32_t MatchCount = 0;
+	uint64_t Checksum = 0;
+};
+
+//Measures the HD pack tile matching code on a synthetic pack: every tile/palette combination has variantCount
+//replacements, all but one guarded by memory and tileNearby conditions, and the screen is filled with a
+//background (mostly made of tiles that are in the pack) and sprites
+class HdPackBenchmark
+{
+private:
+	static constexpr uint32_t PackTileCount = 512;
+	static constexpr uint32_t PackPaletteCount = 8;
+	static constexpr uint32_t PackScale = 4;
+	static constexpr uint32_t MemoryConditionCount = 64;
+	static constexpr uint32_t NearbyConditionCount = 32;
+	static constexpr uint32_t SpriteCount = 24;
+
+	static bool GeneratePack(string definitionFile, uint32_t variantCount);
+	static void InitScreen(HdScreenInfo& screen);
+	static HdPackTileInfo* GetMatchingTile(HdPackData& data, uint32_t x, uint32_t y, HdPpuTileInfo* tile, bool* disableCache);
+
+public:
+	//Writes the pack in the given folder (overwriting the previous one), loads it and runs the tile matching for frameCount frames
+	static HdPackBenchmarkResult Run(string folder, uint32_t variantCount, uint32_t frameCount);
+
+	static string ToJson(vector<HdPackBenchmarkResult>& results, string version, uint32_t frameCount);
+};
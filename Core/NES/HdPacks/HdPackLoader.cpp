@@ -845,19 +845,14 @@ void HdPackLoader::LoadCustomPalette()
 
 void HdPackLoader::InitializeHdPack()
 {
+	unordered_map<HdTileKey, vector<HdPackTileInfo*>> tilesByKey;
 	for(unique_ptr<HdPackTileInfo> &tileInfo : _data->Tiles) {
-		auto tiles = _data->TileByKey.find(tileInfo->GetKey(false));
-		if(tiles == _data->TileByKey.end()) {
-			_data->TileByKey[tileInfo->GetKey(false)] = vector<HdPackTileInfo*>();
-		}
-		_data->TileByKey[tileInfo->GetKey(false)].push_back(tileInfo.get());
+		tileInfo->InitConditions();
 
+		tilesByKey[tileInfo->GetKey(false)].push_back(tileInfo.get());
 		if(tileInfo->DefaultTile) {
-			auto tilesForDefaultKey = _data->TileByKey.find(tileInfo->GetKey(true));
-			if(tilesForDefaultKey == _data->TileByKey.end()) {
-				_data->TileByKey[tileInfo->GetKey(true)] = vector<HdPackTileInfo*>();
-			}
-			_data->TileByKey[tileInfo->GetKey(true)].push_back(tileInfo.get());
+			tilesByKey[tileInfo->GetKey(true)].push_back(tileInfo.get());
 		}
 	}
+	_data->TileIndex.Build(tilesByKey);
 }
@@ -26,7 +26,6 @@
 #include "NES/Mappers/FDS/Fds.h"
 #include "Shared/Emulator.h"
 #include "Shared/Audio/SoundMixer.h"
-#include "Shared/SaveStateManager.h"
 #include "Shared/CheatManager.h"
 #include "Shared/Movies/MovieManager.h"
 #include "Shared/BaseControlManager.h"
@@ -229,8 +228,9 @@ void NesConsole::LoadHdPack(VirtualFile& romFile)
 
 			shared_ptr<HdPackData> data = _hdData.lock();
 			if(data) {
-				thread asyncLoadData([data]() {
-					data->LoadAsync();
+				bool useCache = GetNesConfig().CacheHdPackBitmaps;
+				thread asyncLoadData([data, useCache]() {
+					data->LoadAsync(useCache);
 				});
 				asyncLoadData.detach();
 			}
@@ -681,8 +681,8 @@ void NesConsole::StartRecordingHdPack(HdPackBuilderOptions options)
 
 	_emu->GetVideoDecoder()->WaitForAsyncFrameDecode();
 
-	std::stringstream saveState;
-	_emu->Serialize(saveState, false, 0);
+	SerializeSnapshot saveState;
+	_emu->Serialize(saveState, false);
 
 	_hdPackBuilder.reset();
 	_hdPackBuilder.reset(new HdPackBuilder(_emu, _ppu->GetPpuModel(), !_mapper->HasChrRom(), options));
@@ -691,7 +691,7 @@ void NesConsole::StartRecordingHdPack(HdPackBuilderOptions options)
 	_ppu.reset(new HdBuilderPpu(this, _hdPackBuilder.get(), options.ChrRamBankSize));
 	_memoryManager->RegisterIODevice(_ppu.get());
 
-	_emu->Deserialize(saveState, SaveStateManager::FileFormatVersion, false);
+	_emu->Deserialize(saveState, false);
 	_emu->GetSoundMixer()->StopAudio();
 
 	_emu->GetVideoDecoder()->ForceFilterUpdate();
@@ -704,8 +704,8 @@ void NesConsole::StopRecordingHdPack()
 		
 		_emu->GetVideoDecoder()->WaitForAsyncFrameDecode();
 
-		std::stringstream saveState;
-		_emu->Serialize(saveState, false, 0);
+		SerializeSnapshot saveState;
+		_emu->Serialize(saveState, false);
 
 		_memoryManager->UnregisterIODevice(_ppu.get());
 		if(_hdData) {
@@ -716,7 +716,7 @@ void NesConsole::StopRecordingHdPack()
 		_memoryManager->RegisterIODevice(_ppu.get());
 		_hdPackBuilder.reset();
 
-		_emu->Deserialize(saveState, SaveStateManager::FileFormatVersion, false);
+		_emu->Deserialize(saveState, false);
 		_emu->GetSoundMixer()->StopAudio();
 		_emu->GetVideoDecoder()->ForceFilterUpdate();
 	}
@@ -6,7 +6,9 @@
 class HandShakeMessage : public NetMessage
 {
 private:
-	static constexpr int CurrentVersion = 200; //Use 200+ to distinguish from original Mesen & Mesen-S
+	//Use 200+ to distinguish from original Mesen & Mesen-S
+	//201: save states are sent using LZ4 compression
+	static constexpr int CurrentVersion = 201;
 	uint32_t _emuVersion = 0;
 	uint32_t _protocolVersion = CurrentVersion;
 	string _hashedPassword;
@@ -29,7 +29,9 @@ public:
 		{
 			auto lock = emu->AcquireLock();
 			_activeCheats = emu->GetCheatManager()->GetCheats();
-			emu->Serialize(state, true);
+			//Peers with a different protocol version are rejected during the handshake (see HandShakeMessage::CurrentVersion),
+			//so the faster codec can be used to reduce the time spent holding the emulation lock
+			emu->Serialize(state, true, 1, SerializeFormat::Binary, CompressionCodec::Lz4);
 		}
 
 		uint32_t dataSize = (uint32_t)state.tellp();
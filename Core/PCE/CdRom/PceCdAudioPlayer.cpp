@@ -28,6 +28,7 @@ void PceCdAudioPlayer::Play(uint32_t startSector, bool pause)
 
 		_state.EndSector = _disc->GetTrackLastSector(track);
 		_state.EndBehavior = CdPlayEndBehavior::Stop;
+		_cdrom->GetPrefetcher().PrefetchAudio(startSector, _state.EndSector);
 
 		_state.CurrentSample = 0;
 		_state.CurrentSector = startSector;
@@ -45,13 +46,19 @@ void PceCdAudioPlayer::SetEndPosition(uint32_t endSector, CdPlayEndBehavior endB
 	_state.EndSector = endSector;
 	_state.EndBehavior = endBehavior;
 	_state.Status = CdAudioStatus::Playing;
+	_cdrom->GetPrefetcher().PrefetchAudio(_state.CurrentSector, endSector);
 }
 
 void PceCdAudioPlayer::PlaySample()
 {
 	if(_state.Status == CdAudioStatus::Playing) {
-		_state.LeftSample = _disc->ReadLeftSample(_state.CurrentSector, _state.CurrentSample);
-		_state.RightSample = _disc->ReadRightSample(_state.CurrentSector, _state.CurrentSample);
+		if(_bufferedSector != _state.CurrentSector) {
+			_cdrom->GetPrefetcher().ReadAudioSector(_state.CurrentSector, _sectorSamples);
+			_bufferedSector = _state.CurrentSector;
+		}
+
+		_state.LeftSample = _sectorSamples[_state.CurrentSample * 2];
+		_state.RightSample = _sectorSamples[_state.CurrentSample * 2 + 1];
 		_samplesToPlay.push_back(_state.LeftSample);
 		_samplesToPlay.push_back(_state.RightSample);
 		_state.CurrentSample++;
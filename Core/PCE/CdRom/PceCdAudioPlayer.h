@@ -19,6 +19,10 @@ class PceCdAudioPlayer final : public IAudioProvider, public ISerializable
 
 	vector<int16_t> _samplesToPlay;
 	uint32_t _clockCounter = 0;
+
+	//Samples of the sector that is currently playing, read from the disc all at once
+	int16_t _sectorSamples[588 * 2] = {};
+	int64_t _bufferedSector = -1;
 	uint32_t _seekDelay = 0;
 	
 	HermiteResampler _resampler;
@@ -229,6 +229,7 @@ void PceScsiBus::CmdRead()
 	_needExec = true;
 	_state.Sector = sector;
 	_state.SectorsToRead = sectorsToRead;
+	_cdrom->GetPrefetcher().PrefetchData(sector, sectorsToRead);
 
 	//Set the phase to "data in" right away
 	//Ys IV appears to expect this to happen relatively quickly after
@@ -450,8 +451,10 @@ void PceScsiBus::ProcessDiscRead()
 		if(_readSectorCounter <= 0) {
 			if(_dataBuffer.empty()) {
 				//read disc data
+				uint8_t sectorData[2048] = {};
+				_cdrom->GetPrefetcher().ReadDataSector(_state.Sector, sectorData);
 				_dataBuffer.clear();
-				_disc->ReadDataSector(_state.Sector, _dataBuffer);
+				_dataBuffer.insert(_dataBuffer.end(), sectorData, sectorData + 2048);
 
 				LogDebug("[SCSI] Sector #" + std::to_string(_state.Sector) + " finished reading.");
 
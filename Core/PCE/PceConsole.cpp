@@ -52,9 +52,10 @@ LoadRomResult PceConsole::LoadRom(VirtualFile& romFile)
 			return LoadRomResult::Failure;
 		}
 		romData = _hesData->RomData;
-	} else if(romFile.GetFileExtension() == ".cue") {
+	} else if(romFile.GetFileExtension() == ".cue" || romFile.GetFileExtension() == ".chd") {
 		DiscInfo disc = {};
-		if(!CdReader::LoadCue(romFile, disc)) {
+		bool loaded = romFile.GetFileExtension() == ".cue" ? CdReader::LoadCue(romFile, disc) : CdReader::LoadChd(romFile, disc);
+		if(!loaded) {
 			return LoadRomResult::Failure;
 		}
 
@@ -62,6 +63,10 @@ LoadRomResult PceConsole::LoadRom(VirtualFile& romFile)
 			return LoadRomResult::Failure;
 		}
 
+		//Hashing a .chd file would require reading the entire image, .chd discs are identified by a hash of their content instead
+		_discSha1Hash = disc.Sha1Hash;
+		_discCrc32 = disc.Crc32;
+
 		_cdrom.reset(new PceCdRom(_emu, this, disc));
 		_romFormat = RomFormat::PceCdRom;
 		cdromUnitEnabled = true;
@@ -290,6 +295,21 @@ RomFormat PceConsole::GetRomFormat()
 	return _romFormat;
 }
 
+string PceConsole::GetHash(HashType hashType)
+{
+	//Empty for .cue files, which are identified by the hash of the .cue file itself
+	return _romFormat == RomFormat::PceCdRom ? _discSha1Hash : "";
+}
+
+bool PceConsole::GetCrc32(uint32_t& crc32)
+{
+	if(_romFormat == RomFormat::PceCdRom && !_discSha1Hash.empty()) {
+		crc32 = _discCrc32;
+		return true;
+	}
+	return false;
+}
+
 bool PceConsole::LoadHesFile(VirtualFile& hesFile)
 {
 	unique_ptr<HesFileData> hesData(new HesFileData());
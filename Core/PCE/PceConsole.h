@@ -37,6 +37,10 @@ private:
 	unique_ptr<HesFileData> _hesData;
 	RomFormat _romFormat = RomFormat::Pce;
 
+	//Hash of the disc's content (CD-ROM games), see CdReader::InitHash
+	string _discSha1Hash;
+	uint32_t _discCrc32 = 0;
+
 	static bool IsPopulousCard(uint32_t crc32);
 	static bool IsSuperGrafxCard(uint32_t crc32);
 
@@ -47,7 +51,7 @@ public:
 	PceConsole(Emulator* emu);
 	virtual ~PceConsole();
 	
-	static vector<string> GetSupportedExtensions() { return { ".pce", ".cue", ".sgx", ".hes" }; }
+	static vector<string> GetSupportedExtensions() { return { ".pce", ".cue", ".chd", ".sgx", ".hes" }; }
 	static vector<string> GetSupportedSignatures() { return { "HESM" }; }
 
 	void Serialize(Serializer& s) override;
@@ -87,6 +91,9 @@ public:
 	PpuFrameInfo GetPpuFrame() override;
 	RomFormat GetRomFormat() override;
 
+	string GetHash(HashType hashType) override;
+	bool GetCrc32(uint32_t& crc32) override;
+
 	void InitHesPlayback(uint8_t selectedTrack);
 	AudioTrackInfo GetAudioTrackInfo() override;
 	void ProcessAudioPlayerAction(AudioPlayerActionParams p) override;
@@ -110,6 +110,52 @@ void MemoryMappings::PeekBlock(uint32_t addr, uint8_t *dest)
 	}
 }
 
+void MemoryMappings::PeekRange(uint32_t addr, uint32_t length, uint8_t* dest)
+{
+	//Resolve the handler once per 4 KB page rather than once per byte
+	while(length > 0) {
+		uint32_t pageOffset = addr & 0xFFF;
+		uint32_t size = std::min<uint32_t>(length, 0x1000 - pageOffset);
+
+		IMemoryHandler* handler = GetHandler(addr);
+		if(!handler) {
+			memset(dest, 0, size);
+		} else if(size == 0x1000) {
+			handler->PeekBlock(addr, dest);
+		} else if(size <= 0x40) {
+			for(uint32_t i = 0; i < size; i++) {
+				dest[i] = handler->Peek(addr + i);
+			}
+		} else {
+			uint8_t block[0x1000];
+			handler->PeekBlock(addr & ~0xFFF, block);
+			memcpy(dest, block + pageOffset, size);
+		}
+
+		addr = (addr + size) & 0xFFFFFF;
+		dest += size;
+		length -= size;
+	}
+}
+
+void MemoryMappings::DebugWriteRange(uint32_t addr, uint32_t length, const uint8_t* src)
+{
+	while(length > 0) {
+		uint32_t size = std::min<uint32_t>(length, 0x1000 - (addr & 0xFFF));
+
+		IMemoryHandler* handler = GetHandler(addr);
+		if(handler) {
+			for(uint32_t i = 0; i < size; i++) {
+				handler->Write(addr + i, src[i]);
+			}
+		}
+
+		addr = (addr + size) & 0xFFFFFF;
+		src += size;
+		length -= size;
+	}
+}
+
 void MemoryMappings::DebugWrite(uint32_t addr, uint8_t value)
 {
 	IMemoryHandler* handler = GetHandler(addr);
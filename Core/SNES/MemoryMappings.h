@@ -20,6 +20,8 @@ public:
 	uint8_t Peek(uint32_t addr);
 	uint16_t PeekWord(uint32_t addr);
 	void PeekBlock(uint32_t addr, uint8_t * dest);
+	void PeekRange(uint32_t addr, uint32_t length, uint8_t* dest);
 
 	void DebugWrite(uint32_t addr, uint8_t value);
+	void DebugWriteRange(uint32_t addr, uint32_t length, const uint8_t* src);
 };
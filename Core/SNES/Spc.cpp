@@ -218,6 +218,29 @@ void Spc::DebugWrite(uint16_t addr, uint8_t value)
 	_ram[addr] = value;
 }
 
+void Spc::DebugReadRange(uint16_t addr, uint32_t length, uint8_t* dest)
+{
+	//Copy RAM directly, then apply the registers and IPL ROM overlays
+	memcpy(dest, _ram + addr, length);
+
+	uint32_t end = addr + length;
+	auto applyOverlay = [=](uint32_t overlayStart, uint32_t overlayEnd) {
+		for(uint32_t i = std::max<uint32_t>(overlayStart, addr); i <= overlayEnd && i < end; i++) {
+			dest[i - addr] = DebugRead((uint16_t)i);
+		}
+	};
+
+	applyOverlay(0xF0, 0xFF);
+	if(_state.RomEnabled) {
+		applyOverlay(0xFFC0, 0xFFFF);
+	}
+}
+
+void Spc::DebugWriteRange(uint16_t addr, uint32_t length, const uint8_t* src)
+{
+	memcpy(_ram + addr, src, length);
+}
+
 void Spc::DebugWriteDspReg(uint8_t addr, uint8_t value)
 {
 	_dsp->Write(addr, value);
@@ -300,6 +300,10 @@ public:
 	uint8_t DebugRead(uint16_t addr);
 	void DebugWrite(uint16_t addr, uint8_t value);
 
+	//Range versions of DebugRead/DebugWrite (addr + length must not exceed $10000)
+	void DebugReadRange(uint16_t addr, uint32_t length, uint8_t* dest);
+	void DebugWriteRange(uint16_t addr, uint32_t length, const uint8_t* src);
+
 	void DebugWriteDspReg(uint8_t addr, uint8_t value);
 
 	uint8_t CpuReadRegister(uint16_t addr);
@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "Shared/CdPrefetcher.h"
+#include "Shared/CdReader.h"
+#include "Shared/MessageManager.h"
+
+CdPrefetcher::CdPrefetcher(DiscInfo& disc)
+{
+	_disc = &disc;
+	_stopFlag = false;
+	_hits = 0;
+	_misses = 0;
+
+	_streams[(int)PrefetchType::Data].SectorSize = DataSectorSize;
+	_streams[(int)PrefetchType::Audio].SectorSize = AudioSectorSize;
+	for(PrefetchStream& stream : _streams) {
+		stream.Data.resize(BufferSectorCount * stream.SectorSize);
+		for(uint32_t i = 0; i < BufferSectorCount; i++) {
+			stream.Sectors[i] = -1;
+		}
+	}
+
+	//The files are read by both the emulation thread and the worker thread,
+	//initialize their size/cache here to avoid doing it from both threads at once
+	for(VirtualFile& file : _disc->Files) {
+		file.GetSize();
+		file.InitChunks();
+	}
+}
+
+CdPrefetcher::~CdPrefetcher()
+{
+	if(_thread) {
+		_stopFlag = true;
+		_signal.Signal();
+		_thread->join();
+		_thread.reset();
+	}
+
+	if(_hits + _misses > 0) {
+		MessageManager::Log("[CD] Sector read-ahead: " + std::to_string(_hits) + " hits, " + std::to_string(_misses) + " misses");
+	}
+}
+
+void CdPrefetcher::PrefetchData(uint32_t startSector, uint32_t sectorCount)
+{
+	if(sectorCount > 0) {
+		SetPosition(PrefetchType::Data, startSector, startSector + sectorCount - 1);
+	}
+}
+
+void CdPrefetcher::PrefetchAudio(uint32_t startSector, uint32_t endSector)
+{
+	SetPosition(PrefetchType::Audio, startSector, endSector);
+}
+
+void CdPrefetcher::SetPosition(PrefetchType type, uint32_t startSector, uint32_t endSector)
+{
+	{
+		auto lock = _lock.AcquireSafe();
+		PrefetchStream& stream = _streams[(int)type];
+		stream.Active = true;
+		stream.Position = startSector;
+		stream.EndSector = endSector;
+	}
+
+	if(!_thread) {
+		_thread.reset(new std::thread(&CdPrefetcher::WorkerThread, this));
+	}
+	_signal.Signal();
+}
+
+void CdPrefetcher::ReadDataSector(uint32_t sector, uint8_t* out)
+{
+	ReadSector(PrefetchType::Data, sector, out);
+}
+
+void CdPrefetcher::ReadAudioSector(uint32_t sector, int16_t* outSamples)
+{
+	ReadSector(PrefetchType::Audio, sector, (uint8_t*)outSamples);
+}
+
+void CdPrefetcher::ReadSector(PrefetchType type, uint32_t sector, uint8_t* out)
+{
+	bool hit;
+	{
+		auto lock = _lock.AcquireSafe();
+		PrefetchStream& stream = _streams[(int)type];
+		uint32_t slot = sector % BufferSectorCount;
+		hit = stream.Sectors[slot] == sector;
+		if(hit) {
+			memcpy(out, stream.Data.data() + slot * stream.SectorSize, stream.SectorSize);
+		}
+
+		if(stream.Active) {
+			//Move the read-ahead window forward, the next sectors are expected to be read next
+			stream.Position = sector + 1;
+		}
+	}
+
+	if(hit) {
+		_hits++;
+	} else {
+		_misses++;
+		ReadFromDisc(type, sector, out);
+	}
+
+	if(_thread) {
+		_signal.Signal();
+	}
+}
+
+void CdPrefetcher::ReadFromDisc(PrefetchType type, uint32_t sector, uint8_t* out)
+{
+	if(type == PrefetchType::Data) {
+		_disc->ReadDataSector(sector, out);
+	} else {
+		_disc->ReadAudioSamples(sector, 0, 588, (int16_t*)out);
+	}
+}
+
+bool CdPrefetcher::GetNextSectorToRead(PrefetchType& type, uint32_t& sector)
+{
+	auto lock = _lock.AcquireSafe();
+
+	//Data reads have priority over audio
+	for(int i = 0; i < 2; i++) {
+		PrefetchStream& stream = _streams[i];
+		if(!stream.Active || stream.Position > stream.EndSector) {
+			continue;
+		}
+
+		uint32_t lastSector = std::min(stream.EndSector, stream.Position + BufferSectorCount - 1);
+		for(uint32_t s = stream.Position; s <= lastSector; s++) {
+			if(stream.Sectors[s % BufferSectorCount] != s) {
+				type = (PrefetchType)i;
+				sector = s;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CdPrefetcher::WorkerThread()
+{
+	vector<uint8_t> buffer(std::max(DataSectorSize, AudioSectorSize));
+
+	while(!_stopFlag) {
+		_signal.Wait();
+
+		PrefetchType type;
+		uint32_t sector;
+		while(!_stopFlag && GetNextSectorToRead(type, sector)) {
+			ReadFromDisc(type, sector, buffer.data());
+
+			auto lock = _lock.AcquireSafe();
+			PrefetchStream& stream = _streams[(int)type];
+
+			//The emulation may have moved past this sector (or jumped elsewhere) while it was being read
+			if(sector >= stream.Position && sector - stream.Position < BufferSectorCount) {
+				uint32_t slot = sector % BufferSectorCount;
+				memcpy(stream.Data.data() + slot * stream.SectorSize, buffer.data(), stream.SectorSize);
+				stream.Sectors[slot] = sector;
+			}
+		}
+	}
+}
+
+CdPrefetchStats CdPrefetcher::GetStats()
+{
+	CdPrefetchStats stats = {};
+	stats.Hits = _hits;
+	stats.Misses = _misses;
+	return stats;
+}
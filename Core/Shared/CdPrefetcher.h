@@ -0,0 +1,77 @@
+#pragma once
+#include "pch.h"
+#include <thread>
+#include "Utilities/SimpleLock.h"
+#include "Utilities/AutoResetEvent.h"
+
+struct DiscInfo;
+
+struct CdPrefetchStats
+{
+	uint64_t Hits;
+	uint64_t Misses;
+};
+
+//Reads the sectors the emulated drive is about to need on a worker thread, so that
+//the emulation thread doesn't have to wait for the disk when it reads them
+class CdPrefetcher
+{
+private:
+	static constexpr uint32_t BufferSectorCount = 64;
+	static constexpr uint32_t AudioSectorSize = 588 * 2 * sizeof(int16_t);
+	static constexpr uint32_t DataSectorSize = 2048;
+
+	enum class PrefetchType
+	{
+		Data = 0,
+		Audio = 1
+	};
+
+	struct PrefetchStream
+	{
+		uint32_t SectorSize = 0;
+		bool Active = false;
+
+		//Next sector the emulation is expected to read, and last sector to read ahead
+		uint32_t Position = 0;
+		uint32_t EndSector = 0;
+
+		//Ring buffer - a sector is stored in slot [sector % BufferSectorCount]
+		int64_t Sectors[BufferSectorCount] = {};
+		vector<uint8_t> Data;
+	};
+
+	DiscInfo* _disc = nullptr;
+	PrefetchStream _streams[2];
+
+	unique_ptr<std::thread> _thread;
+	SimpleLock _lock;
+	AutoResetEvent _signal;
+	atomic<bool> _stopFlag;
+
+	atomic<uint64_t> _hits;
+	atomic<uint64_t> _misses;
+
+	void WorkerThread();
+	bool GetNextSectorToRead(PrefetchType& type, uint32_t& sector);
+	void ReadFromDisc(PrefetchType type, uint32_t sector, uint8_t* out);
+
+	void SetPosition(PrefetchType type, uint32_t startSector, uint32_t endSector);
+	void ReadSector(PrefetchType type, uint32_t sector, uint8_t* out);
+
+public:
+	CdPrefetcher(DiscInfo& disc);
+	~CdPrefetcher();
+
+	//Called when the drive starts reading data sectors or playing audio, to start reading ahead
+	void PrefetchData(uint32_t startSector, uint32_t sectorCount);
+	void PrefetchAudio(uint32_t startSector, uint32_t endSector);
+
+	//Reads the 2048 bytes of data of a sector
+	void ReadDataSector(uint32_t sector, uint8_t* out);
+
+	//Reads the 588 stereo samples (interleaved left/right) of an audio sector
+	void ReadAudioSector(uint32_t sector, int16_t* outSamples);
+
+	CdPrefetchStats GetStats();
+};
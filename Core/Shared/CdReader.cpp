@@ -3,6 +3,8 @@
 #include "Shared/MessageManager.h"
 #include "Utilities/StringUtilities.h"
 #include "Utilities/FolderUtilities.h"
+#include "Utilities/CRC32.h"
+#include "Utilities/sha1.h"
 #include "Utilities/magic_enum.hpp"
 
 struct CueIndexEntry
@@ -241,6 +243,143 @@ bool CdReader::LoadCue(VirtualFile& cueFile, DiscInfo& disc)
 	disc.DiscSectorCount = discLastTrk.LastSector + 1;
 	disc.EndPosition = DiscPosition::FromLba(disc.DiscSectorCount + 2 * 75);
 
+	LogTracks(disc);
+
+	return disc.Tracks.size() > 0;
+}
+
+bool CdReader::LoadChd(VirtualFile& file, DiscInfo& disc)
+{
+	disc.Chd = ChdReader::Create(file);
+	if(!disc.Chd) {
+		return false;
+	}
+
+	//ChdReader only accepts files whose hunks contain whole CD frames
+	ChdReader& chd = *disc.Chd;
+
+	string metadata;
+	uint32_t metadataTag = ChdReader::MetadataCdTrack;
+	if(!chd.GetMetadata(metadataTag, 0, metadata)) {
+		metadataTag = ChdReader::MetadataCdTrackOld;
+	}
+
+	uint32_t logicalSector = 0;
+	uint32_t chdFrame = 0;
+	for(uint32_t i = 0; chd.GetMetadata(metadataTag, i, metadata); i++) {
+		//e.g: TRACK:2 TYPE:MODE1_RAW SUBTYPE:NONE FRAMES:1234 PREGAP:150 PGTYPE:VMODE1_RAW PGSUB:RW POSTGAP:0
+		unordered_map<string, string> values;
+		for(string& entry : StringUtilities::Split(metadata, ' ')) {
+			size_t pos = entry.find(':');
+			if(pos != string::npos) {
+				values[entry.substr(0, pos)] = entry.substr(pos + 1);
+			}
+		}
+
+		uint32_t frames = 0;
+		uint32_t pregap = 0;
+		uint32_t postgap = 0;
+		try {
+			frames = std::stoi(values["FRAMES"]);
+			pregap = values["PREGAP"].empty() ? 0 : std::stoi(values["PREGAP"]);
+			postgap = values["POSTGAP"].empty() ? 0 : std::stoi(values["POSTGAP"]);
+		} catch(const std::exception&) {
+			MessageManager::Log("[CHD] Invalid track metadata: " + metadata);
+			return false;
+		}
+
+		TrackInfo trk = {};
+		string type = values["TYPE"];
+		if(type == "AUDIO") {
+			trk.Format = TrackFormat::Audio;
+		} else if(type == "MODE1_RAW") {
+			trk.Format = TrackFormat::Mode1_2352;
+		} else if(type == "MODE1") {
+			trk.Format = TrackFormat::Mode1_2048;
+		} else {
+			MessageManager::Log("[CHD] Unsupported track format: " + type);
+			return false;
+		}
+
+		//When the pregap type starts with "V", the pregap's sectors are stored in the file, at the start of the track.
+		//Otherwise, the pregap isn't stored in the file (silence) and only shifts the track's position on the disc
+		bool pregapInFile = values["PGTYPE"].size() > 0 && values["PGTYPE"][0] == 'V';
+		uint32_t fileFrames = frames;
+		if(pregapInFile) {
+			if(pregap > frames) {
+				MessageManager::Log("[CHD] Invalid track metadata: " + metadata);
+				return false;
+			}
+			fileFrames -= pregap;
+		}
+
+		if(pregap > 0) {
+			trk.HasLeadIn = true;
+			trk.LeadInPosition = DiscPosition::FromLba(logicalSector);
+		}
+
+		trk.FirstSector = logicalSector + pregap;
+		trk.StartPosition = DiscPosition::FromLba(trk.FirstSector);
+		trk.SectorCount = fileFrames;
+		trk.LastSector = trk.FirstSector + trk.SectorCount - 1;
+		trk.EndPosition = DiscPosition::FromLba(trk.LastSector);
+		trk.Size = trk.SectorCount * trk.GetSectorSize();
+		trk.FileIndex = 0;
+		trk.FileOffset = (chdFrame + (pregapInFile ? pregap : 0)) * ChdReader::CdFrameSize;
+
+		if(fileFrames == 0 || (uint64_t)trk.FileOffset + (uint64_t)fileFrames * ChdReader::CdFrameSize > chd.GetLogicalSize()) {
+			MessageManager::Log("[CHD] Invalid track metadata: " + metadata);
+			return false;
+		}
+
+		disc.Tracks.push_back(trk);
+
+		logicalSector = trk.LastSector + 1 + postgap;
+
+		//Each track is padded to a multiple of 4 frames in the file
+		chdFrame += (frames + 3) / 4 * 4;
+	}
+
+	if(disc.Tracks.empty()) {
+		MessageManager::Log("[CHD] No CD track information found");
+		return false;
+	}
+
+	TrackInfo& discLastTrk = disc.Tracks[disc.Tracks.size() - 1];
+	disc.DiscSectorCount = discLastTrk.LastSector + 1;
+	disc.DiscSize = disc.DiscSectorCount * DiscInfo::SectorSize;
+	disc.EndPosition = DiscPosition::FromLba(disc.DiscSectorCount + 2 * 75);
+
+	InitHash(disc);
+	LogTracks(disc);
+
+	return true;
+}
+
+void CdReader::InitHash(DiscInfo& disc)
+{
+	//Hashing the .chd file would require reading (and keeping) the entire image - instead, hash the track
+	//layout and the first sectors of each data track, which is enough to identify a disc.
+	//.cue files keep using the hash of the .cue file itself, to stay compatible with existing CDL files, movies, etc.
+	vector<uint8_t> hashData;
+	for(TrackInfo& trk : disc.Tracks) {
+		uint32_t values[3] = { trk.FirstSector, trk.LastSector, trk.Format == TrackFormat::Audio ? 0u : 1u };
+		hashData.insert(hashData.end(), (uint8_t*)values, (uint8_t*)values + sizeof(values));
+
+		if(trk.Format != TrackFormat::Audio) {
+			uint32_t sectorCount = std::min(trk.SectorCount, CdReader::HashedSectorCount);
+			size_t start = hashData.size();
+			hashData.resize(start + sectorCount * 2048);
+			disc.ReadDataSectors(trk.FirstSector, sectorCount, hashData.data() + start);
+		}
+	}
+
+	disc.Sha1Hash = SHA1::GetHash(hashData);
+	disc.Crc32 = CRC32::GetCRC(hashData);
+}
+
+void CdReader::LogTracks(DiscInfo& disc)
+{
 	MessageManager::Log("---- DISC TRACKS ----");
 	int i = 1;
 	for(TrackInfo& trk : disc.Tracks) {
@@ -254,6 +393,4 @@ bool CdReader::LoadCue(VirtualFile& cueFile, DiscInfo& disc)
 		i++;
 	}
 	MessageManager::Log("---- END TRACKS ----");
-
-	return disc.Tracks.size() > 0;
 }
@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "Utilities/VirtualFile.h"
 #include "Shared/MessageManager.h"
+#include "Shared/ChdReader.h"
 
 enum class TrackFormat
 {
@@ -79,11 +80,16 @@ struct DiscInfo
 	static constexpr int SectorSize = 2352;
 
 	vector<VirtualFile> Files;
+	shared_ptr<ChdReader> Chd; //Set for CHD images - the tracks are read from it instead of Files
 	vector<TrackInfo> Tracks;
 	uint32_t DiscSize;
 	uint32_t DiscSectorCount;
 	DiscPosition EndPosition;
 
+	//Identifies the disc's content without reading the whole image (.chd files only, see CdReader::InitHash)
+	string Sha1Hash;
+	uint32_t Crc32;
+
 	int32_t GetTrack(uint32_t sector)
 	{
 		for(size_t i = 0; i < Tracks.size(); i++) {
@@ -116,8 +122,8 @@ struct DiscInfo
 		return -1;
 	}
 
-	template<typename T>
-	void ReadDataSector(uint32_t sector, T& outData)
+	//Reads the 2048 bytes of data contained in a sector
+	bool ReadDataSector(uint32_t sector, uint8_t* outData)
 	{
 		constexpr int Mode1_2352_SectorHeaderSize = 16;
 
@@ -125,46 +131,95 @@ struct DiscInfo
 		if(track < 0) {
 			//TODO support reading pregap when it's available
 			LogDebug("Invalid sector/track (or inside pregap)");
-			outData.insert(outData.end(), 2048, 0);
-		} else {
-			TrackInfo& trk = Tracks[track];
-			uint32_t sectorSize = trk.GetSectorSize();
-			uint32_t sectorHeaderSize = trk.Format == TrackFormat::Mode1_2352 ? Mode1_2352_SectorHeaderSize : 0;
-			uint32_t byteOffset = trk.FileOffset + (sector - trk.FirstSector) * sectorSize;
-			if(!Files[trk.FileIndex].ReadChunk(outData, byteOffset + sectorHeaderSize, 2048)) {
-				LogDebug("Invalid read offsets");
-			}
+			memset(outData, 0, 2048);
+			return false;
+		}
+
+		TrackInfo& trk = Tracks[track];
+		uint32_t sectorHeaderSize = trk.Format == TrackFormat::Mode1_2352 ? Mode1_2352_SectorHeaderSize : 0;
+		if(!ReadTrackData(trk, sector, sectorHeaderSize, outData, 2048)) {
+			//e.g truncated .bin file - the output must still be deterministic
+			LogDebug("Invalid read offsets");
+			memset(outData, 0, 2048);
+			return false;
 		}
+		return true;
 	}
 
-	int16_t ReadAudioSample(uint32_t sector, uint32_t sample, uint32_t byteOffset)
+	//Reads the data of consecutive sectors, 2048 bytes per sector
+	bool ReadDataSectors(uint32_t sector, uint32_t sectorCount, uint8_t* outData)
 	{
-		int32_t track = GetTrack(sector);
-		if(track < 0) {
-			LogDebug("Invalid sector/track");
-			return 0;
+		bool result = true;
+		for(uint32_t i = 0; i < sectorCount; i++) {
+			result &= ReadDataSector(sector + i, outData + i * 2048);
 		}
+		return result;
+	}
 
-		uint32_t fileIndex = Tracks[track].FileIndex;
-		uint32_t startByte = Tracks[track].FileOffset + (sector - Tracks[track].FirstSector) * DiscInfo::SectorSize;
-		return (int16_t)(Files[fileIndex].ReadByte(startByte + sample * 4 + byteOffset) | (Files[fileIndex].ReadByte(startByte + sample * 4 + 1 + byteOffset) << 8));
+	template<typename T>
+	void ReadDataSector(uint32_t sector, T& outData)
+	{
+		uint8_t data[2048];
+		ReadDataSector(sector, data);
+		outData.insert(outData.end(), data, data + 2048);
 	}
 
-	int16_t ReadLeftSample(uint32_t sector, uint32_t sample)
+	//Reads sampleCount stereo samples (interleaved left/right 16-bit values) from an audio sector
+	void ReadAudioSamples(uint32_t sector, uint32_t startSample, uint32_t sampleCount, int16_t* outSamples)
 	{
-		return ReadAudioSample(sector, sample, 0);
+		int32_t track = GetTrack(sector);
+		uint8_t data[DiscInfo::SectorSize];
+		uint32_t byteCount = sampleCount * 4;
+		if(track < 0 || startSample * 4 + byteCount > DiscInfo::SectorSize) {
+			LogDebug("Invalid sector/track");
+			memset(outSamples, 0, byteCount);
+			return;
+		}
+
+		if(!ReadTrackData(Tracks[track], sector, startSample * 4, data, byteCount)) {
+			memset(outSamples, 0, byteCount);
+			return;
+		}
+
+		if(Chd) {
+			//CHD files store audio samples in big endian order
+			for(uint32_t i = 0; i < sampleCount * 2; i++) {
+				outSamples[i] = (int16_t)((data[i * 2] << 8) | data[i * 2 + 1]);
+			}
+		} else {
+			for(uint32_t i = 0; i < sampleCount * 2; i++) {
+				outSamples[i] = (int16_t)(data[i * 2] | (data[i * 2 + 1] << 8));
+			}
+		}
 	}
 
-	int16_t ReadRightSample(uint32_t sector, uint32_t sample)
+private:
+	//Reads bytes from a sector of a track, starting at the given offset within the sector
+	bool ReadTrackData(TrackInfo& trk, uint32_t sector, uint32_t offset, uint8_t* out, uint32_t length)
 	{
-		return ReadAudioSample(sector, sample, 2);
+		if(Chd) {
+			//Each frame in a CHD file contains 2352 bytes of sector data + 96 bytes of subcode data, regardless of the track's format
+			uint64_t byteOffset = trk.FileOffset + (uint64_t)(sector - trk.FirstSector) * ChdReader::CdFrameSize + offset;
+			return Chd->ReadBytes(byteOffset, out, length);
+		}
+
+		uint32_t byteOffset = trk.FileOffset + (sector - trk.FirstSector) * trk.GetSectorSize() + offset;
+		return Files[trk.FileIndex].ReadBytes(byteOffset, out, length);
 	}
 };
 
 class CdReader
 {
+private:
+	//Number of sectors at the start of each data track that are included in the disc's hash
+	static constexpr uint32_t HashedSectorCount = 16;
+
+	static void LogTracks(DiscInfo& disc);
+	static void InitHash(DiscInfo& disc);
+
 public:
 	static bool LoadCue(VirtualFile& file, DiscInfo& disc);
+	static bool LoadChd(VirtualFile& file, DiscInfo& disc);
 
 	static uint8_t ToBcd(uint8_t value)
 	{
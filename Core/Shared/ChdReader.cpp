@@ -0,0 +1,754 @@
+#include "pch.h"
+#include "Shared/ChdReader.h"
+#include "Shared/MessageManager.h"
+#include "Utilities/miniz.h"
+#include "SevenZip/LzmaDec.h"
+
+static uint16_t ReadBe16(const uint8_t* data)
+{
+	return (data[0] << 8) | data[1];
+}
+
+static uint32_t ReadBe24(const uint8_t* data)
+{
+	return (data[0] << 16) | (data[1] << 8) | data[2];
+}
+
+static uint32_t ReadBe32(const uint8_t* data)
+{
+	return ((uint32_t)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint64_t ReadBe48(const uint8_t* data)
+{
+	return ((uint64_t)ReadBe16(data) << 32) | ReadBe32(data + 2);
+}
+
+static uint64_t ReadBe64(const uint8_t* data)
+{
+	return ((uint64_t)ReadBe32(data) << 32) | ReadBe32(data + 4);
+}
+
+//MSB-first bit reader used by the compressed hunk map - reading past the end returns 0s
+class ChdBitReader
+{
+private:
+	const uint8_t* _data;
+	uint32_t _size;
+	uint32_t _bitPos = 0;
+
+public:
+	ChdBitReader(const uint8_t* data, uint32_t size)
+	{
+		_data = data;
+		_size = size;
+	}
+
+	uint32_t Peek(uint32_t count)
+	{
+		uint32_t value = 0;
+		for(uint32_t i = 0; i < count; i++) {
+			uint32_t pos = _bitPos + i;
+			uint32_t bit = (pos >> 3) < _size ? ((_data[pos >> 3] >> (7 - (pos & 0x07))) & 0x01) : 0;
+			value = (value << 1) | bit;
+		}
+		return value;
+	}
+
+	void Skip(uint32_t count)
+	{
+		_bitPos += count;
+	}
+
+	uint32_t Read(uint32_t count)
+	{
+		uint32_t value = Peek(count);
+		_bitPos += count;
+		return value;
+	}
+};
+
+//Canonical huffman decoder used by the compressed hunk map (16 codes, up to 8 bits per code)
+class ChdHuffmanDecoder
+{
+private:
+	static constexpr uint32_t CodeCount = 16;
+	static constexpr uint32_t MaxBits = 8;
+
+	uint8_t _codeBits[CodeCount] = {};
+	uint16_t _lookup[1 << MaxBits] = {};
+
+public:
+	bool ImportTree(ChdBitReader& reader)
+	{
+		//Code lengths are RLE-encoded
+		for(uint32_t code = 0; code < CodeCount;) {
+			uint32_t bits = reader.Read(4);
+			if(bits != 1) {
+				_codeBits[code++] = bits;
+			} else {
+				bits = reader.Read(4);
+				if(bits == 1) {
+					_codeBits[code++] = bits;
+				} else {
+					uint32_t repeat = reader.Read(4) + 3;
+					if(code + repeat > CodeCount) {
+						return false;
+					}
+					while(repeat--) {
+						_codeBits[code++] = bits;
+					}
+				}
+			}
+		}
+
+		//Assign canonical codes
+		uint32_t histogram[33] = {};
+		for(uint32_t code = 0; code < CodeCount; code++) {
+			if(_codeBits[code] > MaxBits) {
+				return false;
+			}
+			histogram[_codeBits[code]]++;
+		}
+
+		uint32_t start = 0;
+		for(int32_t length = 32; length > 0; length--) {
+			uint32_t next = (start + histogram[length]) >> 1;
+			if(length != 1 && next * 2 != start + histogram[length]) {
+				return false;
+			}
+			histogram[length] = start;
+			start = next;
+		}
+
+		//Build lookup table (code << 5 | length)
+		for(uint32_t code = 0; code < CodeCount; code++) {
+			uint32_t length = _codeBits[code];
+			if(length > 0) {
+				uint32_t shift = MaxBits - length;
+				uint32_t first = histogram[length]++ << shift;
+				if(first + (1u << shift) > (1u << MaxBits)) {
+					//Over-subscribed tree (e.g. more than 2 codes of length 1), the codes don't fit in the table
+					return false;
+				}
+				for(uint32_t i = 0; i < (1u << shift); i++) {
+					_lookup[first + i] = (code << 5) | length;
+				}
+			}
+		}
+		return true;
+	}
+
+	uint32_t Decode(ChdBitReader& reader)
+	{
+		uint16_t entry = _lookup[reader.Peek(MaxBits)];
+		reader.Skip(entry & 0x1F);
+		return entry >> 5;
+	}
+};
+
+ChdReader::ChdReader(VirtualFile& file)
+{
+	_file = file;
+}
+
+unique_ptr<ChdReader> ChdReader::Create(VirtualFile& file)
+{
+	unique_ptr<ChdReader> chd(new ChdReader(file));
+	if(!chd->ReadHeader() || !chd->ReadMap()) {
+		return nullptr;
+	}
+	return chd;
+}
+
+bool ChdReader::ReadFileData(uint64_t offset, uint8_t* out, uint32_t length)
+{
+	uint64_t fileSize = _file.GetSize();
+	if(offset > fileSize || length > fileSize - offset) {
+		return false;
+	}
+	return _file.ReadBytes((uint32_t)offset, out, length);
+}
+
+bool ChdReader::ReadHeader()
+{
+	uint8_t header[ChdReader::HeaderSize];
+	if(!ReadFileData(0, header, 16) || memcmp(header, "MComprHD", 8) != 0) {
+		MessageManager::Log("[CHD] Invalid file header");
+		return false;
+	}
+
+	uint32_t version = ReadBe32(header + 12);
+	if(version != 5) {
+		MessageManager::Log("[CHD] Unsupported version: " + std::to_string(version) + " (only v5 files are supported)");
+		return false;
+	}
+
+	if(!ReadFileData(0, header, ChdReader::HeaderSize)) {
+		MessageManager::Log("[CHD] Invalid file header");
+		return false;
+	}
+
+	for(int i = 0; i < 4; i++) {
+		_codecs[i] = (ChdCodec)ReadBe32(header + 16 + i * 4);
+	}
+	_logicalBytes = ReadBe64(header + 32);
+	_metaOffset = ReadBe64(header + 48);
+	_hunkBytes = ReadBe32(header + 56);
+	_unitBytes = ReadBe32(header + 60);
+
+	if(_hunkBytes == 0 || _unitBytes == 0 || _hunkBytes % _unitBytes != 0 || _hunkBytes > ChdReader::MaxHunkSize) {
+		MessageManager::Log("[CHD] Invalid hunk size");
+		return false;
+	}
+
+	if(_hunkBytes % ChdReader::CdFrameSize != 0 || _logicalBytes == 0 || _logicalBytes > ChdReader::MaxLogicalSize) {
+		MessageManager::Log("[CHD] File is not a CD image");
+		return false;
+	}
+	_hunkCount = (uint32_t)((_logicalBytes + _hunkBytes - 1) / _hunkBytes);
+
+	for(int i = 104; i < 124; i++) {
+		if(header[i] != 0) {
+			MessageManager::Log("[CHD] Files that depend on a parent CHD file are not supported");
+			return false;
+		}
+	}
+
+	for(ChdCodec codec : _codecs) {
+		switch(codec) {
+			case ChdCodec::None:
+			case ChdCodec::Zlib:
+			case ChdCodec::Lzma:
+			case ChdCodec::CdZlib:
+			case ChdCodec::CdLzma:
+			case ChdCodec::CdFlac:
+				break;
+
+			default: {
+				uint32_t code = (uint32_t)codec;
+				string name = { (char)(code >> 24), (char)(code >> 16), (char)(code >> 8), (char)code };
+				MessageManager::Log("[CHD] Unsupported compression codec: " + name);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool ChdReader::ReadMap()
+{
+	uint8_t header[ChdReader::HeaderSize];
+	ReadFileData(0, header, ChdReader::HeaderSize);
+	uint64_t mapOffset = ReadBe64(header + 40);
+
+	_map.resize(_hunkCount);
+	_compressedMap = _codecs[0] != ChdCodec::None;
+
+	if(_compressedMap) {
+		return ReadCompressedMap(mapOffset);
+	}
+
+	//Uncompressed files: 4 bytes per hunk, the hunk's offset in the file (in hunk units) - 0 means the hunk is empty
+	vector<uint8_t> rawMap((size_t)_hunkCount * 4);
+	if(!ReadFileData(mapOffset, rawMap.data(), (uint32_t)rawMap.size())) {
+		MessageManager::Log("[CHD] Invalid hunk map");
+		return false;
+	}
+
+	for(uint32_t i = 0; i < _hunkCount; i++) {
+		_map[i].Type = ChdHunkType::Uncompressed;
+		_map[i].Offset = (uint64_t)ReadBe32(rawMap.data() + (size_t)i * 4) * _hunkBytes;
+		_map[i].Length = _hunkBytes;
+		_map[i].Crc = 0;
+	}
+	return true;
+}
+
+bool ChdReader::ReadCompressedMap(uint64_t mapOffset)
+{
+	uint8_t mapHeader[16];
+	if(!ReadFileData(mapOffset, mapHeader, sizeof(mapHeader))) {
+		MessageManager::Log("[CHD] Invalid hunk map");
+		return false;
+	}
+
+	uint32_t mapSize = ReadBe32(mapHeader);
+	uint64_t firstOffset = ReadBe48(mapHeader + 4);
+	uint16_t mapCrc = ReadBe16(mapHeader + 10);
+	uint8_t lengthBits = mapHeader[12];
+	uint8_t selfBits = mapHeader[13];
+	uint8_t parentBits = mapHeader[14];
+
+	uint64_t fileSize = _file.GetSize();
+	if(mapOffset + 16 > fileSize || mapSize > fileSize - mapOffset - 16) {
+		MessageManager::Log("[CHD] Invalid hunk map");
+		return false;
+	}
+
+	vector<uint8_t> mapData(mapSize);
+	if(!ReadFileData(mapOffset + 16, mapData.data(), mapSize)) {
+		MessageManager::Log("[CHD] Invalid hunk map");
+		return false;
+	}
+
+	ChdBitReader reader(mapData.data(), mapSize);
+	ChdHuffmanDecoder decoder;
+	if(!decoder.ImportTree(reader)) {
+		MessageManager::Log("[CHD] Invalid hunk map");
+		return false;
+	}
+
+	//The hunk types are huffman + RLE encoded first
+	uint8_t lastType = 0;
+	uint32_t repeatCount = 0;
+	for(uint32_t i = 0; i < _hunkCount; i++) {
+		if(repeatCount > 0) {
+			repeatCount--;
+		} else {
+			uint8_t value = (uint8_t)decoder.Decode(reader);
+			if(value == (uint8_t)ChdHunkType::RleSmall) {
+				repeatCount = 2 + decoder.Decode(reader);
+			} else if(value == (uint8_t)ChdHunkType::RleLarge) {
+				repeatCount = 2 + 16 + (decoder.Decode(reader) << 4);
+				repeatCount += decoder.Decode(reader);
+			} else {
+				lastType = value;
+			}
+		}
+		_map[i].Type = (ChdHunkType)lastType;
+	}
+
+	//Followed by the offset/length/crc of each hunk
+	//The map's CRC is calculated on the decoded map, with 12 bytes per hunk
+	vector<uint8_t> rawMap((size_t)_hunkCount * 12);
+	uint64_t currentOffset = firstOffset;
+	uint64_t lastSelf = 0;
+	uint64_t lastParent = 0;
+	for(uint32_t i = 0; i < _hunkCount; i++) {
+		HunkMapEntry& entry = _map[i];
+		entry.Offset = currentOffset;
+		entry.Length = 0;
+		entry.Crc = 0;
+
+		switch(entry.Type) {
+			case ChdHunkType::Codec0:
+			case ChdHunkType::Codec1:
+			case ChdHunkType::Codec2:
+			case ChdHunkType::Codec3:
+				entry.Length = reader.Read(lengthBits);
+				currentOffset += entry.Length;
+				entry.Crc = reader.Read(16);
+				break;
+
+			case ChdHunkType::Uncompressed:
+				entry.Length = _hunkBytes;
+				currentOffset += entry.Length;
+				entry.Crc = reader.Read(16);
+				break;
+
+			case ChdHunkType::Self:
+				entry.Offset = lastSelf = reader.Read(selfBits);
+				break;
+
+			case ChdHunkType::Parent:
+				entry.Offset = lastParent = reader.Read(parentBits);
+				break;
+
+			case ChdHunkType::Self1:
+				lastSelf++;
+				[[fallthrough]];
+			case ChdHunkType::Self0:
+				entry.Type = ChdHunkType::Self;
+				entry.Offset = lastSelf;
+				break;
+
+			case ChdHunkType::ParentSelf:
+				entry.Type = ChdHunkType::Parent;
+				entry.Offset = lastParent = (uint64_t)i * _hunkBytes / _unitBytes;
+				break;
+
+			case ChdHunkType::Parent1:
+				lastParent += _hunkBytes / _unitBytes;
+				[[fallthrough]];
+			case ChdHunkType::Parent0:
+				entry.Type = ChdHunkType::Parent;
+				entry.Offset = lastParent;
+				break;
+
+			default:
+				MessageManager::Log("[CHD] Invalid hunk map");
+				return false;
+		}
+
+		//Lengths are used to allocate the decompression buffer, so they are validated here rather than when the hunk is read
+		bool inFile = entry.Type != ChdHunkType::Self && entry.Type != ChdHunkType::Parent;
+		if(inFile && (entry.Length > _hunkBytes + ChdReader::MaxCodecHeaderSize || entry.Offset > fileSize || entry.Length > fileSize - entry.Offset)) {
+			MessageManager::Log("[CHD] Invalid hunk map");
+			return false;
+		}
+
+		uint8_t* raw = rawMap.data() + (size_t)i * 12;
+		raw[0] = (uint8_t)entry.Type;
+		for(int j = 0; j < 3; j++) {
+			raw[1 + j] = (uint8_t)(entry.Length >> (16 - j * 8));
+		}
+		for(int j = 0; j < 6; j++) {
+			raw[4 + j] = (uint8_t)(entry.Offset >> (40 - j * 8));
+		}
+		raw[10] = entry.Crc >> 8;
+		raw[11] = (uint8_t)entry.Crc;
+	}
+
+	if(GetCrc16(rawMap.data(), (uint32_t)rawMap.size()) != mapCrc) {
+		MessageManager::Log("[CHD] Invalid hunk map (CRC mismatch)");
+		return false;
+	}
+
+	return true;
+}
+
+bool ChdReader::GetMetadata(uint32_t tag, uint32_t index, string& out)
+{
+	auto lock = _lock.AcquireSafe();
+
+	uint64_t offset = _metaOffset;
+	for(int i = 0; offset != 0 && i < 10000; i++) {
+		uint8_t header[16];
+		if(!ReadFileData(offset, header, sizeof(header))) {
+			return false;
+		}
+
+		uint32_t entryTag = ReadBe32(header);
+		uint32_t length = ReadBe24(header + 5);
+		if(entryTag == tag) {
+			if(index == 0) {
+				vector<uint8_t> data(length);
+				if(!ReadFileData(offset + 16, data.data(), length)) {
+					return false;
+				}
+				out = string(data.begin(), std::find(data.begin(), data.end(), 0));
+				return true;
+			}
+			index--;
+		}
+		offset = ReadBe64(header + 8);
+	}
+	return false;
+}
+
+bool ChdReader::ReadBytes(uint64_t offset, uint8_t* out, uint32_t length)
+{
+	auto lock = _lock.AcquireSafe();
+
+	bool result = true;
+	while(length > 0) {
+		uint32_t hunkIndex = (uint32_t)(offset / _hunkBytes);
+		uint32_t hunkOffset = (uint32_t)(offset % _hunkBytes);
+		uint32_t count = std::min(length, _hunkBytes - hunkOffset);
+
+		CachedHunk* hunk = hunkIndex < _hunkCount ? GetHunk(hunkIndex) : nullptr;
+		if(hunk) {
+			memcpy(out, hunk->Data.data() + hunkOffset, count);
+		} else {
+			memset(out, 0, count);
+			result = false;
+		}
+
+		out += count;
+		offset += count;
+		length -= count;
+	}
+	return result;
+}
+
+ChdReader::CachedHunk* ChdReader::GetHunk(uint32_t hunkIndex)
+{
+	_accessCounter++;
+
+	//Consecutive reads usually hit the same hunk
+	if(_lastHunkIndex < _cache.size() && _cache[_lastHunkIndex].Id == hunkIndex) {
+		_cache[_lastHunkIndex].LastAccess = _accessCounter;
+		return &_cache[_lastHunkIndex];
+	}
+
+	uint32_t index = 0;
+	for(size_t i = 0; i < _cache.size(); i++) {
+		if(_cache[i].Id == hunkIndex) {
+			_cache[i].LastAccess = _accessCounter;
+			_lastHunkIndex = (uint32_t)i;
+			return &_cache[i];
+		}
+		if(_cache[i].LastAccess < _cache[index].LastAccess) {
+			index = (uint32_t)i;
+		}
+	}
+
+	//Not cached yet, decompress it (replacing the least recently used hunk if the cache is full)
+	if(_cache.size() < ChdReader::MaxCachedHunks) {
+		index = (uint32_t)_cache.size();
+		_cache.push_back({});
+		_cache[index].Data.resize(_hunkBytes);
+	}
+
+	CachedHunk& hunk = _cache[index];
+	if(!ReadHunk(hunkIndex, hunk.Data.data())) {
+		MessageManager::Log("[CHD] Could not read hunk " + std::to_string(hunkIndex));
+		hunk.Id = UINT32_MAX;
+		hunk.LastAccess = 0;
+		return nullptr;
+	}
+
+	hunk.Id = hunkIndex;
+	hunk.LastAccess = _accessCounter;
+	_lastHunkIndex = index;
+	return &hunk;
+}
+
+bool ChdReader::ReadHunk(uint32_t hunkIndex, uint8_t* out, uint32_t depth)
+{
+	HunkMapEntry& entry = _map[hunkIndex];
+	switch(entry.Type) {
+		case ChdHunkType::Codec0:
+		case ChdHunkType::Codec1:
+		case ChdHunkType::Codec2:
+		case ChdHunkType::Codec3:
+			_compressedData.resize(entry.Length);
+			if(!ReadFileData(entry.Offset, _compressedData.data(), entry.Length)) {
+				return false;
+			}
+			if(!Decompress(_codecs[(int)entry.Type], _compressedData.data(), entry.Length, out, _hunkBytes)) {
+				return false;
+			}
+			break;
+
+		case ChdHunkType::Uncompressed:
+			if(!_compressedMap && entry.Offset == 0) {
+				memset(out, 0, _hunkBytes);
+				return true;
+			}
+			if(!ReadFileData(entry.Offset, out, _hunkBytes)) {
+				return false;
+			}
+			break;
+
+		case ChdHunkType::Self:
+			//Same content as another hunk
+			if(entry.Offset >= _hunkCount || entry.Offset == hunkIndex || depth > 8) {
+				return false;
+			}
+			return ReadHunk((uint32_t)entry.Offset, out, depth + 1);
+
+		default:
+			return false;
+	}
+
+	if(_compressedMap && GetCrc16(out, _hunkBytes) != entry.Crc) {
+		LogDebug("[CHD] CRC mismatch for hunk " + std::to_string(hunkIndex));
+	}
+	return true;
+}
+
+bool ChdReader::Decompress(ChdCodec codec, const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize)
+{
+	switch(codec) {
+		case ChdCodec::Zlib: return InflateData(src, srcSize, out, outSize);
+		case ChdCodec::Lzma: return DecompressLzma(src, srcSize, out, outSize);
+
+		case ChdCodec::CdZlib:
+		case ChdCodec::CdLzma:
+		case ChdCodec::CdFlac:
+			return DecompressCd(codec, src, srcSize, out, outSize);
+
+		default:
+			return false;
+	}
+}
+
+bool ChdReader::DecompressCd(ChdCodec codec, const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize)
+{
+	//The sector data and the subcode data for all the frames in the hunk are compressed separately
+	uint32_t frames = outSize / ChdReader::CdFrameSize;
+	uint32_t sectorBytes = frames * ChdReader::CdSectorSize;
+	uint32_t subcodeBytes = frames * ChdReader::CdSubcodeSize;
+	_decodeBuffer.resize(sectorBytes + subcodeBytes);
+	uint8_t* sectors = _decodeBuffer.data();
+	uint8_t* subcodes = sectors + sectorBytes;
+
+	uint32_t eccBytes = 0;
+	uint32_t subcodeStart = 0;
+	if(codec == ChdCodec::CdFlac) {
+		//Audio only - samples are stored in big endian order
+		if(!_flac.Decode(src, srcSize, 2, 16, sectorBytes / 4, true, sectors, subcodeStart)) {
+			return false;
+		}
+	} else {
+		//Header: 1 bit per frame (set when the sync header/ECC was removed), followed by the compressed size of the sector data
+		eccBytes = (frames + 7) / 8;
+		uint32_t sizeBytes = outSize < 65536 ? 2 : 3;
+		uint32_t headerBytes = eccBytes + sizeBytes;
+		if(srcSize < headerBytes) {
+			return false;
+		}
+
+		uint32_t baseSize = ReadBe16(src + eccBytes);
+		if(sizeBytes > 2) {
+			baseSize = (baseSize << 8) | src[eccBytes + 2];
+		}
+		if(headerBytes + baseSize > srcSize) {
+			return false;
+		}
+
+		bool result;
+		if(codec == ChdCodec::CdLzma) {
+			result = DecompressLzma(src + headerBytes, baseSize, sectors, sectorBytes);
+		} else {
+			result = InflateData(src + headerBytes, baseSize, sectors, sectorBytes);
+		}
+		if(!result) {
+			return false;
+		}
+		subcodeStart = headerBytes + baseSize;
+	}
+
+	//Subcode data isn't used by the emulation, only needed for the hunk's CRC to match
+	if(subcodeStart >= srcSize || !InflateData(src + subcodeStart, srcSize - subcodeStart, subcodes, subcodeBytes)) {
+		memset(subcodes, 0, subcodeBytes);
+	}
+
+	static constexpr uint8_t syncHeader[12] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+	for(uint32_t i = 0; i < frames; i++) {
+		uint8_t* frame = out + i * ChdReader::CdFrameSize;
+		memcpy(frame, sectors + i * ChdReader::CdSectorSize, ChdReader::CdSectorSize);
+		memcpy(frame + ChdReader::CdSectorSize, subcodes + i * ChdReader::CdSubcodeSize, ChdReader::CdSubcodeSize);
+
+		if(eccBytes && (src[i >> 3] & (1 << (i & 0x07)))) {
+			memcpy(frame, syncHeader, sizeof(syncHeader));
+			GenerateEcc(frame);
+		}
+	}
+
+	return true;
+}
+
+bool ChdReader::InflateData(const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize)
+{
+	//Raw deflate stream (no zlib header)
+	size_t result = tinfl_decompress_mem_to_mem(out, outSize, src, srcSize, 0);
+	return result == outSize;
+}
+
+static void* LzmaAlloc(void*, size_t size)
+{
+	return malloc(size);
+}
+
+static void LzmaFree(void*, void* address)
+{
+	free(address);
+}
+
+bool ChdReader::DecompressLzma(const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize)
+{
+	//The LZMA properties aren't stored in the file - these match what the encoder uses (level 9, lc=3, lp=0, pb=2),
+	//with the dictionary size reduced based on the amount of data to decompress
+	uint32_t dictSize = 1 << 26;
+	for(uint32_t i = 11; i <= 30; i++) {
+		if(outSize <= (2u << i)) {
+			dictSize = 2u << i;
+			break;
+		}
+		if(outSize <= (3u << i)) {
+			dictSize = 3u << i;
+			break;
+		}
+	}
+
+	uint8_t props[LZMA_PROPS_SIZE] = { (2 * 5 + 0) * 9 + 3, (uint8_t)dictSize, (uint8_t)(dictSize >> 8), (uint8_t)(dictSize >> 16), (uint8_t)(dictSize >> 24) };
+
+	ISzAlloc alloc = { LzmaAlloc, LzmaFree };
+	SizeT destLen = outSize;
+	SizeT srcLen = srcSize;
+	ELzmaStatus status;
+	SRes result = LzmaDecode(out, &destLen, src, &srcLen, props, LZMA_PROPS_SIZE, LZMA_FINISH_ANY, &status, &alloc);
+	return result == SZ_OK && destLen == outSize;
+}
+
+uint16_t ChdReader::GetCrc16(const uint8_t* data, uint32_t length)
+{
+	static const vector<uint16_t> table = []() {
+		vector<uint16_t> result(256);
+		for(uint32_t i = 0; i < 256; i++) {
+			uint16_t crc = i << 8;
+			for(int j = 0; j < 8; j++) {
+				crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+			}
+			result[i] = crc;
+		}
+		return result;
+	}();
+
+	uint16_t crc = 0xFFFF;
+	for(uint32_t i = 0; i < length; i++) {
+		crc = (crc << 8) ^ table[(crc >> 8) ^ data[i]];
+	}
+	return crc;
+}
+
+static void ComputeEccBlock(const uint8_t* src, uint32_t majorCount, uint32_t minorCount, uint32_t majorMult, uint32_t minorInc, uint8_t* dst, const uint8_t* eccF, const uint8_t* eccB)
+{
+	uint32_t size = majorCount * minorCount;
+	for(uint32_t major = 0; major < majorCount; major++) {
+		uint32_t index = (major >> 1) * majorMult + (major & 0x01);
+		uint8_t eccA = 0;
+		uint8_t eccX = 0;
+		for(uint32_t minor = 0; minor < minorCount; minor++) {
+			uint8_t value = src[index];
+			index += minorInc;
+			if(index >= size) {
+				index -= size;
+			}
+			eccA = eccF[eccA ^ value];
+			eccX ^= value;
+		}
+		eccA = eccB[eccF[eccA] ^ eccX];
+		dst[major] = eccA;
+		dst[major + majorCount] = eccA ^ eccX;
+	}
+}
+
+void ChdReader::GenerateEcc(uint8_t* sector)
+{
+	//Rebuilds the P/Q parity bytes of a mode 1/2 sector (removed from the data by the encoder when they can be regenerated)
+	struct EccTables
+	{
+		uint8_t F[256];
+		uint8_t B[256];
+	};
+
+	static const EccTables tables = []() {
+		EccTables result = {};
+		for(uint32_t i = 0; i < 256; i++) {
+			uint32_t j = (i << 1) ^ ((i & 0x80) ? 0x11D : 0);
+			result.F[i] = (uint8_t)j;
+			result.B[i ^ j] = (uint8_t)i;
+		}
+		return result;
+	}();
+
+	//The sector's address is excluded from the calculation for mode 2 sectors
+	uint8_t address[4];
+	bool mode2 = sector[15] == 2;
+	if(mode2) {
+		memcpy(address, sector + 12, 4);
+		memset(sector + 12, 0, 4);
+	}
+
+	ComputeEccBlock(sector + 0x0C, 86, 24, 2, 86, sector + 0x81C, tables.F, tables.B);
+	ComputeEccBlock(sector + 0x0C, 52, 43, 86, 88, sector + 0x8C8, tables.F, tables.B);
+
+	if(mode2) {
+		memcpy(sector + 12, address, 4);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "pch.h"
+#include "Utilities/VirtualFile.h"
+#include "Utilities/SimpleLock.h"
+#include "Utilities/Audio/FlacDecoder.h"
+
+//Reads CHD (v5) files - hunks are decompressed on demand and the most recently used ones are kept in a small cache
+class ChdReader
+{
+public:
+	//CD images store each frame as 2352 bytes of sector data followed by 96 bytes of subcode data
+	static constexpr uint32_t CdFrameSize = 2448;
+	static constexpr uint32_t CdSectorSize = 2352;
+	static constexpr uint32_t CdSubcodeSize = 96;
+
+	static constexpr uint32_t MetadataCdTrack = 0x43485432; //CHT2
+	static constexpr uint32_t MetadataCdTrackOld = 0x43485452; //CHTR
+
+private:
+	static constexpr uint32_t MaxCachedHunks = 16;
+	static constexpr uint32_t HeaderSize = 124;
+
+	//Values above these limits can't be a CD image - checked before anything is allocated based on the header's content
+	static constexpr uint32_t MaxHunkSize = ChdReader::CdFrameSize * 256;
+	static constexpr uint64_t MaxLogicalSize = (uint64_t)100 * 60 * 75 * ChdReader::CdFrameSize; //100 minutes
+	static constexpr uint32_t MaxCodecHeaderSize = ChdReader::MaxHunkSize / ChdReader::CdFrameSize / 8 + 3; //CD codecs: ECC bitmap + 24-bit length
+
+	enum class ChdCodec : uint32_t
+	{
+		None = 0,
+		Zlib = 0x7A6C6962, //zlib
+		Lzma = 0x6C7A6D61, //lzma
+		CdZlib = 0x63647A6C, //cdzl
+		CdLzma = 0x63646C7A, //cdlz
+		CdFlac = 0x6364666C //cdfl
+	};
+
+	enum class ChdHunkType : uint8_t
+	{
+		Codec0 = 0,
+		Codec1 = 1,
+		Codec2 = 2,
+		Codec3 = 3,
+		Uncompressed = 4,
+		Self = 5,
+		Parent = 6,
+
+		//Only used in the compressed map
+		RleSmall = 7,
+		RleLarge = 8,
+		Self0 = 9,
+		Self1 = 10,
+		ParentSelf = 11,
+		Parent0 = 12,
+		Parent1 = 13
+	};
+
+	struct HunkMapEntry
+	{
+		ChdHunkType Type;
+		uint32_t Length;
+		uint64_t Offset;
+		uint16_t Crc;
+	};
+
+	struct CachedHunk
+	{
+		uint32_t Id;
+		uint64_t LastAccess;
+		vector<uint8_t> Data;
+	};
+
+	VirtualFile _file;
+
+	ChdCodec _codecs[4] = {};
+	uint64_t _logicalBytes = 0;
+	uint64_t _metaOffset = 0;
+	uint32_t _hunkBytes = 0;
+	uint32_t _unitBytes = 0;
+	uint32_t _hunkCount = 0;
+	bool _compressedMap = false;
+	vector<HunkMapEntry> _map;
+
+	//Can be used by multiple threads (emulation + CD read-ahead)
+	SimpleLock _lock;
+	vector<CachedHunk> _cache;
+	uint64_t _accessCounter = 0;
+	uint32_t _lastHunkIndex = 0;
+
+	vector<uint8_t> _compressedData;
+	vector<uint8_t> _decodeBuffer;
+	FlacDecoder _flac;
+
+	ChdReader(VirtualFile& file);
+
+	bool ReadFileData(uint64_t offset, uint8_t* out, uint32_t length);
+	bool ReadHeader();
+	bool ReadMap();
+	bool ReadCompressedMap(uint64_t mapOffset);
+
+	CachedHunk* GetHunk(uint32_t hunkIndex);
+	bool ReadHunk(uint32_t hunkIndex, uint8_t* out, uint32_t depth = 0);
+	bool Decompress(ChdCodec codec, const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize);
+	bool DecompressCd(ChdCodec codec, const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize);
+
+	static bool InflateData(const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize);
+	static bool DecompressLzma(const uint8_t* src, uint32_t srcSize, uint8_t* out, uint32_t outSize);
+	static uint16_t GetCrc16(const uint8_t* data, uint32_t length);
+	static void GenerateEcc(uint8_t* sector);
+
+public:
+	//Returns nullptr if the file isn't a valid/supported CHD file
+	static unique_ptr<ChdReader> Create(VirtualFile& file);
+
+	//Reads from the uncompressed data - offset/length may span multiple hunks
+	bool ReadBytes(uint64_t offset, uint8_t* out, uint32_t length);
+
+	//Returns the content of the Nth metadata entry with the given tag
+	bool GetMetadata(uint32_t tag, uint32_t index, string& out);
+
+	uint64_t GetLogicalSize() { return _logicalBytes; }
+	uint32_t GetHunkSize() { return _hunkBytes; }
+};
@@ -207,13 +207,17 @@ bool Emulator::ProcessSystemActions()
 
 void Emulator::RunFrameWithRunAhead()
 {
-	stringstream runAheadState;
 	uint32_t frameCount = _settings->GetEmulationConfig().RunAheadFrames;
 
 	//Run a single frame and save the state (no audio/video)
 	_isRunAheadFrame = true;
 	_console->RunFrame();
-	Serialize(runAheadState, false, 0);
+
+	//The snapshot's buffer is reused from one frame to the next
+	Timer timer;
+	Serialize(_runAheadSnapshot, false);
+	_runAheadStats.SaveTime = timer.GetElapsedMS();
+	_runAheadStats.StateSize = (uint32_t)_runAheadSnapshot.Data.size();
 
 	while(frameCount > 1) {
 		//Run extra frames if the requested run ahead frame count is higher than 1
@@ -231,11 +235,32 @@ void Emulator::RunFrameWithRunAhead()
 	if(!wasReset) {
 		//Load the state we saved earlier
 		_isRunAheadFrame = true;
-		Deserialize(runAheadState, SaveStateManager::FileFormatVersion, false);
+		timer.Reset();
+		Deserialize(_runAheadSnapshot, false);
+		_runAheadStats.LoadTime = timer.GetElapsedMS();
+
+		if(!_runAheadStats.StreamMeasured && _settings->GetPreferences().ShowDebugInfo) {
+			MeasureRunAheadStreamStats();
+		}
 		_isRunAheadFrame = false;
 	}
 }
 
+void Emulator::MeasureRunAheadStreamStats()
+{
+	//Measured once per game, when the debug stats are first displayed, to show the time saved compared to
+	//a stringstream-based keyed state - saving and then loading the current state doesn't change it
+	stringstream state;
+	Timer timer;
+	Serialize(state, false, 0);
+	_runAheadStats.StreamSaveTime = timer.GetElapsedMS();
+
+	timer.Reset();
+	Deserialize(state, SaveStateManager::FileFormatVersion, false);
+	_runAheadStats.StreamLoadTime = timer.GetElapsedMS();
+	_runAheadStats.StreamMeasured = true;
+}
+
 void Emulator::OnBeforeSendFrame()
 {
 	if(!_isRunAheadFrame) {
@@ -269,6 +294,7 @@ void Emulator::ProcessEndOfFrame()
 		}
 
 		_console->GetControlManager()->ProcessEndOfFrame();
+		_emuNwaServer->ProcessEndOfFrame();
 	}
 	_frameRunning = false;
 }
@@ -472,6 +498,7 @@ bool Emulator::InternalLoadRom(VirtualFile romFile, VirtualFile patchFile, bool
 	_rom.PatchFile = (string)patchFile;
 	_rom.Format = console->GetRomFormat();
 	_rom.DipSwitches = console->GetDipSwitchInfo();
+	_runAheadStats = {};
 
 	if(_rom.Format == RomFormat::Spc || _rom.Format == RomFormat::Nsf || _rom.Format == RomFormat::Gbs || _rom.Format == RomFormat::PceHes) {
 		_audioPlayerHud.reset(new AudioPlayerHud(this));
@@ -618,6 +645,11 @@ string Emulator::GetHash(HashType type)
 
 uint32_t Emulator::GetCrc32()
 {
+	shared_ptr<IConsole> console = _console.lock();
+	uint32_t crc32 = 0;
+	if(console && console->GetCrc32(crc32)) {
+		return crc32;
+	}
 	return _rom.RomFile.GetCrc32();
 }
 
@@ -912,14 +944,23 @@ void Emulator::WaitForLock()
 	}
 }
 
-void Emulator::Serialize(ostream& out, bool includeSettings, int compressionLevel)
+void Emulator::Serialize(ostream& out, bool includeSettings, int compressionLevel, SerializeFormat format, CompressionCodec codec)
 {
-	Serializer s(SaveStateManager::FileFormatVersion, true);
+	Serializer s(SaveStateManager::FileFormatVersion, true, format);
+	if(includeSettings) {
+		SV(_settings);
+	}
+	s.Stream(_console, "");
+	s.SaveTo(out, compressionLevel, codec);
+}
+
+void Emulator::Serialize(SerializeSnapshot& snapshot, bool includeSettings)
+{
+	Serializer s(SaveStateManager::FileFormatVersion, true, snapshot);
 	if(includeSettings) {
 		SV(_settings);
 	}
 	s.Stream(_console, "");
-	s.SaveTo(out, compressionLevel);
 }
 
 DeserializeResult Emulator::Deserialize(istream& in, uint32_t fileFormatVersion, bool includeSettings, optional<ConsoleType> srcConsoleType, bool sendNotification)
@@ -928,7 +969,20 @@ DeserializeResult Emulator::Deserialize(istream& in, uint32_t fileFormatVersion,
 	if(!s.LoadFrom(in)) {
 		return DeserializeResult::InvalidFile;
 	}
+	return Deserialize(s, includeSettings, srcConsoleType, sendNotification);
+}
 
+DeserializeResult Emulator::Deserialize(SerializeSnapshot& snapshot, bool includeSettings, bool sendNotification)
+{
+	Serializer s(SaveStateManager::FileFormatVersion, false, snapshot);
+	if(!s.IsValid()) {
+		return DeserializeResult::InvalidFile;
+	}
+	return Deserialize(s, includeSettings, std::nullopt, sendNotification);
+}
+
+DeserializeResult Emulator::Deserialize(Serializer& s, bool includeSettings, optional<ConsoleType> srcConsoleType, bool sendNotification)
+{
 	if(includeSettings) {
 		SV(_settings);
 	}
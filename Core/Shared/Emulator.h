@@ -8,6 +8,7 @@
 #include "Core/Shared/Audio/AudioPlayerTypes.h"
 #include "Utilities/Timer.h"
 #include "Utilities/safe_ptr.h"
+#include "Utilities/Serializer.h"
 #include "Utilities/SimpleLock.h"
 #include "Utilities/VirtualFile.h"
 
@@ -56,6 +57,19 @@ struct ConsoleMemoryInfo
 	uint32_t Size;
 };
 
+struct RunAheadStats
+{
+	//Time taken to save/restore the run-ahead snapshot (last frame)
+	double SaveTime;
+	double LoadTime;
+	uint32_t StateSize;
+
+	//Time taken to save/restore the same state with a stringstream-based keyed state (measured once, for comparison)
+	double StreamSaveTime;
+	double StreamLoadTime;
+	bool StreamMeasured;
+};
+
 class Emulator
 {
 private:
@@ -107,6 +121,9 @@ private:
 	atomic<bool> _isRunAheadFrame;
 	bool _frameRunning = false;
 
+	SerializeSnapshot _runAheadSnapshot;
+	RunAheadStats _runAheadStats = {};
+
 	RomInfo _rom;
 	ConsoleType _consoleType = {};
 
@@ -127,6 +144,9 @@ private:
 	void ProcessAutoSaveState();
 	bool ProcessSystemActions();
 	void RunFrameWithRunAhead();
+	void MeasureRunAheadStreamStats();
+
+	DeserializeResult Deserialize(Serializer& s, bool includeSettings, optional<ConsoleType> srcConsoleType, bool sendNotification);
 
 	void BlockDebuggerRequests();
 	void ResetDebugger(bool startDebugger = false);
@@ -185,9 +205,14 @@ public:
 
 	void SuspendDebugger(bool release);
 
-	void Serialize(ostream& out, bool includeSettings, int compressionLevel = 1);
+	void Serialize(ostream& out, bool includeSettings, int compressionLevel = 1, SerializeFormat format = SerializeFormat::Binary, CompressionCodec codec = CompressionCodec::Deflate);
 	DeserializeResult Deserialize(istream& in, uint32_t fileFormatVersion, bool includeSettings, optional<ConsoleType> consoleType = std::nullopt, bool sendNotification = true);
 
+	void Serialize(SerializeSnapshot& snapshot, bool includeSettings);
+	DeserializeResult Deserialize(SerializeSnapshot& snapshot, bool includeSettings, bool sendNotification = true);
+
+	RunAheadStats GetRunAheadStats() { return _runAheadStats; }
+
 	SoundMixer* GetSoundMixer() { return _soundMixer.get(); }
 	VideoRenderer* GetVideoRenderer() { return _videoRenderer.get(); }
 	VideoDecoder* GetVideoDecoder() { return _videoDecoder.get(); }
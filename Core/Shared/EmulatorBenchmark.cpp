@@ -0,0 +1,321 @@
+#include "pch.h"
+#include "Shared/EmulatorBenchmark.h"
+#include "Shared/Emulator.h"
+#include "Shared/EmuSettings.h"
+#include "Shared/NotificationManager.h"
+#include "Shared/SaveStateManager.h"
+#include "Shared/DebuggerRequest.h"
+#include "Utilities/VirtualFile.h"
+#include "Utilities/Serializer.h"
+#include "Utilities/CompressionHelper.h"
+
+EmulatorBenchmark::EmulatorBenchmark(Emulator* emu, uint32_t frameCount, uint32_t warmupFrameCount)
+{
+	_emu = emu;
+	_frameCount = std::max<uint32_t>(frameCount, 1);
+	_warmupFrameCount = warmupFrameCount;
+	_measuring = false;
+}
+
+void EmulatorBenchmark::ProcessNotification(ConsoleNotificationType type, void* parameter)
+{
+	if(type != ConsoleNotificationType::PpuFrameDone || !_measuring) {
+		return;
+	}
+
+	//Called on the emulation thread at the end of every frame
+	_frameCounter++;
+	if(_frameCounter <= _warmupFrameCount) {
+		_timer.Reset();
+		_prevFrameTime = 0;
+		return;
+	}
+
+	double time = _timer.GetElapsedMS();
+	_frameTimes.push_back(time - _prevFrameTime);
+	_prevFrameTime = time;
+
+	if(_frameTimes.size() >= _frameCount) {
+		_measuring = false;
+		_signal.Signal();
+	}
+}
+
+BenchmarkRunResult EmulatorBenchmark::Run(VirtualFile& romFile, bool enableDebugger)
+{
+	BenchmarkRunResult result = {};
+
+	_frameCounter = 0;
+	_prevFrameTime = 0;
+	_frameTimes.clear();
+	_frameTimes.reserve(_frameCount);
+	_signal.Reset();
+	_timer.Reset();
+
+	_emu->GetNotificationManager()->RegisterNotificationListener(shared_from_this());
+	_emu->GetSettings()->SetFlag(EmulationFlags::MaximumSpeed);
+
+	_measuring = true;
+	if(!_emu->LoadRom(romFile, VirtualFile())) {
+		_measuring = false;
+		return result;
+	}
+
+	result.Console = _emu->GetConsoleType();
+
+	if(enableDebugger) {
+		//The warmup frames absorb the time needed to initialize the debugger
+		_emu->GetDebugger(true);
+	}
+
+	Timer runTimer;
+	while(!_signal.Wait(1000)) {
+		if(!_emu->IsRunning() || runTimer.GetElapsedMS() > MaxRunTime) {
+			_measuring = false;
+			return result;
+		}
+	}
+
+	result.FrameTimes = std::move(_frameTimes);
+	MeasureStates(result.States);
+	result.Completed = true;
+	return result;
+}
+
+double EmulatorBenchmark::Median(vector<double> values)
+{
+	if(values.empty()) {
+		return 0;
+	}
+	std::sort(values.begin(), values.end());
+	size_t mid = values.size() / 2;
+	return (values.size() & 0x01) ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+double EmulatorBenchmark::Percentile(vector<double> values, double percentile)
+{
+	if(values.empty()) {
+		return 0;
+	}
+	std::sort(values.begin(), values.end());
+	size_t index = std::min(values.size() - 1, (size_t)(percentile / 100.0 * values.size()));
+	return values[index];
+}
+
+static double StdDev(vector<double>& values)
+{
+	if(values.size() < 2) {
+		return 0;
+	}
+
+	double mean = 0;
+	for(double value : values) {
+		mean += value;
+	}
+	mean /= values.size();
+
+	double variance = 0;
+	for(double value : values) {
+		variance += (value - mean) * (value - mean);
+	}
+	return std::sqrt(variance / (values.size() - 1));
+}
+
+void EmulatorBenchmark::MeasureStates(BenchmarkStateStats& stats)
+{
+	auto lock = _emu->AcquireLock();
+
+	vector<double> keyedSave, keyedLoad, snapshotSave, snapshotLoad;
+	vector<double> deflateCompress, deflateDecompress, lz4Compress, lz4Decompress;
+	SerializeSnapshot snapshot;
+	vector<uint8_t> compressed;
+	vector<uint8_t> decompressed;
+	Timer timer;
+
+	for(uint32_t i = 0; i < StateIterations; i++) {
+		stringstream ss;
+		timer.Reset();
+		_emu->Serialize(ss, false, 0);
+		keyedSave.push_back(timer.GetElapsedMS());
+		stats.KeyedSize = (uint32_t)ss.tellp();
+
+		timer.Reset();
+		_emu->Deserialize(ss, SaveStateManager::FileFormatVersion, false, std::nullopt, false);
+		keyedLoad.push_back(timer.GetElapsedMS());
+
+		timer.Reset();
+		_emu->Serialize(snapshot, false);
+		snapshotSave.push_back(timer.GetElapsedMS());
+		stats.SnapshotSize = (uint32_t)snapshot.Data.size();
+
+		uint32_t fallbackCount = Serializer::GetKeyedFallbackCount();
+		timer.Reset();
+		_emu->Deserialize(snapshot, false, false);
+		snapshotLoad.push_back(timer.GetElapsedMS());
+		stats.SnapshotKeyedLoads += Serializer::GetKeyedFallbackCount() != fallbackCount ? 1 : 0;
+
+		decompressed.resize(snapshot.Data.size());
+
+		compressed.clear();
+		timer.Reset();
+		stats.DeflateSize = CompressionHelper::CompressRaw(snapshot.Data.data(), (uint32_t)snapshot.Data.size(), 1, compressed, CompressionCodec::Deflate);
+		deflateCompress.push_back(timer.GetElapsedMS());
+
+		timer.Reset();
+		CompressionHelper::DecompressRaw(compressed.data(), (uint32_t)compressed.size(), decompressed.data(), (uint32_t)decompressed.size(), CompressionCodec::Deflate);
+		deflateDecompress.push_back(timer.GetElapsedMS());
+
+		compressed.clear();
+		timer.Reset();
+		stats.Lz4Size = CompressionHelper::CompressRaw(snapshot.Data.data(), (uint32_t)snapshot.Data.size(), 1, compressed, CompressionCodec::Lz4);
+		lz4Compress.push_back(timer.GetElapsedMS());
+
+		timer.Reset();
+		CompressionHelper::DecompressRaw(compressed.data(), (uint32_t)compressed.size(), decompressed.data(), (uint32_t)decompressed.size(), CompressionCodec::Lz4);
+		lz4Decompress.push_back(timer.GetElapsedMS());
+	}
+
+	stats.KeyedSaveTime = Median(keyedSave);
+	stats.KeyedLoadTime = Median(keyedLoad);
+	stats.SnapshotSaveTime = Median(snapshotSave);
+	stats.SnapshotLoadTime = Median(snapshotLoad);
+	stats.DeflateCompressTime = Median(deflateCompress);
+	stats.DeflateDecompressTime = Median(deflateDecompress);
+	stats.Lz4CompressTime = Median(lz4Compress);
+	stats.Lz4DecompressTime = Median(lz4Decompress);
+}
+
+static string GetConsoleName(ConsoleType type)
+{
+	switch(type) {
+		case ConsoleType::Snes: return "Snes";
+		case ConsoleType::Gameboy: return "Gameboy";
+		case ConsoleType::Nes: return "Nes";
+		case ConsoleType::PcEngine: return "PcEngine";
+		case ConsoleType::Sms: return "Sms";
+		case ConsoleType::Gba: return "Gba";
+		case ConsoleType::Ws: return "Ws";
+	}
+	return "Unknown";
+}
+
+string EmulatorBenchmark::EscapeJson(string str)
+{
+	string result;
+	for(char c : str) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if((uint8_t)c < 0x20) {
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "\\u%04x", (uint8_t)c);
+			result += buffer;
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+static void WriteStats(stringstream& out, const char* name, vector<double>& values)
+{
+	out << "\"" << name << "\": { \"median\": " << EmulatorBenchmark::Median(values) << ", \"stddev\": " << StdDev(values);
+	if(!values.empty()) {
+		out << ", \"min\": " << *std::min_element(values.begin(), values.end()) << ", \"max\": " << *std::max_element(values.begin(), values.end());
+	}
+	out << " }";
+}
+
+static double GetAverageFrameTime(BenchmarkRunResult& run)
+{
+	double total = 0;
+	for(double time : run.FrameTimes) {
+		total += time;
+	}
+	return run.FrameTimes.empty() ? 0 : total / run.FrameTimes.size();
+}
+
+void EmulatorBenchmark::WriteRunStats(stringstream& out, vector<BenchmarkRunResult>& runs)
+{
+	//Per-run averages are used to compute the median/stddev across runs,
+	//while the individual frame times of all runs are pooled to measure frame time spikes
+	vector<double> msPerFrame;
+	vector<double> fps;
+	vector<double> allFrames;
+	for(BenchmarkRunResult& run : runs) {
+		if(!run.Completed) {
+			continue;
+		}
+
+		double frameTime = GetAverageFrameTime(run);
+		msPerFrame.push_back(frameTime);
+		fps.push_back(frameTime > 0 ? 1000.0 / frameTime : 0);
+		allFrames.insert(allFrames.end(), run.FrameTimes.begin(), run.FrameTimes.end());
+	}
+
+	out << "{ \"completedRuns\": " << msPerFrame.size() << ", ";
+	WriteStats(out, "msPerFrame", msPerFrame);
+	out << ", ";
+	WriteStats(out, "fps", fps);
+	out << ", \"frameTime\": { \"median\": " << Median(allFrames) << ", \"p99\": " << Percentile(allFrames, 99) << ", \"max\": " << Percentile(allFrames, 100) << " } }";
+}
+
+string EmulatorBenchmark::ToJson(vector<BenchmarkRomResult>& results, string version, uint32_t frameCount, uint32_t warmupFrameCount)
+{
+	stringstream out;
+	out << std::fixed << std::setprecision(4);
+	out << "{\n";
+	out << "  \"version\": \"" << EscapeJson(version) << "\",\n";
+	out << "  \"frames\": " << frameCount << ",\n";
+	out << "  \"warmupFrames\": " << warmupFrameCount << ",\n";
+	out << "  \"roms\": [";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		BenchmarkRomResult& rom = results[i];
+		out << (i > 0 ? "," : "") << "\n    {\n";
+		out << "      \"name\": \"" << EscapeJson(rom.RomName) << "\",\n";
+		out << "      \"console\": \"" << GetConsoleName(rom.Console) << "\",\n";
+		out << "      \"emulation\": ";
+		WriteRunStats(out, rom.Runs);
+
+		if(!rom.DebuggerRuns.empty()) {
+			vector<double> baseline, debugger;
+			for(BenchmarkRunResult& run : rom.Runs) {
+				if(run.Completed) {
+					baseline.push_back(GetAverageFrameTime(run));
+				}
+			}
+			for(BenchmarkRunResult& run : rom.DebuggerRuns) {
+				if(run.Completed) {
+					debugger.push_back(GetAverageFrameTime(run));
+				}
+			}
+
+			//The debugger hooks' cost is the difference between the runs with and without the debugger
+			double baselineTime = Median(baseline);
+			double debuggerTime = Median(debugger);
+			out << ",\n      \"debugger\": ";
+			WriteRunStats(out, rom.DebuggerRuns);
+			out << ",\n      \"debuggerOverhead\": { \"msPerFrame\": " << (debuggerTime - baselineTime);
+			out << ", \"percent\": " << (baselineTime > 0 ? (debuggerTime - baselineTime) * 100 / baselineTime : 0) << " }";
+		}
+
+		//Use the state stats from the first completed run
+		for(BenchmarkRunResult& run : rom.Runs) {
+			if(run.Completed) {
+				BenchmarkStateStats& s = run.States;
+				out << ",\n      \"saveStates\": {\n";
+				out << "        \"keyed\": { \"saveMs\": " << s.KeyedSaveTime << ", \"loadMs\": " << s.KeyedLoadTime << ", \"size\": " << s.KeyedSize << " },\n";
+				out << "        \"snapshot\": { \"saveMs\": " << s.SnapshotSaveTime << ", \"loadMs\": " << s.SnapshotLoadTime << ", \"size\": " << s.SnapshotSize << ", \"keyedLoads\": " << s.SnapshotKeyedLoads << " },\n";
+				out << "        \"deflate\": { \"compressMs\": " << s.DeflateCompressTime << ", \"decompressMs\": " << s.DeflateDecompressTime << ", \"size\": " << s.DeflateSize << " },\n";
+				out << "        \"lz4\": { \"compressMs\": " << s.Lz4CompressTime << ", \"decompressMs\": " << s.Lz4DecompressTime << ", \"size\": " << s.Lz4Size << " }\n";
+				out << "      }";
+				break;
+			}
+		}
+		out << "\n    }";
+	}
+
+	out << "\n  ]\n}\n";
+	return out.str();
+}
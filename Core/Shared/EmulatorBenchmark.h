@@ -0,0 +1,87 @@
+#pragma once
+
+#include "pch.h"
+#include "Core/Shared/Interfaces/INotificationListener.h"
+#include "Utilities/AutoResetEvent.h"
+#include "Utilities/Timer.h"
+
+class Emulator;
+class VirtualFile;
+enum class ConsoleType;
+
+struct BenchmarkStateStats
+{
+	//Median time (in ms) for each operation, measured over StateIterations iterations
+	double KeyedSaveTime = 0;
+	double KeyedLoadTime = 0;
+	uint32_t KeyedSize = 0;
+
+	double SnapshotSaveTime = 0;
+	double SnapshotLoadTime = 0;
+	uint32_t SnapshotSize = 0;
+	uint32_t SnapshotKeyedLoads = 0; //Snapshot loads that fell back to the slower keyed format
+
+	double DeflateCompressTime = 0;
+	double DeflateDecompressTime = 0;
+	uint32_t DeflateSize = 0;
+
+	double Lz4CompressTime = 0;
+	double Lz4DecompressTime = 0;
+	uint32_t Lz4Size = 0;
+};
+
+struct BenchmarkRunResult
+{
+	bool Completed = false;
+	ConsoleType Console = {};
+
+	//Duration (in ms) of every measured frame, in the order they were emulated
+	vector<double> FrameTimes;
+	BenchmarkStateStats States;
+};
+
+struct BenchmarkRomResult
+{
+	string RomName;
+	ConsoleType Console = {};
+	vector<BenchmarkRunResult> Runs;
+	vector<BenchmarkRunResult> DebuggerRuns;
+};
+
+class EmulatorBenchmark : public INotificationListener, public std::enable_shared_from_this<EmulatorBenchmark>
+{
+private:
+	static constexpr uint32_t StateIterations = 20;
+	static constexpr double MaxRunTime = 10 * 60 * 1000;
+
+	Emulator* _emu;
+	uint32_t _frameCount;
+	uint32_t _warmupFrameCount;
+
+	atomic<bool> _measuring;
+	uint32_t _frameCounter = 0;
+	double _prevFrameTime = 0;
+	vector<double> _frameTimes;
+	Timer _timer;
+	AutoResetEvent _signal;
+
+	void MeasureStates(BenchmarkStateStats& stats);
+
+	static void WriteRunStats(stringstream& out, vector<BenchmarkRunResult>& runs);
+
+public:
+	EmulatorBenchmark(Emulator* emu, uint32_t frameCount, uint32_t warmupFrameCount);
+
+	void ProcessNotification(ConsoleNotificationType type, void* parameter) override;
+
+	//Loads the rom, emulates the requested number of frames as fast as possible and returns the timings.
+	//The caller is responsible for initializing the emulator beforehand and stopping it afterwards.
+	BenchmarkRunResult Run(VirtualFile& romFile, bool enableDebugger);
+
+	static string ToJson(vector<BenchmarkRomResult>& results, string version, uint32_t frameCount, uint32_t warmupFrameCount);
+
+	//Helpers shared with the other benchmarks
+	static double Median(vector<double> values);
+	static double Percentile(vector<double> values, double percentile);
+	static string EscapeJson(string str);
+};
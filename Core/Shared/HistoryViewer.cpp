@@ -138,16 +138,16 @@ bool HistoryViewer::SaveMovie(string movieFile, uint32_t startPosition, uint32_t
 
 	//Take a savestate to be able to restore it after generating the movie file
 	//(the movie generation uses the console's inputs, which could affect the emulation otherwise)
-	stringstream state;
+	SerializeSnapshot state;
 	auto lock = _emu->AcquireLock();
-	_emu->Serialize(state, true, false);
+	_emu->Serialize(state, true);
 
 	//Convert the rewind data to a .mmo file
 	unique_ptr<MovieRecorder> recorder(new MovieRecorder(_emu));
 	bool result = recorder->CreateMovie(movieFile, _history, startPosition, endPosition, _mainEmu->GetBatteryManager()->HasBattery());
 
 	//Resume the state and resume
-	_emu->Deserialize(state, SaveStateManager::FileFormatVersion, true);
+	_emu->Deserialize(state, true);
 	return result;
 }
 
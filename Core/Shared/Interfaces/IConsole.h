@@ -94,6 +94,9 @@ public:
 	
 	virtual string GetHash(HashType hashType) { return {}; }
 
+	//Returns false when the CRC of the ROM file itself identifies the game
+	virtual bool GetCrc32(uint32_t& crc32) { return false; }
+
 	virtual RomFormat GetRomFormat() = 0;
 	virtual AudioTrackInfo GetAudioTrackInfo() = 0;
 	virtual void ProcessAudioPlayerAction(AudioPlayerActionParams p) = 0;
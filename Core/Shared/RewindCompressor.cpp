@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "Shared/RewindCompressor.h"
+#include "Utilities/CompressionHelper.h"
+
+RewindCompressionJob::RewindCompressionJob(shared_ptr<const vector<uint8_t>> input) : _inputSize((uint32_t)input->size())
+{
+	_input = std::move(input);
+	_state = JobState::Pending;
+}
+
+bool RewindCompressionJob::TryRun()
+{
+	uint8_t expected = JobState::Pending;
+	if(!_state.compare_exchange_strong(expected, JobState::Running)) {
+		return false;
+	}
+
+	CompressionHelper::Compress(_input->data(), (uint32_t)_input->size(), 1, _output, CompressionCodec::Lz4);
+	_input.reset();
+	_state = JobState::Done;
+	_doneSignal.Signal();
+	return true;
+}
+
+vector<uint8_t>& RewindCompressionJob::GetOutput()
+{
+	if(!TryRun()) {
+		while(_state != JobState::Done) {
+			//Worker thread is compressing the data, wait for it
+			_doneSignal.Wait();
+		}
+	}
+	return _output;
+}
+
+uint32_t RewindCompressionJob::GetSize()
+{
+	if(_state == JobState::Done) {
+		return (uint32_t)_output.size();
+	}
+	return _inputSize;
+}
+
+RewindCompressor::RewindCompressor()
+{
+	_stopFlag = false;
+}
+
+RewindCompressor::~RewindCompressor()
+{
+	_stopFlag = true;
+	if(_thread) {
+		_signal.Signal();
+		_thread->join();
+		_thread.reset();
+	}
+}
+
+shared_ptr<RewindCompressionJob> RewindCompressor::Compress(shared_ptr<const vector<uint8_t>> data)
+{
+	shared_ptr<RewindCompressionJob> job(new RewindCompressionJob(std::move(data)));
+
+	{
+		auto lock = _lock.AcquireSafe();
+		if(_queue.size() >= RewindCompressor::MaxQueueSize) {
+			//Worker can't keep up, compress on this thread to keep memory usage bounded
+			lock.Release();
+			job->TryRun();
+			return job;
+		}
+
+		_queue.push_back(job);
+		if(!_thread) {
+			_thread.reset(new std::thread(&RewindCompressor::Run, this));
+		}
+	}
+
+	_signal.Signal();
+	return job;
+}
+
+void RewindCompressor::Run()
+{
+	while(!_stopFlag) {
+		shared_ptr<RewindCompressionJob> job;
+		{
+			auto lock = _lock.AcquireSafe();
+			if(!_queue.empty()) {
+				job = _queue.front();
+				_queue.pop_front();
+			}
+		}
+
+		if(job) {
+			//The job might already be done if the emulation thread needed the data before the worker got to it
+			job->TryRun();
+		} else {
+			_signal.Wait();
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "pch.h"
+#include <deque>
+#include <thread>
+#include "Utilities/AutoResetEvent.h"
+#include "Utilities/SimpleLock.h"
+
+class RewindCompressionJob
+{
+private:
+	enum JobState : uint8_t
+	{
+		Pending,
+		Running,
+		Done
+	};
+
+	//Shared with the RewindData that keeps the uncompressed state, the job only reads it
+	shared_ptr<const vector<uint8_t>> _input;
+	vector<uint8_t> _output;
+	const uint32_t _inputSize; //_input is cleared by the worker thread, GetSize() can't access it
+	atomic<uint8_t> _state;
+	AutoResetEvent _doneSignal;
+
+public:
+	RewindCompressionJob(shared_ptr<const vector<uint8_t>> input);
+
+	//Compresses the data, unless another thread already started doing so
+	bool TryRun();
+
+	//Waits until the data is compressed (compresses it on the calling thread if the worker hasn't started yet)
+	//The caller can move the data out of the returned vector, the job can't be used afterwards
+	vector<uint8_t>& GetOutput();
+
+	//Size of the compressed data, or of the uncompressed data if the job isn't done yet
+	uint32_t GetSize();
+};
+
+class RewindCompressor
+{
+private:
+	static constexpr size_t MaxQueueSize = 8;
+
+	unique_ptr<std::thread> _thread;
+	AutoResetEvent _signal;
+	SimpleLock _lock;
+	std::deque<shared_ptr<RewindCompressionJob>> _queue;
+	atomic<bool> _stopFlag;
+
+	void Run();
+
+public:
+	RewindCompressor();
+	~RewindCompressor();
+
+	//Compresses the data on the worker thread - if too many jobs are already queued, the data is compressed on the calling thread instead
+	shared_ptr<RewindCompressionJob> Compress(shared_ptr<const vector<uint8_t>> data);
+};
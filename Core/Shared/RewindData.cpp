@@ -1,96 +1,184 @@
 #include "pch.h"
 #include "Shared/RewindData.h"
 #include "Shared/Emulator.h"
-#include "Shared/SaveStateManager.h"
+#include "Shared/RewindCompressor.h"
 #include "Utilities/CompressionHelper.h"
+#include "Utilities/Serializer.h"
 
 void RewindData::GetStateData(stringstream &stateData, deque<RewindData>& prevStates, int32_t position)
 {
-	vector<uint8_t> data;
-	CompressionHelper::Decompress(_saveStateData, data);
+	SerializeSnapshot snapshot;
+	snapshot.Schema = _schema;
+	if(!GetStateData(snapshot.Data, prevStates, position)) {
+		return;
+	}
 
-	if(!IsFullState) {
-		position = (position > 0 ? position : (int32_t)prevStates.size()) - 1;
-		ProcessXorState(data, prevStates, position);
+	//Rewind states use the packed format, which can't be loaded by another process - convert it before it gets written to a file
+	vector<uint8_t> data;
+	if(!Serializer::ConvertToBinaryFormat(snapshot, data)) {
+		return;
 	}
 
 	stateData.write((char*)data.data(), data.size());
 }
 
-template<typename T>
-void RewindData::ProcessXorState(T& data, deque<RewindData>& prevStates, int32_t position)
+RewindData* RewindData::GetFullState(deque<RewindData>& prevStates, int32_t position)
 {
-	//Find last full state and XOR with it
-	while(position >= 0 && position < prevStates.size()) {
-		RewindData& prevState = prevStates[position];
-		if(prevState.IsFullState) {
-			//XOR with previous state to restore state data to its initial state
-			if(!prevState._uncompressedData.empty()) {
-				for(size_t i = 0, len = std::min(prevState._uncompressedData.size(), data.size()); i < len; i++) {
-					data[i] ^= prevState._uncompressedData[i];
-				}
-			} else {
-				vector<uint8_t> prevStateData;
-				CompressionHelper::Decompress(prevState._saveStateData, prevStateData);
-				for(size_t i = 0, len = std::min(prevStateData.size(), data.size()); i < len; i++) {
-					data[i] ^= prevStateData[i];
-				}
-			}
-			break;
+	while(position >= 0 && position < (int32_t)prevStates.size()) {
+		if(prevStates[position].IsFullState) {
+			return &prevStates[position];
 		}
 		position--;
 	}
+	return nullptr;
 }
 
-void RewindData::LoadState(Emulator* emu, deque<RewindData>& prevStates, int32_t position, bool sendNotification)
+uint32_t RewindData::GetStateSize()
 {
-	if(_saveStateData.size() == 0) {
-		return;
+	return _pendingData ? _pendingData->GetSize() : (uint32_t)_saveStateData.size();
+}
+
+vector<uint8_t>& RewindData::GetCompressedData()
+{
+	if(_pendingData) {
+		_saveStateData = std::move(_pendingData->GetOutput());
+		_pendingData.reset();
 	}
-		
-	vector<uint8_t> data;
-	CompressionHelper::Decompress(_saveStateData, data);
+	return _saveStateData;
+}
 
-	if(!IsFullState) {
-		position = (position > 0 ? position : (int32_t)prevStates.size()) - 1;
-		ProcessXorState(data, prevStates, position);
+void RewindData::SetStateData(shared_ptr<const vector<uint8_t>> data, RewindCompressor* compressor)
+{
+	if(compressor) {
+		//Compress the data on the compressor's thread
+		_pendingData = compressor->Compress(std::move(data));
+	} else {
+		CompressionHelper::Compress(data->data(), (uint32_t)data->size(), 1, _saveStateData, CompressionCodec::Lz4);
 	}
+}
 
-	stringstream stream;
-	stream.write((char*)data.data(), data.size());
-	stream.seekg(0, ios::beg);
+bool RewindData::GetFullStateData(vector<uint8_t>& data)
+{
+	if(_uncompressedData) {
+		data = *_uncompressedData;
+		return true;
+	}
+	return CompressionHelper::Decompress(GetCompressedData(), data);
+}
 
-	emu->Deserialize(stream, SaveStateManager::FileFormatVersion, true, std::nullopt, sendNotification);
+bool RewindData::GetStateData(vector<uint8_t>& data, deque<RewindData>& prevStates, int32_t position)
+{
+	if(IsFullState) {
+		return GetFullStateData(data);
+	}
+
+	position = (position > 0 ? position : (int32_t)prevStates.size()) - 1;
+	RewindData* fullState = GetFullState(prevStates, position);
+	vector<uint8_t> delta;
+	if(!fullState || !CompressionHelper::Decompress(GetCompressedData(), delta) || !fullState->GetFullStateData(data)) {
+		return false;
+	}
+
+	//Delta format: state size, bitmap of the modified pages, content of the modified pages
+	uint32_t stateSize;
+	memcpy(&stateSize, delta.data(), sizeof(uint32_t));
+	uint32_t pageCount = (stateSize + RewindData::PageSize - 1) / RewindData::PageSize;
+	uint32_t bitmapSize = (pageCount + 7) / 8;
+	if(stateSize != data.size() || delta.size() < sizeof(uint32_t) + bitmapSize) {
+		return false;
+	}
+
+	uint8_t* bitmap = delta.data() + sizeof(uint32_t);
+	uint32_t pos = sizeof(uint32_t) + bitmapSize;
+	for(uint32_t i = 0; i < pageCount; i++) {
+		if(bitmap[i >> 3] & (1 << (i & 0x07))) {
+			uint32_t offset = i * RewindData::PageSize;
+			uint32_t size = std::min(RewindData::PageSize, stateSize - offset);
+			if(pos + size > delta.size()) {
+				return false;
+			}
+			memcpy(data.data() + offset, delta.data() + pos, size);
+			pos += size;
+		}
+	}
+	return true;
 }
 
-void RewindData::SaveState(Emulator* emu, deque<RewindData>& prevStates, int32_t position)
+void RewindData::SaveDeltaState(vector<uint8_t>& data, RewindData& fullState, RewindCompressor* compressor)
 {
-	std::stringstream state;
-	emu->Serialize(state, true, 0);
+	uint32_t stateSize = (uint32_t)data.size();
+	uint32_t pageCount = (stateSize + RewindData::PageSize - 1) / RewindData::PageSize;
+	uint32_t bitmapSize = (pageCount + 7) / 8;
+
+	shared_ptr<vector<uint8_t>> deltaData(new vector<uint8_t>(sizeof(uint32_t) + bitmapSize, 0));
+	vector<uint8_t>& delta = *deltaData;
+	memcpy(delta.data(), &stateSize, sizeof(uint32_t));
+
+	//Only keep the pages that changed since the full state - most of the state (work ram, vram, etc.) is usually unchanged
+	uint8_t* src = data.data();
+	const uint8_t* ref = fullState._uncompressedData->data();
+	for(uint32_t i = 0; i < pageCount; i++) {
+		uint32_t offset = i * RewindData::PageSize;
+		uint32_t size = std::min(RewindData::PageSize, stateSize - offset);
+		if(memcmp(src + offset, ref + offset, size) != 0) {
+			delta[sizeof(uint32_t) + (i >> 3)] |= 1 << (i & 0x07);
+			delta.insert(delta.end(), src + offset, src + offset + size);
+		}
+	}
+
+	SetStateData(std::move(deltaData), compressor);
+}
 
-	string data = state.str();
+void RewindData::LoadState(Emulator* emu, deque<RewindData>& prevStates, int32_t position, bool sendNotification)
+{
+	if(_saveStateData.empty() && !_pendingData) {
+		return;
+	}
+
+	SerializeSnapshot snapshot;
+	snapshot.Schema = _schema;
+	if(!GetStateData(snapshot.Data, prevStates, position)) {
+		return;
+	}
+
+	emu->Deserialize(snapshot, true, sendNotification);
+}
+
+void RewindData::SaveState(Emulator* emu, deque<RewindData>& prevStates, SerializeSnapshot& snapshot, int32_t position, RewindCompressor* compressor)
+{
+	emu->Serialize(snapshot, true);
+	_schema = snapshot.Schema;
 
 	position = position > 0 ? position : (int32_t)prevStates.size();
 
 	if(position > 0 && (position % 30) != 0) {
-		position--;
-		ProcessXorState(data, prevStates, position);
-	} else {
-		IsFullState = true;
-		while(position > 0) {
-			position--;
-			RewindData& prevState = prevStates[position];
-			if(prevState.IsFullState) {
-				//Get rid of previous full state's uncompressed data once the next full state is added
-				prevState._uncompressedData = {};
-				break;
-			}
+		//Delta states are only possible if the state's layout hasn't changed since the full state (same size)
+		RewindData* fullState = GetFullState(prevStates, position - 1);
+		if(fullState && fullState->_uncompressedData && fullState->_uncompressedData->size() == snapshot.Data.size()) {
+			SaveDeltaState(snapshot.Data, *fullState, compressor);
+			FrameCount = 0;
+			return;
 		}
+	}
 
-		//Keep uncompressed data for the next 30 states - this avoids having to decompress the state 30 times
-		_uncompressedData = vector<uint8_t>(data.begin(), data.end());
+	IsFullState = true;
+	while(position > 0) {
+		position--;
+		RewindData& prevState = prevStates[position];
+		if(prevState.IsFullState) {
+			//Get rid of previous full state's uncompressed data once the next full state is added
+			prevState._uncompressedData.reset();
+			break;
+		}
 	}
 
-	CompressionHelper::Compress(data, 1, _saveStateData);
+	//Keep uncompressed data for the next 30 states - this avoids having to decompress the state 30 times.
+	//The same buffer is given to the compressor, the snapshot gets a new one for the next states
+	size_t stateSize = snapshot.Data.size();
+	_uncompressedData.reset(new vector<uint8_t>(std::move(snapshot.Data)));
+	snapshot.Data = {};
+	snapshot.Data.reserve(stateSize);
+
+	SetStateData(_uncompressedData, compressor);
 	FrameCount = 0;
 }
@@ -4,15 +4,34 @@
 #include "Shared/BaseControlDevice.h"
 
 class Emulator;
+class RewindCompressor;
+class RewindCompressionJob;
+struct SerializeSchema;
+struct SerializeSnapshot;
 
 class RewindData
 {
 private:
 	vector<uint8_t> _saveStateData;
-	vector<uint8_t> _uncompressedData;
 
-	template<typename T>
-	void ProcessXorState(T& data, deque<RewindData>& prevStates, int32_t position);
+	//Full states only - shared with the compression job, neither of them modifies it
+	shared_ptr<const vector<uint8_t>> _uncompressedData;
+
+	//States are stored in the packed format, without any header
+	const SerializeSchema* _schema = nullptr;
+
+	//Set while the state is being compressed by the rewind compressor's thread
+	shared_ptr<RewindCompressionJob> _pendingData;
+
+	//Delta states only contain the pages that differ from the previous full state
+	static constexpr uint32_t PageSize = 256;
+
+	static RewindData* GetFullState(deque<RewindData>& prevStates, int32_t position);
+	bool GetFullStateData(vector<uint8_t>& data);
+	bool GetStateData(vector<uint8_t>& data, deque<RewindData>& prevStates, int32_t position);
+	void SaveDeltaState(vector<uint8_t>& data, RewindData& fullState, RewindCompressor* compressor);
+	void SetStateData(shared_ptr<const vector<uint8_t>> data, RewindCompressor* compressor);
+	vector<uint8_t>& GetCompressedData();
 
 public:
 	std::deque<ControlDeviceState> InputLogs[BaseControlDevice::PortCount];
@@ -21,8 +40,9 @@ public:
 	bool IsFullState = false;
 
 	void GetStateData(stringstream& stateData, deque<RewindData>& prevStates, int32_t position);
-	uint32_t GetStateSize() { return (uint32_t)_saveStateData.size(); }
+	uint32_t GetStateSize();
 
 	void LoadState(Emulator* emu, deque<RewindData>& prevStates, int32_t position = -1, bool sendNotification = true);
-	void SaveState(Emulator* emu, deque<RewindData>& prevStates, int32_t position = -1);
+	//The snapshot's buffer is reused from one state to the next (it is only given away for full states)
+	void SaveState(Emulator* emu, deque<RewindData>& prevStates, SerializeSnapshot& snapshot, int32_t position = -1, RewindCompressor* compressor = nullptr);
 };
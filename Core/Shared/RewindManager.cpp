@@ -13,6 +13,7 @@ RewindManager::RewindManager(Emulator* emu)
 {
 	_emu = emu;
 	_settings = emu->GetSettings();
+	_compressor.reset(new RewindCompressor());
 }
 
 RewindManager::~RewindManager()
@@ -46,12 +47,19 @@ void RewindManager::ClearBuffer()
 	_history.clear();
 	_historyBackup.clear();
 	_framesToFastForward = 0;
+	ClearVideoAudioHistory();
+	_rewindState = RewindState::Stopped;
+	_currentHistory = {};
+}
+
+void RewindManager::ClearVideoAudioHistory()
+{
 	_videoHistory.clear();
 	_videoHistoryBuilder.clear();
+	_videoHistorySize = 0;
 	_audioHistory.clear();
 	_audioHistoryBuilder.clear();
-	_rewindState = RewindState::Stopped;
-	_currentHistory = {};
+	_audioHistorySampleCount = 0;
 }
 
 void RewindManager::ProcessNotification(ConsoleNotificationType type, void * parameter)
@@ -143,7 +151,7 @@ void RewindManager::AddHistoryBlock()
 			_history.push_back(_currentHistory);
 		}
 		_currentHistory = RewindData();
-		_currentHistory.SaveState(_emu, _history);
+		_currentHistory.SaveState(_emu, _history, _snapshot, -1, _compressor.get());
 	}
 }
 
@@ -168,8 +176,12 @@ void RewindManager::PopHistory()
 		_currentHistory.LoadState(_emu, _history, -1, false);
 
 		if(!_audioHistoryBuilder.empty()) {
-			_audioHistory.insert(_audioHistory.begin(), _audioHistoryBuilder.begin(), _audioHistoryBuilder.end());
-			_audioHistoryBuilder.clear();
+			//Each block is played before the blocks that precede it in time
+			AudioBlock block;
+			block.Samples.swap(_audioHistoryBuilder);
+			block.Position = (uint32_t)block.Samples.size();
+			_audioHistorySampleCount += block.Position;
+			_audioHistory.push_front(std::move(block));
 		}
 	}
 }
@@ -194,10 +206,7 @@ void RewindManager::InternalStart(bool forDebugger)
 	}
 
 	_rewindState = forDebugger ? RewindState::Debugging : RewindState::Starting;
-	_videoHistoryBuilder.clear();
-	_videoHistory.clear();
-	_audioHistoryBuilder.clear();
-	_audioHistory.clear();
+	ClearVideoAudioHistory();
 	_historyBackup.clear();
 
 	PopHistory();
@@ -230,9 +239,7 @@ void RewindManager::ForceStop(bool deleteFutureData)
 			if(!_videoHistory.empty()) {
 				//Update the frame on the screen to match the last frame generated during step back
 				//Needed to update the screen when stepping back to the previous frame
-				VideoFrame& frameData = _videoHistory.back();
-				RenderedFrame oldFrame(frameData.Data.data(), frameData.Width, frameData.Height, frameData.Scale, frameData.FrameNumber, frameData.InputData);
-				_emu->GetVideoRenderer()->UpdateFrame(oldFrame);
+				DisplayVideoFrame(_videoHistory.back());
 			}
 		} else {
 			while(_historyBackup.size() > 1) {
@@ -289,10 +296,7 @@ void RewindManager::Stop()
 			_settings->ClearFlag(EmulationFlags::Rewind);
 		}
 
-		_videoHistoryBuilder.clear();
-		_videoHistory.clear();
-		_audioHistoryBuilder.clear();
-		_audioHistory.clear();
+		ClearVideoAudioHistory();
 	}
 }
 
@@ -327,18 +331,18 @@ void RewindManager::ProcessFrame(RenderedFrame& frame, bool forRewind)
 			return;
 		}
 
-		VideoFrame newFrame;
-		newFrame.Data = vector<uint32_t>((uint32_t*)frame.FrameBuffer, (uint32_t*)frame.FrameBuffer + frame.Width * frame.Height);
-		newFrame.Width = frame.Width;
-		newFrame.Height = frame.Height;
-		newFrame.Scale = frame.Scale;
-		newFrame.FrameNumber = frame.FrameNumber;
-		newFrame.InputData = frame.InputData;
-		_videoHistoryBuilder.push_back(newFrame);
+		_videoHistoryBuilder.push_back(CreateVideoFrame(frame));
 
 		if(_videoHistoryBuilder.size() == (size_t)_historyBackup.front().FrameCount) {
 			for(int i = (int)_videoHistoryBuilder.size() - 1; i >= 0; i--) {
-				_videoHistory.push_front(_videoHistoryBuilder[i]);
+				VideoFrame& newFrame = _videoHistoryBuilder[i];
+				if(_videoHistorySize + newFrame.GetMemoryUsage() > RewindManager::MaxVideoHistorySize) {
+					//Over budget, drop the frame's data
+					newFrame.Data = {};
+					newFrame.Palette = {};
+				}
+				_videoHistorySize += newFrame.GetMemoryUsage();
+				_videoHistory.push_front(std::move(newFrame));
 			}
 			_videoHistoryBuilder.clear();
 		}
@@ -347,9 +351,9 @@ void RewindManager::ProcessFrame(RenderedFrame& frame, bool forRewind)
 			_rewindState = RewindState::Started;
 			_settings->ClearFlag(EmulationFlags::MaximumSpeed);
 			if(!_videoHistory.empty()) {
-				VideoFrame &frameData = _videoHistory.back();
-				RenderedFrame oldFrame(frameData.Data.data(), frameData.Width, frameData.Height, frameData.Scale, frameData.FrameNumber, frameData.InputData);
-				_emu->GetVideoRenderer()->UpdateFrame(oldFrame);
+				VideoFrame& frameData = _videoHistory.back();
+				DisplayVideoFrame(frameData);
+				_videoHistorySize -= frameData.GetMemoryUsage();
 				_videoHistory.pop_back();
 			}
 		}
@@ -357,15 +361,9 @@ void RewindManager::ProcessFrame(RenderedFrame& frame, bool forRewind)
 		//Display nothing while resyncing
 	} else if(_rewindState == RewindState::Debugging) {
 		//Keep the last frame to be able to display it once step back reaches its target
-		VideoFrame newFrame;
-		newFrame.Data = vector<uint32_t>((uint32_t*)frame.FrameBuffer, (uint32_t*)frame.FrameBuffer + frame.Width * frame.Height);
-		newFrame.Width = frame.Width;
-		newFrame.Height = frame.Height;
-		newFrame.Scale = frame.Scale;
-		newFrame.FrameNumber = frame.FrameNumber;
-		newFrame.InputData = frame.InputData;
 		_videoHistory.clear();
-		_videoHistory.push_back(newFrame);
+		_videoHistory.push_back(CreateVideoFrame(frame));
+		_videoHistorySize = _videoHistory.back().GetMemoryUsage();
 	} else {
 		_emu->GetVideoRenderer()->UpdateFrame(frame);
 	}
@@ -376,12 +374,8 @@ bool RewindManager::ProcessAudio(int16_t * soundBuffer, uint32_t sampleCount)
 	if(_rewindState == RewindState::Starting || _rewindState == RewindState::Started) {
 		_audioHistoryBuilder.insert(_audioHistoryBuilder.end(), soundBuffer, soundBuffer + sampleCount * 2);
 
-		if(_rewindState == RewindState::Started && _audioHistory.size() > sampleCount * 2) {
-			for(uint32_t i = 0; i < sampleCount * 2; i++) {
-				soundBuffer[i] = _audioHistory.back();
-				_audioHistory.pop_back();
-			}
-
+		if(_rewindState == RewindState::Started && _audioHistorySampleCount > sampleCount * 2) {
+			ReadAudioHistory(soundBuffer, sampleCount * 2);
 			return true;
 		} else {
 			//Mute while we prepare to rewind
@@ -395,6 +389,140 @@ bool RewindManager::ProcessAudio(int16_t * soundBuffer, uint32_t sampleCount)
 	}
 }
 
+void RewindManager::ReadAudioHistory(int16_t* soundBuffer, uint32_t sampleCount)
+{
+	//Samples are played backwards, starting from the end of the last block
+	for(uint32_t i = 0; i < sampleCount && !_audioHistory.empty(); i++) {
+		AudioBlock& block = _audioHistory.back();
+		soundBuffer[i] = block.Samples[--block.Position];
+		if(block.Position == 0) {
+			_audioHistory.pop_back();
+		}
+	}
+	_audioHistorySampleCount -= std::min(_audioHistorySampleCount, sampleCount);
+}
+
+VideoFrame RewindManager::CreateVideoFrame(RenderedFrame& frame)
+{
+	VideoFrame newFrame;
+	newFrame.Compress((uint32_t*)frame.FrameBuffer, frame.Width * frame.Height);
+	newFrame.Width = frame.Width;
+	newFrame.Height = frame.Height;
+	newFrame.Scale = frame.Scale;
+	newFrame.FrameNumber = frame.FrameNumber;
+	newFrame.InputData = frame.InputData;
+	return newFrame;
+}
+
+void RewindManager::DisplayVideoFrame(VideoFrame& frameData)
+{
+	if(frameData.Decompress(_videoFrameBuffer)) {
+		RenderedFrame oldFrame(_videoFrameBuffer.data(), frameData.Width, frameData.Height, frameData.Scale, frameData.FrameNumber, frameData.InputData);
+		_emu->GetVideoRenderer()->UpdateFrame(oldFrame);
+	}
+}
+
+void VideoFrame::Compress(uint32_t* buffer, uint32_t pixelCount)
+{
+	//Map each color to a palette index, using a small hash table (frames rarely contain more than a few dozen colors)
+	constexpr uint32_t tableSize = 1024;
+	uint32_t colors[tableSize];
+	int16_t indexes[tableSize];
+	memset(indexes, -1, sizeof(indexes));
+
+	vector<uint8_t> pixels(pixelCount);
+	uint32_t lastColor = 0;
+	int lastIndex = -1;
+	IsPaletted = true;
+	for(uint32_t i = 0; i < pixelCount; i++) {
+		uint32_t color = buffer[i];
+		if(color != lastColor || lastIndex < 0) {
+			uint32_t slot = (color * 2654435761u) >> 22;
+			while(indexes[slot] >= 0 && colors[slot] != color) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if(indexes[slot] < 0) {
+				if(Palette.size() == 256) {
+					//Too many colors, store the raw frame
+					IsPaletted = false;
+					break;
+				}
+				colors[slot] = color;
+				indexes[slot] = (int16_t)Palette.size();
+				Palette.push_back(color);
+			}
+			lastColor = color;
+			lastIndex = indexes[slot];
+		}
+		pixels[i] = (uint8_t)lastIndex;
+	}
+
+	if(!IsPaletted) {
+		Palette = {};
+		Data = vector<uint8_t>((uint8_t*)buffer, (uint8_t*)(buffer + pixelCount));
+		return;
+	}
+
+	//RLE: control byte 0-127 = copy the next n+1 bytes, 128-255 = repeat the next byte n-125 times
+	Data.reserve(pixelCount / 4);
+	uint32_t i = 0;
+	while(i < pixelCount) {
+		uint32_t runLength = 1;
+		while(i + runLength < pixelCount && runLength < 130 && pixels[i + runLength] == pixels[i]) {
+			runLength++;
+		}
+
+		if(runLength >= 3) {
+			Data.push_back((uint8_t)(runLength + 125));
+			Data.push_back(pixels[i]);
+			i += runLength;
+		} else {
+			uint32_t start = i;
+			while(i < pixelCount && i - start < 128) {
+				if(i + 2 < pixelCount && pixels[i] == pixels[i + 1] && pixels[i] == pixels[i + 2]) {
+					break;
+				}
+				i++;
+			}
+			Data.push_back((uint8_t)(i - start - 1));
+			Data.insert(Data.end(), pixels.begin() + start, pixels.begin() + i);
+		}
+	}
+	Data.shrink_to_fit();
+}
+
+bool VideoFrame::Decompress(vector<uint32_t>& output)
+{
+	uint32_t pixelCount = Width * Height;
+	if(Data.empty() || pixelCount == 0) {
+		return false;
+	}
+
+	output.resize(pixelCount);
+	if(!IsPaletted) {
+		memcpy(output.data(), Data.data(), std::min<size_t>(Data.size(), pixelCount * sizeof(uint32_t)));
+		return true;
+	}
+
+	uint32_t pos = 0;
+	size_t i = 0;
+	while(i < Data.size() && pos < pixelCount) {
+		uint8_t control = Data[i++];
+		if(control >= 128) {
+			uint32_t color = i < Data.size() ? Palette[Data[i++] % Palette.size()] : 0;
+			uint32_t end = std::min<uint32_t>(pos + control - 125, pixelCount);
+			std::fill(output.begin() + pos, output.begin() + end, color);
+			pos = end;
+		} else {
+			for(uint32_t j = 0; j <= control && i < Data.size() && pos < pixelCount; j++) {
+				output[pos++] = Palette[Data[i++] % Palette.size()];
+			}
+		}
+	}
+	return true;
+}
+
 void RewindManager::RecordInput(vector<shared_ptr<BaseControlDevice>> devices)
 {
 	if(_settings->GetPreferences().RewindBufferSize > 0 && _rewindState == RewindState::Stopped) {
@@ -3,8 +3,10 @@
 #include <deque>
 #include "Shared/Interfaces/INotificationListener.h"
 #include "Shared/RewindData.h"
+#include "Shared/RewindCompressor.h"
 #include "Shared/Interfaces/IInputProvider.h"
 #include "Shared/Interfaces/IInputRecorder.h"
+#include "Utilities/Serializer.h"
 
 class Emulator;
 class EmuSettings;
@@ -21,12 +23,27 @@ enum class RewindState
 
 struct VideoFrame
 {
-	vector<uint32_t> Data;
+	//Frames with 256 colors or less (most frames) are stored as RLE-compressed palette indexes, others as raw ARGB pixels
+	vector<uint8_t> Data;
+	vector<uint32_t> Palette;
+	bool IsPaletted = false;
+
 	uint32_t Width = 0;
 	uint32_t Height = 0;
 	double Scale = 0;
 	uint32_t FrameNumber = 0;
 	vector<ControllerData> InputData;
+
+	void Compress(uint32_t* buffer, uint32_t pixelCount);
+	bool Decompress(vector<uint32_t>& output);
+	uint32_t GetMemoryUsage() { return (uint32_t)(Data.size() + Palette.size() * sizeof(uint32_t)); }
+};
+
+//Rewind audio is kept in blocks (one per 30-frame history block), in the order they were generated
+struct AudioBlock
+{
+	vector<int16_t> Samples;
+	uint32_t Position = 0; //Number of samples not yet played (the block is played backwards)
 };
 
 struct RewindStats
@@ -50,14 +67,23 @@ private:
 	deque<RewindData> _history;
 	deque<RewindData> _historyBackup;
 	RewindData _currentHistory = {};
+	unique_ptr<RewindCompressor> _compressor;
+	SerializeSnapshot _snapshot;
 
 	RewindState _rewindState = RewindState::Stopped;
 	int32_t _framesToFastForward = 0;
 
+	//Frames whose data goes over the budget are kept without their data (nothing is displayed for them), to keep the frame count intact
+	static constexpr uint32_t MaxVideoHistorySize = 128 * 1024 * 1024;
+
 	deque<VideoFrame> _videoHistory;
 	vector<VideoFrame> _videoHistoryBuilder;
-	deque<int16_t> _audioHistory;
+	uint32_t _videoHistorySize = 0;
+	vector<uint32_t> _videoFrameBuffer;
+
+	deque<AudioBlock> _audioHistory;
 	vector<int16_t> _audioHistoryBuilder;
+	uint32_t _audioHistorySampleCount = 0;
 
 	void AddHistoryBlock();
 	void PopHistory();
@@ -71,6 +97,11 @@ private:
 	bool ProcessAudio(int16_t* soundBuffer, uint32_t sampleCount);
 	
 	void ClearBuffer();
+	void ClearVideoAudioHistory();
+
+	VideoFrame CreateVideoFrame(RenderedFrame& frame);
+	void DisplayVideoFrame(VideoFrame& frameData);
+	void ReadAudioHistory(int16_t* soundBuffer, uint32_t sampleCount);
 
 public:
 	RewindManager(Emulator* emu);
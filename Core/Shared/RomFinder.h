@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "Shared/Emulator.h"
 #include "Shared/MessageManager.h"
+#include "Shared/CdReader.h"
 #include "Utilities/VirtualFile.h"
 #include "Utilities/FolderUtilities.h"
 #include "Utilities/HexUtilities.h"
@@ -9,6 +10,16 @@
 class RomFinder
 {
 private:
+	static uint32_t GetCrc32(VirtualFile file)
+	{
+		//CHD images are identified by a hash of their content (same value as Emulator::GetCrc32 for these games)
+		if(file.GetFileExtension() == ".chd") {
+			DiscInfo disc = {};
+			return CdReader::LoadChd(file, disc) ? disc.Crc32 : 0;
+		}
+		return file.GetCrc32();
+	}
+
 	static string FindMatchingRom(Emulator* emu, string romName, uint32_t crc32)
 	{
 		if(emu->IsRunning() && emu->GetCrc32() == crc32) {
@@ -37,7 +48,7 @@ private:
 				string lcRomFile = romFilename;
 				std::transform(lcRomFile.begin(), lcRomFile.end(), lcRomFile.begin(), ::tolower);
 
-				if(FolderUtilities::GetFilename(lcRomname, false) == FolderUtilities::GetFilename(lcRomFile, false) && VirtualFile(romFilename).GetCrc32() == crc32) {
+				if(FolderUtilities::GetFilename(lcRomname, false) == FolderUtilities::GetFilename(lcRomFile, false) && GetCrc32(VirtualFile(romFilename)) == crc32) {
 					return romFilename;
 				}
 			}
@@ -610,6 +610,7 @@ struct NesConfig
 
 	ConsoleRegion Region = ConsoleRegion::Auto;
 	bool EnableHdPacks = true;
+	bool CacheHdPackBitmaps = false;
 	bool DisableGameDatabase = false;
 	bool FdsAutoLoadDisk = true;
 	bool FdsFastForwardOnLoad = false;
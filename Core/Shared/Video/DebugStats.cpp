@@ -6,6 +6,7 @@
 #include "Shared/Emulator.h"
 #include "Shared/RewindManager.h"
 #include "Shared/EmuSettings.h"
+#include "EmuNwa/EmuNwaServer.h"
 
 void DebugStats::DisplayStats(Emulator *emu, double lastFrameTime)
 {
@@ -103,4 +104,71 @@ void DebugStats::DisplayStats(Emulator *emu, double lastFrameTime)
 		ss << "   Per min.: " << std::fixed << std::setprecision(2) << (memUsage * 60 * 60 / rewindStats.HistoryDuration) << " MB";
 		hud->DrawString(9, 82, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
 	}
+
+	DisplayEmuNwaStats(emu, startFrame);
+	DisplayRunAheadStats(emu, startFrame);
+}
+
+void DebugStats::DisplayEmuNwaStats(Emulator* emu, int startFrame)
+{
+	EmuNwaServer* server = emu->GetEmuNwaServer();
+	if(!server->Started()) {
+		return;
+	}
+
+	DebugHud* hud = emu->GetDebugHud();
+
+	//Requests and lock wait time since the previous frame, to show how much the tools connected to the server slow down emulation
+	EmuNwaStatsTotals totals = server->GetStats()->GetTotals();
+	uint64_t requests = totals.Requests >= _lastNwaTotals.Requests ? totals.Requests - _lastNwaTotals.Requests : 0;
+	uint64_t lockWaitNs = totals.LockWaitNs >= _lastNwaTotals.LockWaitNs ? totals.LockWaitNs - _lastNwaTotals.LockWaitNs : 0;
+	_lastNwaTotals = totals;
+
+	hud->DrawRectangle(8, 97, 115, 52, 0x40000000, true, 1, startFrame);
+	hud->DrawRectangle(8, 97, 115, 52, 0xFFFFFF, false, 1, startFrame);
+
+	hud->DrawString(10, 99, "EmuNwa Stats", 0xFFFFFF, 0xFF000000, 1, startFrame);
+	hud->DrawString(10, 110, "Clients: " + std::to_string(totals.ConnectionCount), 0xFFFFFF, 0xFF000000, 1, startFrame);
+	hud->DrawString(10, 119, "Requests: " + std::to_string(requests), 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	std::stringstream ss;
+	ss << "Lock wait: " << std::fixed << std::setprecision(2) << (lockWaitNs / 1000000.0) << " ms";
+	hud->DrawString(10, 128, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	ss = std::stringstream();
+	ss << "p99: " << std::fixed << std::setprecision(2) << (totals.P99LatencyUs / 1000.0) << " ms";
+	hud->DrawString(10, 137, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
+}
+
+void DebugStats::DisplayRunAheadStats(Emulator* emu, int startFrame)
+{
+	if(emu->GetSettings()->GetEmulationConfig().RunAheadFrames == 0) {
+		return;
+	}
+
+	DebugHud* hud = emu->GetDebugHud();
+	RunAheadStats stats = emu->GetRunAheadStats();
+
+	hud->DrawRectangle(132, 97, 115, 52, 0x40000000, true, 1, startFrame);
+	hud->DrawRectangle(132, 97, 115, 52, 0xFFFFFF, false, 1, startFrame);
+
+	hud->DrawString(134, 99, "Run-ahead Stats", 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	std::stringstream ss;
+	ss << "Save: " << std::fixed << std::setprecision(3) << stats.SaveTime << " ms";
+	hud->DrawString(134, 110, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	ss = std::stringstream();
+	ss << "Load: " << std::fixed << std::setprecision(3) << stats.LoadTime << " ms";
+	hud->DrawString(134, 119, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	hud->DrawString(134, 128, "State Size: " + std::to_string(stats.StateSize / 1024) + "kb", 0xFFFFFF, 0xFF000000, 1, startFrame);
+
+	//Time saved compared to saving/loading the same state through a stringstream (measured once)
+	if(stats.StreamMeasured) {
+		double saved = (stats.StreamSaveTime + stats.StreamLoadTime) - (stats.SaveTime + stats.LoadTime);
+		ss = std::stringstream();
+		ss << "Saved: " << std::fixed << std::setprecision(3) << std::max(0.0, saved) << " ms/frame";
+		hud->DrawString(134, 137, ss.str(), 0xFFFFFF, 0xFF000000, 1, startFrame);
+	}
 }
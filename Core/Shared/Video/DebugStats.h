@@ -1,5 +1,6 @@
 #pragma once
 #include "pch.h"
+#include "EmuNwa/EmuNwaStats.h"
 
 class Emulator;
 
@@ -10,6 +11,10 @@ private:
 	uint32_t _frameDurationIndex = 0;
 	double _lastFrameMin = 9999;
 	double _lastFrameMax = 0;
+	EmuNwaStatsTotals _lastNwaTotals = {};
+
+	void DisplayEmuNwaStats(Emulator* emu, int startFrame);
+	void DisplayRunAheadStats(Emulator* emu, int startFrame);
 
 public:
 	void DisplayStats(Emulator *emu, double lastFrameTime);
@@ -82,8 +82,9 @@ extern "C"
 	DllExport uint32_t __stdcall GetExecutionTrace(TraceRow output[], uint32_t startOffset, uint32_t lineCount) { return WithDebugger(uint32_t, GetExecutionTrace(output, startOffset, lineCount)); }
 	DllExport void __stdcall ClearExecutionTrace() { WithDebugger(void, ClearExecutionTrace()); }
 
-	DllExport void __stdcall StartLogTraceToFile(const char* filename) { WithDebugger(void, GetTraceLogFileSaver()->StartLogging(filename)); }
+	DllExport void __stdcall StartLogTraceToFile(const char* filename, bool binaryFormat) { WithDebugger(void, GetTraceLogFileSaver()->StartLogging(filename, binaryFormat)); }
 	DllExport void __stdcall StopLogTraceToFile() { WithDebugger(void, GetTraceLogFileSaver()->StopLogging()); }
+	DllExport bool __stdcall ConvertBinaryTraceLog(const char* inputFile, const char* outputFile) { return WithDebugger(bool, GetTraceLogFileSaver()->ConvertBinaryLog(inputFile, outputFile)); }
 
 	DllExport void __stdcall SetBreakpoints(Breakpoint breakpoints[], uint32_t length) { WithDebugger(void, SetBreakpoints(breakpoints, length)); }
 	
@@ -12,6 +12,10 @@
 #include "Core/Shared/TimingInfo.h"
 #include "Core/Shared/CheatManager.h"
 #include "Core/Shared/DebuggerRequest.h"
+#include "Core/Shared/EmulatorBenchmark.h"
+#include "Core/EmuNwa/EmuNwaBenchmark.h"
+#include "Core/EmuNwa/EmuNwaServer.h"
+#include "Core/NES/HdPacks/HdPackBenchmark.h"
 #include "Core/Netplay/GameClient.h"
 #include "Core/Netplay/GameServer.h"
 #include "Utilities/ArchiveReader.h"
@@ -312,6 +316,31 @@ extern "C" {
 		void SetDisabled(bool disabled) {}
 	};
 
+	static void PgoInitEmulator()
+	{
+		KeyManager::SetSettings(_emu->GetSettings());
+		_emu->Initialize();
+
+		//Map key #10 to the start button for all consoles - this key is toggled on/off every 4 frames
+		NesConfig& nesCfg = _emu->GetSettings()->GetNesConfig();
+		nesCfg.Port1.Type = ControllerType::NesController;
+		nesCfg.Port1.Keys.Mapping1.Start = 10;
+
+		SnesConfig& snesCfg = _emu->GetSettings()->GetSnesConfig();
+		snesCfg.Port1.Type = ControllerType::SnesController;
+		snesCfg.Port1.Keys.Mapping1.Start = 10;
+
+		GameboyConfig& gbCfg = _emu->GetSettings()->GetGameboyConfig();
+		gbCfg.Model = GameboyModel::GameboyColor;
+		gbCfg.Controller.Keys.Mapping1.Start = 10;
+
+		PcEngineConfig& pceCfg = _emu->GetSettings()->GetPcEngineConfig();
+		pceCfg.Port1.Type = ControllerType::PceController;
+		pceCfg.Port1.Keys.Mapping1.Start = 10;
+
+		_emu->GetSettings()->SetFlag(EmulationFlags::MaximumSpeed);
+	}
+
 	DllExport void __stdcall PgoRunTest(vector<string> testRoms, bool enableDebugger)
 	{
 		FolderUtilities::SetHomeFolder("../PGOMesenHome");
@@ -321,27 +350,7 @@ extern "C" {
 		for(size_t i = 0; i < testRoms.size(); i++) {
 			std::cout << "Running: " << testRoms[i] << std::endl;
 
-			KeyManager::SetSettings(_emu->GetSettings());
-			_emu->Initialize();
-
-			//Map key #10 to the start button for all consoles - this key is toggled on/off every 4 frames
-			NesConfig& nesCfg = _emu->GetSettings()->GetNesConfig();
-			nesCfg.Port1.Type = ControllerType::NesController;
-			nesCfg.Port1.Keys.Mapping1.Start = 10;
-
-			SnesConfig& snesCfg = _emu->GetSettings()->GetSnesConfig();
-			snesCfg.Port1.Type = ControllerType::SnesController;
-			snesCfg.Port1.Keys.Mapping1.Start = 10;
-
-			GameboyConfig& gbCfg = _emu->GetSettings()->GetGameboyConfig();
-			gbCfg.Model = GameboyModel::GameboyColor;
-			gbCfg.Controller.Keys.Mapping1.Start = 10;
-
-			PcEngineConfig& pceCfg = _emu->GetSettings()->GetPcEngineConfig();
-			pceCfg.Port1.Type = ControllerType::PceController;
-			pceCfg.Port1.Keys.Mapping1.Start = 10;
-
-			_emu->GetSettings()->SetFlag(EmulationFlags::MaximumSpeed);
+			PgoInitEmulator();
 			_emu->LoadRom((VirtualFile)testRoms[i], VirtualFile());
 
 			if(enableDebugger) {
@@ -356,4 +365,147 @@ extern "C" {
 			_emu->Release();
 		}
 	}
+
+	DllExport void __stdcall BenchmarkRunTest(vector<string> testRoms, uint32_t frameCount, uint32_t runCount, bool enableDebugger, char* outputFile)
+	{
+		//Runs each rom for a fixed number of frames (with no video or audio output), runCount times,
+		//with and without the debugger, and writes the timings to a JSON file
+		constexpr uint32_t warmupFrameCount = 120;
+
+		FolderUtilities::SetHomeFolder("../PGOMesenHome");
+		PgoKeyManager pgoKeyManager;
+		KeyManager::RegisterKeyManager(&pgoKeyManager);
+
+		shared_ptr<EmulatorBenchmark> benchmark(new EmulatorBenchmark(_emu.get(), frameCount, warmupFrameCount));
+		vector<BenchmarkRomResult> results;
+		string version;
+
+		for(size_t i = 0; i < testRoms.size(); i++) {
+			BenchmarkRomResult romResult = {};
+			romResult.RomName = FolderUtilities::GetFilename(testRoms[i], true);
+
+			for(int debugger = 0; debugger <= (enableDebugger ? 1 : 0); debugger++) {
+				for(uint32_t run = 0; run < runCount; run++) {
+					std::cout << "Benchmarking: " << romResult.RomName << (debugger ? " (debugger)" : "") << " - run " << (run + 1) << "/" << runCount << std::endl;
+
+					PgoInitEmulator();
+					version = _emu->GetSettings()->GetVersionString();
+
+					VirtualFile romFile = testRoms[i];
+					BenchmarkRunResult result = benchmark->Run(romFile, debugger != 0);
+					if(!result.Completed) {
+						std::cout << "Run failed: " << romResult.RomName << std::endl;
+					} else {
+						romResult.Console = result.Console;
+					}
+					(debugger ? romResult.DebuggerRuns : romResult.Runs).push_back(std::move(result));
+
+					_emu->Stop(false);
+					_emu->Release();
+				}
+			}
+
+			results.push_back(std::move(romResult));
+		}
+
+		string json = EmulatorBenchmark::ToJson(results, version, frameCount, warmupFrameCount);
+		ofstream out(outputFile, ios::out | ios::binary);
+		if(out) {
+			out << json;
+			std::cout << "Results saved to: " << outputFile << std::endl;
+		} else {
+			std::cout << json;
+		}
+	}
+
+	DllExport void __stdcall EmuNwaBenchmarkRunTest(vector<string> testRoms, uint32_t requestCount, vector<uint32_t> clientCounts, char* outputFile)
+	{
+		//Loads each rom, starts the EmuNwa server and measures the round trip time of small requests
+		//sent by a local client, then load tests the server with each number of clients in clientCounts
+		//(the requests are split between the clients) and writes the results to a JSON file
+		FolderUtilities::SetHomeFolder("../PGOMesenHome");
+		PgoKeyManager pgoKeyManager;
+		KeyManager::RegisterKeyManager(&pgoKeyManager);
+
+		EmuNwaBenchmark benchmark(_emu.get());
+		vector<EmuNwaBenchmarkRomResult> results;
+		string version;
+
+		for(size_t i = 0; i < testRoms.size(); i++) {
+			EmuNwaBenchmarkRomResult romResult = {};
+			romResult.RomName = FolderUtilities::GetFilename(testRoms[i], true);
+			std::cout << "Benchmarking EmuNwa: " << romResult.RomName << std::endl;
+
+			PgoInitEmulator();
+			version = _emu->GetSettings()->GetVersionString();
+
+			//Tools usually connect while the game runs at normal speed
+			_emu->GetSettings()->ClearFlag(EmulationFlags::MaximumSpeed);
+
+			if(_emu->LoadRom((VirtualFile)testRoms[i], VirtualFile())) {
+				romResult.Console = _emu->GetConsoleType();
+
+				EmuNwaServer* server = _emu->GetEmuNwaServer();
+				server->StartServer();
+				while(!server->Started()) {
+					std::this_thread::sleep_for(std::chrono::duration<int, std::milli>(10));
+				}
+
+				vector<std::pair<string, string>> requests = benchmark.GetRequests();
+				for(std::pair<string, string>& request : requests) {
+					romResult.Requests.push_back(benchmark.RunRequestReply(request.first, request.second, requestCount));
+				}
+
+				//The last request is the most expensive one (a read through the CPU's bus, when the core has one)
+				for(uint32_t clientCount : clientCounts) {
+					std::cout << "  Load test: " << clientCount << " clients" << std::endl;
+					uint32_t requestsPerClient = std::max<uint32_t>(requestCount / std::max<uint32_t>(clientCount, 1), 1);
+					romResult.LoadTests.push_back(benchmark.RunLoadTest(requests.back().first, requests.back().second, clientCount, requestsPerClient));
+				}
+				server->StopServer();
+			} else {
+				std::cout << "Could not load: " << romResult.RomName << std::endl;
+			}
+
+			_emu->Stop(false);
+			_emu->Release();
+			results.push_back(std::move(romResult));
+		}
+
+		string json = EmuNwaBenchmark::ToJson(results, version, requestCount);
+		ofstream out(outputFile, ios::out | ios::binary);
+		if(out) {
+			out << json;
+			std::cout << "Results saved to: " << outputFile << std::endl;
+		} else {
+			std::cout << json;
+		}
+	}
+
+	DllExport void __stdcall HdPackBenchmarkRunTest(vector<uint32_t> variantCounts, uint32_t frameCount, char* outputFile)
+	{
+		//Generates a synthetic HD pack for each variant count (number of replacements per tile/palette),
+		//measures the time needed to load it and to match every pixel's tile, and writes the results to a JSON file
+		FolderUtilities::SetHomeFolder("../PGOMesenHome");
+		string packFolder = FolderUtilities::CombinePath(FolderUtilities::GetHomeFolder(), "HdPackBenchmark");
+
+		vector<HdPackBenchmarkResult> results;
+		for(uint32_t variantCount : variantCounts) {
+			std::cout << "Benchmarking HD pack tile matching: " << variantCount << " variants" << std::endl;
+			HdPackBenchmarkResult result = HdPackBenchmark::Run(packFolder, variantCount, frameCount);
+			if(!result.Loaded) {
+				std::cout << "Could not load the HD pack" << std::endl;
+			}
+			results.push_back(std::move(result));
+		}
+
+		string json = HdPackBenchmark::ToJson(results, _emu->GetSettings()->GetVersionString(), frameCount);
+		ofstream out(outputFile, ios::out | ios::binary);
+		if(out) {
+			out << json;
+			std::cout << "Results saved to: " << outputFile << std::endl;
+		} else {
+			std::cout << json;
+		}
+	}
 }
\ No newline at end of file
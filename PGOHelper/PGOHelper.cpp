@@ -2,6 +2,7 @@
 #include <string>
 #include <algorithm>
 #include <unordered_set>
+#include <cstdint>
 #if __has_include(<filesystem>)
 	#include <filesystem>
 	namespace fs = std::filesystem;
@@ -15,6 +16,24 @@ using std::vector;
 
 extern "C" {
 	void __stdcall PgoRunTest(vector<string> testRoms, bool enableDebugger);
+	void __stdcall BenchmarkRunTest(vector<string> testRoms, uint32_t frameCount, uint32_t runCount, bool enableDebugger, char* outputFile);
+	void __stdcall EmuNwaBenchmarkRunTest(vector<string> testRoms, uint32_t requestCount, vector<uint32_t> clientCounts, char* outputFile);
+	void __stdcall HdPackBenchmarkRunTest(vector<uint32_t> variantCounts, uint32_t frameCount, char* outputFile);
+}
+
+//Parses a comma-separated list of numbers, e.g: 1,8,32
+vector<uint32_t> ParseNumberList(string value)
+{
+	vector<uint32_t> numbers;
+	size_t start = 0;
+	while(start < value.size()) {
+		size_t end = std::min(value.find(',', start), value.size());
+		if(end > start) {
+			numbers.push_back((uint32_t)std::stoul(value.substr(start, end - start)));
+		}
+		start = end + 1;
+	}
+	return numbers;
 }
 
 vector<string> GetFilesInFolder(string rootFolder, std::unordered_set<string> extensions)
@@ -42,13 +61,60 @@ vector<string> GetFilesInFolder(string rootFolder, std::unordered_set<string> ex
 
 int main(int argc, char* argv[])
 {
+	//Usage: pgohelper [--benchmark] [--frames N] [--runs N] [--no-debugger] [--output file.json] [romFolder]
+	//       pgohelper --emunwa [--requests N] [--clients N,N,...] [--output file.json] [romFolder]
+	//       pgohelper --hdpack [--variants N,N,...] [--frames N] [--output file.json]
 	string romFolder = "../PGOGames";
-	if(argc >= 2) {
-		romFolder = argv[1];
+	string outputFile = "benchmark.json";
+	bool benchmark = false;
+	bool emuNwaBenchmark = false;
+	bool hdPackBenchmark = false;
+	bool enableDebugger = true;
+	uint32_t frameCount = 3000;
+	uint32_t runCount = 5;
+	uint32_t requestCount = 20000;
+	vector<uint32_t> clientCounts = { 4, 16, 64 };
+	vector<uint32_t> variantCounts = { 1, 4, 16 };
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg == "--benchmark") {
+			benchmark = true;
+		} else if(arg == "--emunwa") {
+			emuNwaBenchmark = true;
+		} else if(arg == "--requests" && i + 1 < argc) {
+			requestCount = (uint32_t)std::stoul(argv[++i]);
+		} else if(arg == "--clients" && i + 1 < argc) {
+			clientCounts = ParseNumberList(argv[++i]);
+		} else if(arg == "--hdpack") {
+			hdPackBenchmark = true;
+		} else if(arg == "--variants" && i + 1 < argc) {
+			variantCounts = ParseNumberList(argv[++i]);
+		} else if(arg == "--no-debugger") {
+			enableDebugger = false;
+		} else if(arg == "--frames" && i + 1 < argc) {
+			frameCount = (uint32_t)std::stoul(argv[++i]);
+		} else if(arg == "--runs" && i + 1 < argc) {
+			runCount = (uint32_t)std::stoul(argv[++i]);
+		} else if(arg == "--output" && i + 1 < argc) {
+			outputFile = argv[++i];
+		} else {
+			romFolder = arg;
+		}
 	}
 
-	vector<string> testRoms = GetFilesInFolder(romFolder, { ".sfc", ".gb", ".gbc", ".gbx", ".nes", ".pce", ".cue", ".sms", ".gg", ".sg", ".gba", ".col", ".ws", ".wsc" });
-	PgoRunTest(testRoms, true);
+	vector<string> testRoms = GetFilesInFolder(romFolder, { ".sfc", ".gb", ".gbc", ".gbx", ".nes", ".pce", ".cue", ".chd", ".sms", ".gg", ".sg", ".gba", ".col", ".ws", ".wsc" });
+	std::sort(testRoms.begin(), testRoms.end());
+
+	if(hdPackBenchmark) {
+		HdPackBenchmarkRunTest(variantCounts, frameCount, (char*)outputFile.c_str());
+	} else if(emuNwaBenchmark) {
+		EmuNwaBenchmarkRunTest(testRoms, requestCount, clientCounts, (char*)outputFile.c_str());
+	} else if(benchmark) {
+		BenchmarkRunTest(testRoms, frameCount, runCount, enableDebugger, (char*)outputFile.c_str());
+	} else {
+		PgoRunTest(testRoms, true);
+	}
 	return 0;
 }
 
@@ -39,6 +39,7 @@ namespace Mesen.Config
 		[Reactive] public ConsoleRegion Region { get; set; } = ConsoleRegion.Auto;
 
 		[Reactive] public bool EnableHdPacks { get; set; } = true;
+		[Reactive] public bool CacheHdPackBitmaps { get; set; } = false;
 		[Reactive] public bool DisableGameDatabase { get; set; } = false;
 		[Reactive] public bool FdsAutoLoadDisk { get; set; } = true;
 		[Reactive] public bool FdsFastForwardOnLoad { get; set; } = false;
@@ -161,6 +162,7 @@ namespace Mesen.Config
 
 				Region = Region,
 				EnableHdPacks = EnableHdPacks,
+				CacheHdPackBitmaps = CacheHdPackBitmaps,
 				DisableGameDatabase = DisableGameDatabase,
 				FdsAutoLoadDisk = FdsAutoLoadDisk,
 				FdsFastForwardOnLoad = FdsFastForwardOnLoad,
@@ -298,6 +300,7 @@ namespace Mesen.Config
 
 		public ConsoleRegion Region;
 		[MarshalAs(UnmanagedType.I1)] public bool EnableHdPacks;
+		[MarshalAs(UnmanagedType.I1)] public bool CacheHdPackBitmaps;
 		[MarshalAs(UnmanagedType.I1)] public bool DisableGameDatabase;
 		[MarshalAs(UnmanagedType.I1)] public bool FdsAutoLoadDisk;
 		[MarshalAs(UnmanagedType.I1)] public bool FdsFastForwardOnLoad;
@@ -24,8 +24,9 @@ namespace Mesen.Interop
 		[DllImport(DllPath)] public static extern void ResumeExecution();
 		[DllImport(DllPath)] public static extern void Step(CpuType cpuType, Int32 instructionCount, StepType type = StepType.Step);
 
-		[DllImport(DllPath)] public static extern void StartLogTraceToFile([MarshalAs(UnmanagedType.LPUTF8Str)] string filename);
+		[DllImport(DllPath)] public static extern void StartLogTraceToFile([MarshalAs(UnmanagedType.LPUTF8Str)] string filename, [MarshalAs(UnmanagedType.I1)] bool binaryFormat = false);
 		[DllImport(DllPath)] public static extern void StopLogTraceToFile();
+		[DllImport(DllPath)][return: MarshalAs(UnmanagedType.I1)] public static extern bool ConvertBinaryTraceLog([MarshalAs(UnmanagedType.LPUTF8Str)] string inputFile, [MarshalAs(UnmanagedType.LPUTF8Str)] string outputFile);
 
 		[DllImport(DllPath)] public static extern void SetTraceOptions(CpuType cpuType, InteropTraceLoggerOptions options);
 
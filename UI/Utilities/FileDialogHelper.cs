@@ -55,7 +55,7 @@ namespace Mesen.Utilities
 							"*.sfc", "*.fig", "*.smc", "*.bs", "*.st", "*.spc",
 							"*.nes", "*.fds", "*.qd", "*.unif", "*.unf", "*.studybox", "*.nsf", "*.nsfe",
 							"*.gb", "*.gbc", "*.gbx", "*.gbs",
-							"*.pce", "*.sgx", "*.cue", "*.hes",
+							"*.pce", "*.sgx", "*.cue", "*.chd", "*.hes",
 							"*.sms", "*.gg", "*.sg", "*.col",
 							"*.gba",
 							"*.ws", "*.wsc",
@@ -65,7 +65,7 @@ namespace Mesen.Utilities
 						filter.Add(new FilePickerFileType("NES ROM files") { Patterns = new List<string>() { "*.nes", "*.fds", "*.qd", "*.unif", "*.unf", "*.studybox", "*.nsf", "*.nsfe" } });
 						filter.Add(new FilePickerFileType("GB ROM files") { Patterns = new List<string>() { "*.gb", "*.gbc", "*.gbx", "*.gbs" } });
 						filter.Add(new FilePickerFileType("GBA ROM files") { Patterns = new List<string>() { "*.gba" } });
-						filter.Add(new FilePickerFileType("PC Engine ROM files") { Patterns = new List<string>() { "*.pce", "*.sgx", "*.cue", "*.hes" } });
+						filter.Add(new FilePickerFileType("PC Engine ROM files") { Patterns = new List<string>() { "*.pce", "*.sgx", "*.cue", "*.chd", "*.hes" } });
 						filter.Add(new FilePickerFileType("SMS / GG ROM files") { Patterns = new List<string>() { "*.sms", "*.gg" } });
 						filter.Add(new FilePickerFileType("SG-1000 ROM files") { Patterns = new List<string>() { "*.sg" } });
 						filter.Add(new FilePickerFileType("ColecoVision ROM files") { Patterns = new List<string>() { "*.col" } });
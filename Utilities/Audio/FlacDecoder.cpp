@@ -0,0 +1,408 @@
+#include "pch.h"
+#include "Utilities/Audio/FlacDecoder.h"
+
+enum class FlacChannelMode
+{
+	Independent,
+	LeftSide,
+	SideRight,
+	MidSide
+};
+
+uint32_t FlacDecoder::ReadBits(uint32_t count)
+{
+	uint32_t value = 0;
+	while(count > 0) {
+		uint32_t byteIndex = _bitPos >> 3;
+		if(byteIndex >= _size) {
+			_error = true;
+			return 0;
+		}
+
+		//Read as many bits as possible from the current byte
+		uint32_t available = 8 - (_bitPos & 0x07);
+		uint32_t bitCount = std::min(available, count);
+		uint32_t bits = (_data[byteIndex] >> (available - bitCount)) & ((1 << bitCount) - 1);
+		value = (value << bitCount) | bits;
+		_bitPos += bitCount;
+		count -= bitCount;
+	}
+	return value;
+}
+
+int32_t FlacDecoder::ReadSignedBits(uint32_t count)
+{
+	if(count == 0) {
+		return 0;
+	}
+	uint32_t value = ReadBits(count);
+	uint32_t shift = 32 - count;
+	return (int32_t)(value << shift) >> shift;
+}
+
+uint32_t FlacDecoder::ReadUnary()
+{
+	uint32_t count = 0;
+	while(true) {
+		uint32_t byteIndex = _bitPos >> 3;
+		if(byteIndex >= _size) {
+			_error = true;
+			return 0;
+		}
+
+		if((_bitPos & 0x07) == 0 && _data[byteIndex] == 0) {
+			//Skip entire zero bytes at once
+			count += 8;
+			_bitPos += 8;
+			continue;
+		}
+
+		bool bit = (_data[byteIndex] >> (7 - (_bitPos & 0x07))) & 0x01;
+		_bitPos++;
+		if(bit) {
+			return count;
+		}
+		count++;
+	}
+}
+
+int32_t FlacDecoder::ReadRice(uint32_t param)
+{
+	uint32_t value = (ReadUnary() << param) | ReadBits(param);
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 0x01);
+}
+
+void FlacDecoder::AlignToByte()
+{
+	_bitPos = (_bitPos + 7) & ~0x07;
+}
+
+bool FlacDecoder::Decode(const uint8_t* src, uint32_t srcSize, uint32_t channelCount, uint32_t bitsPerSample, uint32_t sampleCount, bool bigEndian, uint8_t* out, uint32_t& bytesRead)
+{
+	_data = src;
+	_size = srcSize;
+	_bitPos = 0;
+	_error = false;
+	_defaultBitsPerSample = bitsPerSample;
+	bytesRead = 0;
+
+	if(channelCount == 0 || channelCount > MaxChannels) {
+		return false;
+	}
+
+	uint32_t decodedCount = 0;
+	while(decodedCount < sampleCount) {
+		uint32_t blockSize = 0;
+		if(!DecodeFrame(channelCount, blockSize)) {
+			return false;
+		}
+
+		uint32_t count = std::min(blockSize, sampleCount - decodedCount);
+		uint8_t* dst = out + decodedCount * channelCount * 2;
+		for(uint32_t i = 0; i < count; i++) {
+			for(uint32_t ch = 0; ch < channelCount; ch++) {
+				uint16_t sample = (uint16_t)_samples[ch][i];
+				if(bigEndian) {
+					dst[0] = sample >> 8;
+					dst[1] = (uint8_t)sample;
+				} else {
+					dst[0] = (uint8_t)sample;
+					dst[1] = sample >> 8;
+				}
+				dst += 2;
+			}
+		}
+		decodedCount += count;
+	}
+
+	bytesRead = _bitPos >> 3;
+	return true;
+}
+
+bool FlacDecoder::DecodeFrame(uint32_t channelCount, uint32_t& blockSize)
+{
+	//Frame header
+	if(ReadBits(14) != 0x3FFE || ReadBits(1) != 0) {
+		return false;
+	}
+	ReadBits(1); //Blocking strategy (fixed/variable) - not needed
+
+	uint32_t blockSizeCode = ReadBits(4);
+	uint32_t sampleRateCode = ReadBits(4);
+	uint32_t channelCode = ReadBits(4);
+	uint32_t sampleSizeCode = ReadBits(3);
+	ReadBits(1);
+
+	//Frame/sample number, coded like UTF-8 (1 to 7 bytes)
+	uint32_t firstByte = ReadBits(8);
+	uint32_t extraBytes = 0;
+	while(extraBytes < 8 && (firstByte & (0x80 >> extraBytes))) {
+		extraBytes++;
+	}
+	if(extraBytes == 1 || extraBytes == 8) {
+		return false;
+	}
+	for(uint32_t i = 1; i < extraBytes; i++) {
+		if(ReadBits(8) >> 6 != 0x02) {
+			return false;
+		}
+	}
+
+	switch(blockSizeCode) {
+		case 0: return false;
+		case 1: blockSize = 192; break;
+		case 6: blockSize = ReadBits(8) + 1; break;
+		case 7: blockSize = ReadBits(16) + 1; break;
+		default:
+			if(blockSizeCode <= 5) {
+				blockSize = 576 << (blockSizeCode - 2);
+			} else {
+				blockSize = 256 << (blockSizeCode - 8);
+			}
+			break;
+	}
+
+	switch(sampleRateCode) {
+		case 12: ReadBits(8); break;
+		case 13: case 14: ReadBits(16); break;
+		case 15: return false;
+	}
+
+	uint32_t bitsPerSample;
+	switch(sampleSizeCode) {
+		case 0: bitsPerSample = _defaultBitsPerSample; break;
+		case 1: bitsPerSample = 8; break;
+		case 2: bitsPerSample = 12; break;
+		case 4: bitsPerSample = 16; break;
+		case 5: bitsPerSample = 20; break;
+		case 6: bitsPerSample = 24; break;
+		default: return false;
+	}
+
+	ReadBits(8); //CRC-8
+
+	FlacChannelMode mode;
+	if(channelCode < 8) {
+		if(channelCode + 1 != channelCount) {
+			return false;
+		}
+		mode = FlacChannelMode::Independent;
+	} else if(channelCode <= 10 && channelCount == 2) {
+		mode = (FlacChannelMode)(channelCode - 7);
+	} else {
+		return false;
+	}
+
+	if(_error || blockSize > MaxBlockSize) {
+		return false;
+	}
+
+	for(uint32_t ch = 0; ch < channelCount; ch++) {
+		//The side channel has an extra bit
+		bool isSide = (mode == FlacChannelMode::SideRight && ch == 0) || ((mode == FlacChannelMode::LeftSide || mode == FlacChannelMode::MidSide) && ch == 1);
+		_samples[ch].resize(blockSize);
+		if(!DecodeSubframe(_samples[ch].data(), blockSize, bitsPerSample + (isSide ? 1 : 0))) {
+			return false;
+		}
+	}
+
+	AlignToByte();
+	ReadBits(16); //CRC-16
+
+	if(_error) {
+		return false;
+	}
+
+	int32_t* left = _samples[0].data();
+	int32_t* right = channelCount > 1 ? _samples[1].data() : nullptr;
+	switch(mode) {
+		case FlacChannelMode::Independent:
+			break;
+
+		case FlacChannelMode::LeftSide:
+			for(uint32_t i = 0; i < blockSize; i++) {
+				right[i] = left[i] - right[i];
+			}
+			break;
+
+		case FlacChannelMode::SideRight:
+			for(uint32_t i = 0; i < blockSize; i++) {
+				left[i] += right[i];
+			}
+			break;
+
+		case FlacChannelMode::MidSide:
+			for(uint32_t i = 0; i < blockSize; i++) {
+				int32_t side = right[i];
+				int32_t mid = (int32_t)((uint32_t)left[i] << 1) | (side & 0x01);
+				left[i] = (mid + side) >> 1;
+				right[i] = (mid - side) >> 1;
+			}
+			break;
+	}
+
+	return true;
+}
+
+bool FlacDecoder::DecodeSubframe(int32_t* out, uint32_t blockSize, uint32_t bitsPerSample)
+{
+	if(ReadBits(1) != 0) {
+		return false;
+	}
+
+	uint32_t type = ReadBits(6);
+
+	uint32_t wastedBits = 0;
+	if(ReadBits(1)) {
+		wastedBits = ReadUnary() + 1;
+		if(wastedBits >= bitsPerSample) {
+			return false;
+		}
+		bitsPerSample -= wastedBits;
+	}
+
+	if(type == 0) {
+		//Constant
+		int32_t value = ReadSignedBits(bitsPerSample);
+		for(uint32_t i = 0; i < blockSize; i++) {
+			out[i] = value;
+		}
+	} else if(type == 1) {
+		//Verbatim
+		for(uint32_t i = 0; i < blockSize; i++) {
+			out[i] = ReadSignedBits(bitsPerSample);
+		}
+	} else if(type >= 8 && type <= 12) {
+		//Fixed predictor
+		uint32_t order = type - 8;
+		if(order > blockSize) {
+			return false;
+		}
+		for(uint32_t i = 0; i < order; i++) {
+			out[i] = ReadSignedBits(bitsPerSample);
+		}
+		if(!DecodeResidual(out, blockSize, order)) {
+			return false;
+		}
+		RestoreFixed(out, blockSize, order);
+	} else if(type >= 32) {
+		//Linear predictor
+		uint32_t order = (type & 0x1F) + 1;
+		if(order > blockSize) {
+			return false;
+		}
+		for(uint32_t i = 0; i < order; i++) {
+			out[i] = ReadSignedBits(bitsPerSample);
+		}
+
+		uint32_t precision = ReadBits(4) + 1;
+		if(precision == 16) {
+			return false;
+		}
+
+		int32_t shift = ReadSignedBits(5);
+		if(shift < 0) {
+			return false;
+		}
+
+		int32_t coefs[32];
+		for(uint32_t i = 0; i < order; i++) {
+			coefs[i] = ReadSignedBits(precision);
+		}
+
+		if(!DecodeResidual(out, blockSize, order)) {
+			return false;
+		}
+		RestoreLpc(out, blockSize, coefs, order, shift);
+	} else {
+		return false;
+	}
+
+	if(wastedBits) {
+		for(uint32_t i = 0; i < blockSize; i++) {
+			out[i] = (int32_t)((uint32_t)out[i] << wastedBits);
+		}
+	}
+
+	return !_error;
+}
+
+bool FlacDecoder::DecodeResidual(int32_t* out, uint32_t blockSize, uint32_t predictorOrder)
+{
+	uint32_t method = ReadBits(2);
+	if(method > 1) {
+		return false;
+	}
+
+	uint32_t paramBits = method == 0 ? 4 : 5;
+	uint32_t escapeCode = method == 0 ? 0x0F : 0x1F;
+	uint32_t partitionOrder = ReadBits(4);
+	uint32_t partitionCount = 1 << partitionOrder;
+	uint32_t partitionSize = blockSize >> partitionOrder;
+	if((partitionSize << partitionOrder) != blockSize || partitionSize < predictorOrder) {
+		return false;
+	}
+
+	uint32_t pos = predictorOrder;
+	for(uint32_t partition = 0; partition < partitionCount; partition++) {
+		uint32_t count = partition == 0 ? partitionSize - predictorOrder : partitionSize;
+		uint32_t param = ReadBits(paramBits);
+		if(param == escapeCode) {
+			//Unencoded residuals
+			uint32_t bits = ReadBits(5);
+			for(uint32_t i = 0; i < count; i++) {
+				out[pos++] = ReadSignedBits(bits);
+			}
+		} else {
+			for(uint32_t i = 0; i < count; i++) {
+				out[pos++] = ReadRice(param);
+			}
+		}
+
+		if(_error) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FlacDecoder::RestoreFixed(int32_t* s, uint32_t blockSize, uint32_t order)
+{
+	switch(order) {
+		case 1:
+			for(uint32_t i = 1; i < blockSize; i++) {
+				s[i] += s[i - 1];
+			}
+			break;
+
+		case 2:
+			for(uint32_t i = 2; i < blockSize; i++) {
+				s[i] += 2 * s[i - 1] - s[i - 2];
+			}
+			break;
+
+		case 3:
+			for(uint32_t i = 3; i < blockSize; i++) {
+				s[i] += 3 * (s[i - 1] - s[i - 2]) + s[i - 3];
+			}
+			break;
+
+		case 4:
+			for(uint32_t i = 4; i < blockSize; i++) {
+				s[i] += 4 * (s[i - 1] + s[i - 3]) - 6 * s[i - 2] - s[i - 4];
+			}
+			break;
+	}
+}
+
+void FlacDecoder::RestoreLpc(int32_t* s, uint32_t blockSize, int32_t* coefs, uint32_t order, int32_t shift)
+{
+	for(uint32_t i = order; i < blockSize; i++) {
+		int64_t sum = 0;
+		for(uint32_t j = 0; j < order; j++) {
+			sum += (int64_t)coefs[j] * s[i - 1 - j];
+		}
+		s[i] += (int32_t)(sum >> shift);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "pch.h"
+
+//Decodes raw FLAC frames (without the "fLaC" signature and metadata blocks) - this is how audio is stored in CHD files
+//Supports the subset of the format used for CD audio: up to 2 channels, up to 24 bits per sample
+class FlacDecoder
+{
+private:
+	static constexpr uint32_t MaxChannels = 2;
+	static constexpr uint32_t MaxBlockSize = 65535;
+
+	const uint8_t* _data = nullptr;
+	uint32_t _size = 0;
+	uint32_t _bitPos = 0;
+	bool _error = false;
+
+	uint32_t _defaultBitsPerSample = 16;
+	vector<int32_t> _samples[MaxChannels];
+
+	uint32_t ReadBits(uint32_t count);
+	int32_t ReadSignedBits(uint32_t count);
+	uint32_t ReadUnary();
+	int32_t ReadRice(uint32_t param);
+	void AlignToByte();
+
+	bool DecodeFrame(uint32_t channelCount, uint32_t& blockSize);
+	bool DecodeSubframe(int32_t* out, uint32_t blockSize, uint32_t bitsPerSample);
+	bool DecodeResidual(int32_t* out, uint32_t blockSize, uint32_t predictorOrder);
+	void RestoreFixed(int32_t* samples, uint32_t blockSize, uint32_t order);
+	void RestoreLpc(int32_t* samples, uint32_t blockSize, int32_t* coefs, uint32_t order, int32_t shift);
+
+public:
+	//Decodes frames until sampleCount samples (per channel) have been decoded and writes them interleaved in out
+	//Samples are written as 16-bit values in big or little endian order, to match the byte order of the data they replace
+	//bytesRead is set to the number of bytes used by the decoded frames
+	bool Decode(const uint8_t* src, uint32_t srcSize, uint32_t channelCount, uint32_t bitsPerSample, uint32_t sampleCount, bool bigEndian, uint8_t* out, uint32_t& bytesRead);
+};
@@ -1,31 +1,75 @@
 #pragma once
 #include "pch.h"
 #include "miniz.h"
+#include "Lz4Codec.h"
+#include "Serializer.h"
 
 class CompressionHelper
 {
 public:
-	static void Compress(string data, int compressionLevel, vector<uint8_t>& output)
+	//Compresses data with the given codec (compressionLevel is only used by deflate)
+	//Output format: codec (1 byte), original size, compressed size, compressed data
+	static void Compress(string data, int compressionLevel, vector<uint8_t>& output, CompressionCodec codec = CompressionCodec::Deflate)
 	{
-		unsigned long compressedSize = compressBound((unsigned long)data.size());
-		uint8_t* compressedData = new uint8_t[compressedSize];
-		compress2(compressedData, &compressedSize, (unsigned char*)data.c_str(), (unsigned long)data.size(), compressionLevel);
-
-		uint32_t size = (uint32_t)compressedSize;
-		uint32_t originalSize = (uint32_t)data.size();
-		output.insert(output.end(), (char*)&originalSize, (char*)&originalSize + sizeof(uint32_t));
-		output.insert(output.end(), (char*)&size, (char*)&size + sizeof(uint32_t));
-		output.insert(output.end(), (char*)compressedData, (char*)compressedData + compressedSize);
-		delete[] compressedData;
+		Compress((uint8_t*)data.c_str(), (uint32_t)data.size(), compressionLevel, output, codec);
+	}
+
+	static void Compress(const uint8_t* data, uint32_t dataSize, int compressionLevel, vector<uint8_t>& output, CompressionCodec codec = CompressionCodec::Deflate)
+	{
+		size_t headerPos = output.size();
+		output.resize(headerPos + 1 + sizeof(uint32_t) * 2);
+		size_t dataPos = output.size();
+
+		uint32_t size = CompressRaw(data, dataSize, compressionLevel, output, codec);
+
+		output[headerPos] = (uint8_t)codec;
+		memcpy(output.data() + headerPos + 1, &dataSize, sizeof(uint32_t));
+		memcpy(output.data() + headerPos + 1 + sizeof(uint32_t), &size, sizeof(uint32_t));
+		output.resize(dataPos + size);
+	}
+
+	//Appends the compressed data (with no header) to the output, and returns its size
+	static uint32_t CompressRaw(const uint8_t* data, uint32_t dataSize, int compressionLevel, vector<uint8_t>& output, CompressionCodec codec)
+	{
+		size_t pos = output.size();
+		if(codec == CompressionCodec::Lz4) {
+			output.resize(pos + Lz4Codec::GetMaxCompressedSize(dataSize));
+			uint32_t size = Lz4Codec::Compress(data, dataSize, output.data() + pos, (uint32_t)(output.size() - pos));
+			output.resize(pos + size);
+			return size;
+		} else {
+			unsigned long compressedSize = compressBound((unsigned long)dataSize);
+			output.resize(pos + compressedSize);
+			compress2(output.data() + pos, &compressedSize, data, (unsigned long)dataSize, compressionLevel);
+			output.resize(pos + compressedSize);
+			return (uint32_t)compressedSize;
+		}
+	}
+
+	static bool DecompressRaw(const uint8_t* input, uint32_t inputSize, uint8_t* output, uint32_t outputSize, CompressionCodec codec)
+	{
+		if(codec == CompressionCodec::Lz4) {
+			return Lz4Codec::Decompress(input, inputSize, output, outputSize);
+		} else if(codec == CompressionCodec::Deflate) {
+			unsigned long decompSize = outputSize;
+			return uncompress(output, &decompSize, input, inputSize) == MZ_OK;
+		}
+		return false;
 	}
 
 	static bool Decompress(vector<uint8_t>& input, vector<uint8_t>& output)
 	{
+		constexpr size_t headerSize = 1 + sizeof(uint32_t) * 2;
+		if(input.size() < headerSize) {
+			return false;
+		}
+
+		CompressionCodec codec = (CompressionCodec)input[0];
 		uint32_t decompressedSize;
 		uint32_t compressedSize;
 
-		memcpy(&decompressedSize, input.data(), sizeof(uint32_t));
-		memcpy(&compressedSize, input.data() + sizeof(uint32_t), sizeof(uint32_t));
+		memcpy(&decompressedSize, input.data() + 1, sizeof(uint32_t));
+		memcpy(&compressedSize, input.data() + 1 + sizeof(uint32_t), sizeof(uint32_t));
 
 		if(decompressedSize >= 1024 * 1024 * 10 || compressedSize >= 1024 * 1024 * 10) {
 			//Limit to 10mb the data's size
@@ -33,12 +77,6 @@ public:
 		}
 
 		output.resize(decompressedSize, 0);
-
-		unsigned long decompSize = decompressedSize;
-		if(uncompress(output.data(), &decompSize, input.data() + sizeof(uint32_t)*2, (unsigned long)input.size() - sizeof(uint32_t) * 2) != MZ_OK) {
-			return false;
-		}
-
-		return true;
+		return DecompressRaw(input.data() + headerSize, (uint32_t)(input.size() - headerSize), output.data(), decompressedSize, codec);
 	}
-};
\ No newline at end of file
+};
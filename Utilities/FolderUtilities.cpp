@@ -97,6 +97,13 @@ string FolderUtilities::GetHdPackFolder()
 	return folder;
 }
 
+string FolderUtilities::GetHdPackCacheFolder()
+{
+	string folder = CombinePath(GetHomeFolder(), "HdPackCache");
+	CreateFolder(folder);
+	return folder;
+}
+
 string FolderUtilities::GetDebuggerFolder()
 {
 	string folder = CombinePath(GetHomeFolder(), "Debugger");
@@ -27,6 +27,7 @@ public:
 	static string GetSaveStateFolder();
 	static string GetScreenshotFolder();
 	static string GetHdPackFolder();
+	static string GetHdPackCacheFolder();
 	static string GetDebuggerFolder();
 	static string GetRecentGamesFolder();
 
@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "Lz4Codec.h"
+
+static constexpr int HashBits = 14;
+static constexpr uint32_t MinMatch = 4;
+static constexpr uint32_t LastLiterals = 5; //The last 5 bytes are always literals
+static constexpr uint32_t MatchFindLimit = 12; //The last match must start at least 12 bytes before the end of the block
+static constexpr uint32_t MaxOffset = 0xFFFF;
+
+static uint32_t Read32(const uint8_t* src)
+{
+	uint32_t value;
+	memcpy(&value, src, sizeof(uint32_t));
+	return value;
+}
+
+static uint8_t* WriteLength(uint8_t* out, uint32_t length)
+{
+	while(length >= 255) {
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = (uint8_t)length;
+	return out;
+}
+
+uint32_t Lz4Codec::GetMaxCompressedSize(uint32_t srcSize)
+{
+	return srcSize + (srcSize / 255) + 16;
+}
+
+uint32_t Lz4Codec::Compress(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstCapacity)
+{
+	//Hash table of the last position (+1) where each 4-byte sequence was seen
+	uint32_t table[1 << HashBits] = {};
+
+	uint8_t* out = dst;
+	uint8_t* outEnd = dst + dstCapacity;
+	uint32_t anchor = 0;
+
+	if(srcSize > MatchFindLimit) {
+		uint32_t matchLimit = srcSize - LastLiterals;
+		uint32_t inputLimit = srcSize - MatchFindLimit;
+		uint32_t pos = 0;
+		while(pos < inputLimit) {
+			uint32_t seq = Read32(src + pos);
+			uint32_t hash = (seq * 2654435761u) >> (32 - HashBits);
+			uint32_t ref = table[hash];
+			table[hash] = pos + 1;
+
+			if(ref == 0 || pos - (ref - 1) > MaxOffset || Read32(src + ref - 1) != seq) {
+				//Skip faster through data that doesn't compress
+				pos += 1 + ((pos - anchor) >> 6);
+				continue;
+			}
+			ref--;
+
+			uint32_t length = MinMatch;
+			while(pos + length < matchLimit && src[ref + length] == src[pos + length]) {
+				length++;
+			}
+			while(pos > anchor && ref > 0 && src[pos - 1] == src[ref - 1]) {
+				pos--;
+				ref--;
+				length++;
+			}
+
+			uint32_t literalCount = pos - anchor;
+			if(out + 1 + literalCount + (literalCount / 255) + 1 + 2 + (length / 255) + 1 > outEnd) {
+				return 0;
+			}
+
+			uint8_t* token = out++;
+			if(literalCount >= 15) {
+				*token = 15 << 4;
+				out = WriteLength(out, literalCount - 15);
+			} else {
+				*token = (uint8_t)(literalCount << 4);
+			}
+			memcpy(out, src + anchor, literalCount);
+			out += literalCount;
+
+			uint32_t offset = pos - ref;
+			*out++ = (uint8_t)offset;
+			*out++ = (uint8_t)(offset >> 8);
+
+			uint32_t matchLength = length - MinMatch;
+			if(matchLength >= 15) {
+				*token |= 15;
+				out = WriteLength(out, matchLength - 15);
+			} else {
+				*token |= (uint8_t)matchLength;
+			}
+
+			pos += length;
+			anchor = pos;
+		}
+	}
+
+	//Last sequence: literals only
+	uint32_t literalCount = srcSize - anchor;
+	if(out + 1 + literalCount + (literalCount / 255) + 1 > outEnd) {
+		return 0;
+	}
+
+	uint8_t* token = out++;
+	if(literalCount >= 15) {
+		*token = 15 << 4;
+		out = WriteLength(out, literalCount - 15);
+	} else {
+		*token = (uint8_t)(literalCount << 4);
+	}
+	memcpy(out, src + anchor, literalCount);
+	out += literalCount;
+
+	return (uint32_t)(out - dst);
+}
+
+bool Lz4Codec::Decompress(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize)
+{
+	uint32_t in = 0;
+	uint32_t out = 0;
+
+	auto readLength = [&](uint32_t& length) {
+		uint8_t value;
+		do {
+			if(in >= srcSize) {
+				return false;
+			}
+			value = src[in++];
+			length += value;
+		} while(value == 255);
+		return true;
+	};
+
+	while(in < srcSize) {
+		uint8_t token = src[in++];
+
+		uint32_t literalCount = token >> 4;
+		if(literalCount == 15 && !readLength(literalCount)) {
+			return false;
+		}
+		if(literalCount > srcSize - in || literalCount > dstSize - out) {
+			return false;
+		}
+		memcpy(dst + out, src + in, literalCount);
+		in += literalCount;
+		out += literalCount;
+
+		if(in == srcSize) {
+			//Last sequence has no match
+			break;
+		}
+
+		if(in + 2 > srcSize) {
+			return false;
+		}
+		uint32_t offset = src[in] | (src[in + 1] << 8);
+		in += 2;
+		if(offset == 0 || offset > out) {
+			return false;
+		}
+
+		uint32_t length = token & 0x0F;
+		if(length == 15 && !readLength(length)) {
+			return false;
+		}
+		length += MinMatch;
+		if(length > dstSize - out) {
+			return false;
+		}
+
+		uint8_t* match = dst + out - offset;
+		if(offset >= length) {
+			memcpy(dst + out, match, length);
+		} else {
+			//Overlapping match (repeated pattern)
+			for(uint32_t i = 0; i < length; i++) {
+				dst[out + i] = match[i];
+			}
+		}
+		out += length;
+	}
+
+	return out == dstSize;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "pch.h"
+
+//Fast LZ77 compressor that produces data in the LZ4 block format (no frame header/checksums)
+//Much faster than deflate, at the cost of a lower compression ratio - used for in-memory states (rewind, netplay, etc.)
+class Lz4Codec
+{
+public:
+	static uint32_t GetMaxCompressedSize(uint32_t srcSize);
+
+	//Returns the compressed size, or 0 if the output buffer is too small
+	static uint32_t Compress(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstCapacity);
+
+	//Returns false if the data is invalid or if its decompressed size doesn't match dstSize
+	static bool Decompress(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize);
+};
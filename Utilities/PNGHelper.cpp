@@ -57,7 +57,7 @@ bool PNGHelper::WritePNG(string filename, uint32_t* buffer, uint32_t xSize, uint
 }
 
 template<typename T>
-bool PNGHelper::ReadPNG(vector<uint8_t> input, vector<T> &output, uint32_t &pngWidth, uint32_t &pngHeight)
+bool PNGHelper::ReadPNG(const vector<uint8_t>& input, vector<T> &output, uint32_t &pngWidth, uint32_t &pngHeight)
 {
 	unsigned long width = 0;
 	unsigned long height = 0;
@@ -150,5 +150,5 @@ int PNGHelper::DecodePNG(vector<T>& out_image, unsigned long& image_width, unsig
 template int PNGHelper::DecodePNG<uint8_t>(vector<uint8_t>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32);
 template int PNGHelper::DecodePNG<uint32_t>(vector<uint32_t>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32);
 
-template bool PNGHelper::ReadPNG<uint8_t>(vector<uint8_t> input, vector<uint8_t>& output, uint32_t& pngWidth, uint32_t& pngHeight);
-template bool PNGHelper::ReadPNG<uint32_t>(vector<uint8_t> input, vector<uint32_t>& output, uint32_t& pngWidth, uint32_t& pngHeight);
+template bool PNGHelper::ReadPNG<uint8_t>(const vector<uint8_t>& input, vector<uint8_t>& output, uint32_t& pngWidth, uint32_t& pngHeight);
+template bool PNGHelper::ReadPNG<uint32_t>(const vector<uint8_t>& input, vector<uint32_t>& output, uint32_t& pngWidth, uint32_t& pngHeight);
@@ -3,6 +3,21 @@
 #include "Serializer.h"
 #include "ISerializable.h"
 #include "miniz.h"
+#include "CompressionHelper.h"
+#include "SimpleLock.h"
+
+//Schemas are shared by all serializers and never deleted, since states saved in the packed format refer to them by id
+static SimpleLock _schemaLock;
+static vector<unique_ptr<SerializeSchema>> _schemas;
+static unordered_map<uint64_t, vector<SerializeSchema*>> _schemasByHash;
+
+//Schemas of the last states saved on this thread - the next state usually has the exact same layout as one of them
+//(e.g run-ahead and rewind states are both saved on the emulation thread, with different layouts)
+static constexpr int RecentSchemaCount = 4;
+static thread_local const SerializeSchema* _recentSchemas[RecentSchemaCount] = {};
+
+//Number of packed states that had to be converted to the keyed format while being loaded on this thread (used by the benchmark)
+static thread_local uint32_t _keyedFallbackCount = 0;
 
 Serializer::Serializer(uint32_t version, bool forSave, SerializeFormat format)
 {
@@ -14,12 +29,300 @@ Serializer::Serializer(uint32_t version, bool forSave, SerializeFormat format)
 			case SerializeFormat::Binary: _data.reserve(0x50000); break;
 			case SerializeFormat::Map: _mapValues.reserve(500); break;
 			case SerializeFormat::Text: _values.reserve(500); break;
+			case SerializeFormat::Packed: _data.reserve(0x50000); _schema = _recentSchemas[0]; break;
 		}
 	}
 }
 
+Serializer::Serializer(uint32_t version, bool forSave, SerializeSnapshot& snapshot)
+{
+	_version = version;
+	_saving = forSave;
+	_format = SerializeFormat::Packed;
+	_snapshot = &snapshot;
+
+	_data.swap(snapshot.Data);
+	if(forSave) {
+		//Keep the buffer's capacity, the new state is usually the same size as the previous one
+		_data.clear();
+		_schema = snapshot.Schema ? snapshot.Schema : _recentSchemas[0];
+	} else {
+		_schema = snapshot.Schema;
+	}
+}
+
+Serializer::~Serializer()
+{
+	if(_snapshot) {
+		if(_saving) {
+			UpdateSchema();
+			_snapshot->Schema = _schema;
+		}
+		_snapshot->Data.swap(_data);
+	}
+}
+
+void Serializer::UpdateSchema()
+{
+	if(_schemaMismatch || !_schema || _schemaPos != _schema->Entries.size()) {
+		if(!_schemaMismatch && _schema) {
+			//Fewer values than in the previous schema
+			_newEntries.assign(_schema->Entries.begin(), _schema->Entries.begin() + _schemaPos);
+		}
+		_schema = RegisterSchema(_newEntries);
+		_schemaMismatch = false;
+		_schemaPos = (uint32_t)_schema->Entries.size();
+	}
+
+	int i = 0;
+	while(i < RecentSchemaCount - 1 && _recentSchemas[i] != _schema) {
+		i++;
+	}
+	for(; i > 0; i--) {
+		_recentSchemas[i] = _recentSchemas[i - 1];
+	}
+	_recentSchemas[0] = _schema;
+}
+
+const SerializeSchema* Serializer::RegisterSchema(vector<SerializeSchemaEntry>& entries)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for(SerializeSchemaEntry& entry : entries) {
+		uint64_t values[3] = { (uint64_t)(uintptr_t)entry.Name, ((uint64_t)(uint32_t)entry.Index << 32) | entry.Size, (uint64_t)entry.Type };
+		for(uint64_t value : values) {
+			hash = (hash ^ value) * 1099511628211ULL;
+		}
+	}
+
+	auto lock = _schemaLock.AcquireSafe();
+	vector<SerializeSchema*>& candidates = _schemasByHash[hash];
+	for(SerializeSchema* schema : candidates) {
+		if(schema->Entries == entries) {
+			return schema;
+		}
+	}
+
+	SerializeSchema* schema = new SerializeSchema();
+	schema->Id = (uint32_t)_schemas.size();
+	schema->Entries = entries;
+	_schemas.push_back(unique_ptr<SerializeSchema>(schema));
+	candidates.push_back(schema);
+	return schema;
+}
+
+const SerializeSchema* Serializer::GetSchema(uint32_t id)
+{
+	auto lock = _schemaLock.AcquireSafe();
+	return id < _schemas.size() ? _schemas[id].get() : nullptr;
+}
+
+void Serializer::RecordSchemaEntry(const char* name, int index, uint32_t size, SerializeSchemaEntryType type)
+{
+	SerializeSchemaEntry entry = { name, index, size, type };
+	if(!_schemaMismatch) {
+		if(_schema && _schemaPos < _schema->Entries.size() && _schema->Entries[_schemaPos] == entry) {
+			_schemaPos++;
+			return;
+		}
+
+		//The layout differs from the previous state's, check if it matches another recent schema
+		for(int i = 0; i < RecentSchemaCount; i++) {
+			const SerializeSchema* schema = _recentSchemas[i];
+			if(schema && schema != _schema && _schemaPos < schema->Entries.size() && schema->Entries[_schemaPos] == entry) {
+				if(_schemaPos == 0 || (_schema && std::equal(schema->Entries.begin(), schema->Entries.begin() + _schemaPos, _schema->Entries.begin()))) {
+					_schema = schema;
+					_schemaPos++;
+					return;
+				}
+			}
+		}
+
+		//Record a new schema
+		_schemaMismatch = true;
+		if(_schema) {
+			_newEntries.assign(_schema->Entries.begin(), _schema->Entries.begin() + _schemaPos);
+		}
+	}
+	_newEntries.push_back(entry);
+}
+
+uint8_t* Serializer::ReadPackedValue(const char* name, int index, uint32_t size, SerializeSchemaEntryType type, uint32_t& valueSize)
+{
+	if(_schemaPos < _schema->Entries.size()) {
+		const SerializeSchemaEntry& entry = _schema->Entries[_schemaPos];
+		if(entry.Name == name && entry.Index == index && entry.Type == type && entry.Size == size) {
+			uint32_t pos = _readPos;
+			valueSize = size;
+			if(type == SerializeSchemaEntryType::VariableValue) {
+				if(pos + 4 > _data.size()) {
+					SwitchToKeyedFormat();
+					return nullptr;
+				}
+				ReadValue(valueSize, _data.data() + pos);
+				pos += 4;
+			}
+
+			if((size_t)pos + valueSize <= _data.size()) {
+				_schemaPos++;
+				_readPos = pos + valueSize;
+				return _data.data() + pos;
+			}
+		}
+	}
+
+	//Values are not being loaded in the same order they were saved in (e.g a value loaded earlier changed which values
+	//are serialized), look up the remaining values by key instead
+	SwitchToKeyedFormat();
+	return nullptr;
+}
+
+bool Serializer::GetKeyedValues(vector<std::pair<string, SerializeValue>>& values)
+{
+	//Rebuilds each value's key from the schema
+	vector<string> prefixes;
+	string prefix;
+	uint32_t pos = 0;
+	for(const SerializeSchemaEntry& entry : _schema->Entries) {
+		switch(entry.Type) {
+			case SerializeSchemaEntryType::PushPrefix:
+			case SerializeSchemaEntryType::PopPrefix:
+				if(entry.Type == SerializeSchemaEntryType::PushPrefix) {
+					prefixes.push_back(NormalizeName(entry.Name, entry.Index));
+				} else if(!prefixes.empty()) {
+					prefixes.pop_back();
+				}
+
+				prefix.clear();
+				for(string& p : prefixes) {
+					if(p.size()) {
+						prefix += p + ".";
+					}
+				}
+				break;
+
+			case SerializeSchemaEntryType::Value:
+			case SerializeSchemaEntryType::VariableValue: {
+				uint32_t size = entry.Size;
+				if(entry.Type == SerializeSchemaEntryType::VariableValue) {
+					if(pos + 4 > _data.size()) {
+						return false;
+					}
+					ReadValue(size, _data.data() + pos);
+					pos += 4;
+				}
+
+				if((size_t)pos + size > _data.size()) {
+					return false;
+				}
+
+				values.emplace_back(prefix + NormalizeName(entry.Name, entry.Index), SerializeValue(_data.data() + pos, size));
+				pos += size;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+void Serializer::SwitchToKeyedFormat()
+{
+	if(_format != SerializeFormat::Packed || _saving) {
+		return;
+	}
+
+	_keyedFallbackCount++;
+
+	vector<std::pair<string, SerializeValue>> values;
+	if(!GetKeyedValues(values)) {
+		SetErrorFlag();
+	}
+
+	for(auto& value : values) {
+		_values.emplace(std::move(value.first), value.second);
+	}
+
+	_prefixes.clear();
+	for(auto& prefix : _packedPrefixes) {
+		_prefixes.push_back(NormalizeName(prefix.first, prefix.second));
+	}
+	UpdatePrefix();
+
+	_format = SerializeFormat::Binary;
+}
+
+uint32_t Serializer::GetKeyedFallbackCount()
+{
+	return _keyedFallbackCount;
+}
+
+bool Serializer::ContainsPackedKey(const char* name)
+{
+	//Looks for the value in the schema, within the prefixes that are currently pushed
+	string key = NormalizeName(name, -1);
+	if(key.empty()) {
+		return false;
+	}
+
+	size_t depth = 0;
+	size_t matchingDepth = 0;
+	for(const SerializeSchemaEntry& entry : _schema->Entries) {
+		switch(entry.Type) {
+			case SerializeSchemaEntryType::PushPrefix:
+				if(matchingDepth == depth && depth < _packedPrefixes.size() && _packedPrefixes[depth].first == entry.Name && _packedPrefixes[depth].second == entry.Index) {
+					matchingDepth++;
+				}
+				depth++;
+				break;
+
+			case SerializeSchemaEntryType::PopPrefix:
+				if(depth > 0) {
+					depth--;
+					matchingDepth = std::min(matchingDepth, depth);
+				}
+				break;
+
+			case SerializeSchemaEntryType::Value:
+			case SerializeSchemaEntryType::VariableValue:
+				if(depth == _packedPrefixes.size() && matchingDepth == depth && entry.Index == -1) {
+					//Names are normally the same string literal, only build the key when they aren't
+					if(entry.Name == name || (entry.Name[0] && ::tolower(entry.Name[strlen(entry.Name) - 1]) == ::tolower(key.back()) && NormalizeName(entry.Name, -1) == key)) {
+						return true;
+					}
+				}
+				break;
+		}
+	}
+	return false;
+}
+
+bool Serializer::ConvertToBinaryFormat(SerializeSnapshot& snapshot, vector<uint8_t>& data)
+{
+	//The snapshot's buffer is given back to it when the serializer is destroyed
+	Serializer s(0, false, snapshot);
+
+	vector<std::pair<string, SerializeValue>> values;
+	if(!s._schema || !s.GetKeyedValues(values)) {
+		return false;
+	}
+
+	//Uncompressed binary state: key, value size and value for each value
+	Serializer out(0, true);
+	out._data.push_back(0);
+	for(auto& value : values) {
+		out._data.insert(out._data.end(), value.first.begin(), value.first.end());
+		out._data.push_back(0);
+		out.WriteValue(value.second.Size);
+		out.WriteData(value.second.DataPtr, value.second.Size);
+	}
+
+	data.swap(out._data);
+	return true;
+}
+
 void Serializer::AddKeyPrefix(string prefix)
 {
+	SwitchToKeyedFormat();
+
 	vector<string> keys;
 	for(auto& kvp : _values) {
 		keys.push_back(kvp.first);
@@ -33,6 +336,8 @@ void Serializer::AddKeyPrefix(string prefix)
 
 void Serializer::RemoveKeyPrefix(string prefix)
 {
+	SwitchToKeyedFormat();
+
 	vector<string> keys;
 	vector<string> keysToRemove;
 
@@ -56,6 +361,8 @@ void Serializer::RemoveKeyPrefix(string prefix)
 
 void Serializer::RemoveKeys(vector<string>& keysToRemove)
 {
+	SwitchToKeyedFormat();
+
 	for(string& key : keysToRemove) {
 		_values.erase(key);
 	}
@@ -73,9 +380,37 @@ bool Serializer::LoadFrom(istream &file)
 
 	char value = 0;
 	file.get(value);
+
+	if(value == Serializer::PackedStateMarker) {
+		//Schema ids are only valid within the process that created them, packed states can only be loaded from a SerializeSnapshot
+		return false;
+	}
+
 	bool isCompressed = value == 1;
 
-	if(isCompressed) {
+	if(value == Serializer::CodecStateMarker) {
+		char codec = 0;
+		file.get(codec);
+
+		uint32_t decompressedSize;
+		file.read((char*)&decompressedSize, sizeof(decompressedSize));
+
+		uint32_t compressedSize;
+		file.read((char*)&compressedSize, sizeof(compressedSize));
+
+		if(decompressedSize >= 1024 * 1024 * 10 || compressedSize >= 1024 * 1024 * 10) {
+			//Limit to 10mb the data's size
+			return false;
+		}
+
+		vector<uint8_t> compressedData(compressedSize, 0);
+		file.read((char*)compressedData.data(), compressedSize);
+
+		_data = vector<uint8_t>(decompressedSize, 0);
+		if(!CompressionHelper::DecompressRaw(compressedData.data(), compressedSize, _data.data(), decompressedSize, (CompressionCodec)codec)) {
+			return false;
+		}
+	} else if(isCompressed) {
 		uint32_t decompressedSize;
 		file.read((char*)&decompressedSize, sizeof(decompressedSize));
 
@@ -204,8 +539,37 @@ bool Serializer::LoadFromTextFormat(istream& file)
 	return true;
 }
 
+void Serializer::SaveTo(ostream& file, int compressionLevel, CompressionCodec codec)
+{
+	if(_format != SerializeFormat::Binary || compressionLevel <= 0 || codec == CompressionCodec::Deflate) {
+		SaveTo(file, compressionLevel);
+		return;
+	}
+
+	vector<uint8_t> compressedData;
+	uint32_t size = CompressionHelper::CompressRaw(_data.data(), (uint32_t)_data.size(), compressionLevel, compressedData, codec);
+	uint32_t originalSize = (uint32_t)_data.size();
+
+	file.put((char)Serializer::CodecStateMarker);
+	file.put((char)codec);
+	file.write((char*)&originalSize, sizeof(uint32_t));
+	file.write((char*)&size, sizeof(uint32_t));
+	file.write((char*)compressedData.data(), size);
+}
+
 void Serializer::SaveTo(ostream& file, int compressionLevel)
 {
+	if(_format == SerializeFormat::Packed) {
+		//Schema ids are only valid within the current process, streams always get the (uncompressed) binary format
+		UpdateSchema();
+		SerializeSnapshot snapshot = { _schema, std::move(_data) };
+		vector<uint8_t> data;
+		if(ConvertToBinaryFormat(snapshot, data)) {
+			file.write((char*)data.data(), data.size());
+		}
+		return;
+	}
+
 	if(_format == SerializeFormat::Text) {
 		file.write((char*)_data.data(), _data.size());
 	} else {
@@ -269,12 +633,34 @@ string Serializer::NormalizeName(const char* name, int index)
 
 void Serializer::PushNamePrefix(const char* name, int index)
 {
+	if(_format == SerializeFormat::Packed) {
+		uint32_t size;
+		if(_saving) {
+			RecordSchemaEntry(name, index, 0, SerializeSchemaEntryType::PushPrefix);
+			return;
+		} else if(ReadPackedValue(name, index, 0, SerializeSchemaEntryType::PushPrefix, size)) {
+			_packedPrefixes.push_back({ name, index });
+			return;
+		}
+	}
+
 	_prefixes.push_back(NormalizeName(name, index));
 	UpdatePrefix();
 }
 
 void Serializer::PopNamePrefix()
 {
+	if(_format == SerializeFormat::Packed) {
+		uint32_t size;
+		if(_saving) {
+			RecordSchemaEntry(nullptr, -1, 0, SerializeSchemaEntryType::PopPrefix);
+			return;
+		} else if(ReadPackedValue(nullptr, -1, 0, SerializeSchemaEntryType::PopPrefix, size)) {
+			_packedPrefixes.pop_back();
+			return;
+		}
+	}
+
 	_prefixes.pop_back();
 	UpdatePrefix();
 }
@@ -62,11 +62,56 @@ struct SerializeValue
 	}
 };
 
+enum class CompressionCodec : uint8_t
+{
+	Deflate = 0,
+	Lz4 = 1 //Faster, but with a lower compression ratio
+};
+
 enum class SerializeFormat
 {
 	Binary,
 	Text,
-	Map
+	Map,
+
+	//Values are packed one after the other without any key, the keys are only recorded once in a schema that's shared between states.
+	//Only valid within the current process (used for run-ahead, rewind, etc.) - states saved to files use the Binary format.
+	Packed
+};
+
+enum class SerializeSchemaEntryType : uint8_t
+{
+	Value,
+	VariableValue, //Vectors and strings, the value is prefixed by its size
+	PushPrefix,
+	PopPrefix
+};
+
+struct SerializeSchemaEntry
+{
+	//Pointer to the name's string literal - comparing it is much cheaper than building the key
+	const char* Name;
+	int32_t Index;
+	uint32_t Size;
+	SerializeSchemaEntryType Type;
+
+	bool operator==(const SerializeSchemaEntry& other) const
+	{
+		return Name == other.Name && Index == other.Index && Size == other.Size && Type == other.Type;
+	}
+};
+
+struct SerializeSchema
+{
+	uint32_t Id;
+	vector<SerializeSchemaEntry> Entries;
+};
+
+//Raw in-memory state (packed format, without any header) - reusing the same snapshot for each state avoids allocating a new buffer every time
+struct SerializeSnapshot
+{
+	const SerializeSchema* Schema = nullptr;
+	vector<uint8_t> Data;
 };
 
 class Serializer
@@ -87,8 +132,59 @@ private:
 	SerializeFormat _format = SerializeFormat::Binary;
 	bool _hasError = false;
 
+	//Packed format: schema used to save/load the state, and the current position within it
+	const SerializeSchema* _schema = nullptr;
+	uint32_t _schemaPos = 0;
+	uint32_t _readPos = 0;
+	bool _schemaMismatch = false;
+	vector<SerializeSchemaEntry> _newEntries;
+	vector<std::pair<const char*, int>> _packedPrefixes;
+	SerializeSnapshot* _snapshot = nullptr;
+
+	static constexpr uint8_t PackedStateMarker = 2;
+	static constexpr uint8_t CodecStateMarker = 3; //Compressed with the codec given in the next byte (older states use 1 for deflate)
+
 private:
 	bool LoadFromTextFormat(istream& file);
+	bool GetKeyedValues(vector<std::pair<string, SerializeValue>>& values);
+	void SwitchToKeyedFormat();
+	bool ContainsPackedKey(const char* name);
+	void RecordSchemaEntry(const char* name, int index, uint32_t size, SerializeSchemaEntryType type);
+	uint8_t* ReadPackedValue(const char* name, int index, uint32_t size, SerializeSchemaEntryType type, uint32_t& valueSize);
+
+	void UpdateSchema();
+
+	static const SerializeSchema* RegisterSchema(vector<SerializeSchemaEntry>& entries);
+	static const SerializeSchema* GetSchema(uint32_t id);
+
+	void WriteData(const void* src, uint32_t size)
+	{
+		size_t pos = _data.size();
+		_data.resize(pos + size);
+		if(size) {
+			memcpy(_data.data() + pos, src, size);
+		}
+	}
+
+	template<typename T>
+	bool StreamPacked(T& value, const char* name, int index)
+	{
+		if(_saving) {
+			RecordSchemaEntry(name, index, sizeof(T), SerializeSchemaEntryType::Value);
+			WriteData(&value, sizeof(T));
+			return true;
+		}
+
+		uint32_t size;
+		uint8_t* src = ReadPackedValue(name, index, sizeof(T), SerializeSchemaEntryType::Value, size);
+		if(src) {
+			memcpy(&value, src, sizeof(T));
+			return true;
+		}
+
+		//The state's layout doesn't match the order in which the values are being loaded, the state was converted to the keyed format
+		return false;
+	}
 	string NormalizeName(const char* name, int index);
 	void UpdatePrefix();
 
@@ -216,6 +312,10 @@ private:
 public:
 	Serializer(uint32_t version, bool forSave, SerializeFormat format = SerializeFormat::Binary);
 
+	//Saves to or loads from a snapshot, using the packed format - the snapshot's buffer is used directly (no copies) and is given back to the snapshot when the serializer is destroyed
+	Serializer(uint32_t version, bool forSave, SerializeSnapshot& snapshot);
+	~Serializer();
+
 	uint32_t GetVersion() { return _version; }
 	bool IsSaving() { return _saving; }
 	
@@ -225,7 +325,7 @@ public:
 	void SetErrorFlag() { _hasError = true; }
 	bool HasError() { return _hasError; }
 
-	bool IsValid() { return _values.size() > 0; }
+	bool IsValid() { return _values.size() > 0 || (_format == SerializeFormat::Packed && _schema); }
 	void AddKeyPrefix(string prefix);
 	void RemoveKeyPrefix(string prefix);
 	void RemoveKeys(vector<string>& keys);
@@ -246,6 +346,10 @@ public:
 		if constexpr(std::is_base_of<ISerializable, T>::value) {
 			Stream((ISerializable&)value, name, index);
 		} else {
+			if(_format == SerializeFormat::Packed && StreamPacked(value, name, index)) {
+				return;
+			}
+
 			string key = GetKey(name, index);
 
 			CheckDuplicateKey(key);
@@ -266,6 +370,7 @@ public:
 
 					case SerializeFormat::Text: WriteTextFormat(key, value); break;
 					case SerializeFormat::Map: WriteMapFormat(key, value); break;
+					case SerializeFormat::Packed: break; //Handled by StreamPacked
 				}
 			} else {
 				switch(_format) {
@@ -299,6 +404,10 @@ public:
 					case SerializeFormat::Map:
 						ReadMapFormat(key, value);
 						break;
+
+					case SerializeFormat::Packed:
+						//Handled by StreamPacked (states are converted to the binary format when they can't be loaded in order)
+						break;
 				}
 			}
 		}
@@ -349,6 +458,21 @@ public:
 			return;
 		}
 
+		if(_format == SerializeFormat::Packed) {
+			uint32_t size = elementCount * sizeof(T);
+			if(_saving) {
+				RecordSchemaEntry(name, -1, size, SerializeSchemaEntryType::Value);
+				WriteData(arrayValues, size);
+				return;
+			}
+
+			uint8_t* src = ReadPackedValue(name, -1, size, SerializeSchemaEntryType::Value, size);
+			if(src) {
+				memcpy(arrayValues, src, size);
+				return;
+			}
+		}
+
 		string key = GetKey(name, -1);
 
 		CheckDuplicateKey(key);
@@ -398,6 +522,24 @@ public:
 			return;
 		}
 
+		if(_format == SerializeFormat::Packed) {
+			if(_saving) {
+				uint32_t size = (uint32_t)(values.size() * sizeof(T));
+				RecordSchemaEntry(name, index, 0, SerializeSchemaEntryType::VariableValue);
+				WriteValue(size);
+				WriteData(values.data(), size);
+				return;
+			}
+
+			uint32_t size;
+			uint8_t* src = ReadPackedValue(name, index, 0, SerializeSchemaEntryType::VariableValue, size);
+			if(src) {
+				values.resize(size / sizeof(T));
+				memcpy(values.data(), src, values.size() * sizeof(T));
+				return;
+			}
+		}
+
 		string key = GetKey(name, index);
 
 		CheckDuplicateKey(key);
@@ -435,6 +577,11 @@ public:
 
 	bool ContainsKey(const char* name)
 	{
+		if(_format == SerializeFormat::Packed && !_saving) {
+			//Called on every load by some components - converting the state to the keyed format would make all packed loads slower
+			return ContainsPackedKey(name);
+		}
+
 		string key = GetKey(name, -1);
 		return _values.find(key) != _values.end();
 	}
@@ -442,12 +589,35 @@ public:
 	void PushNamePrefix(const char* name, int index = -1);
 	void PopNamePrefix();
 	void SaveTo(ostream &file, int compressionLevel = 1);
+	void SaveTo(ostream &file, int compressionLevel, CompressionCodec codec);
 	bool LoadFrom(istream& file);
 	void LoadFromMap(unordered_map<string, SerializeMapValue>& map);
+
+	//Converts a state saved in the packed format to the binary format (e.g before writing it to a file)
+	static bool ConvertToBinaryFormat(SerializeSnapshot& snapshot, vector<uint8_t>& data);
+
+	//Number of packed states loaded on the current thread that could not be loaded in order (and were converted to the keyed format)
+	static uint32_t GetKeyedFallbackCount();
 };
 
 template<> inline void Serializer::Stream(string& value, const char* name, int index)
 {
+	if(_format == SerializeFormat::Packed) {
+		if(_saving) {
+			RecordSchemaEntry(name, index, 0, SerializeSchemaEntryType::VariableValue);
+			WriteValue((uint32_t)value.size());
+			WriteData(value.data(), (uint32_t)value.size());
+			return;
+		}
+
+		uint32_t size;
+		uint8_t* src = ReadPackedValue(name, index, 0, SerializeSchemaEntryType::VariableValue, size);
+		if(src) {
+			value = string(src, src + size);
+			return;
+		}
+	}
+
 	string key = GetKey(name, index);
 
 	CheckDuplicateKey(key);
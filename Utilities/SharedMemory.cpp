@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "Utilities/SharedMemory.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+SharedMemory::~SharedMemory()
+{
+	Close();
+}
+
+bool SharedMemory::Create(const string& name, size_t size)
+{
+	Close();
+
+	#ifdef _WIN32
+		HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name.c_str());
+		if(!handle) {
+			return false;
+		}
+
+		void* data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		if(!data) {
+			CloseHandle(handle);
+			return false;
+		}
+		_handle = handle;
+	#else
+		//Remove any leftover object with the same name (e.g if a previous instance crashed)
+		shm_unlink(name.c_str());
+
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if(fd < 0) {
+			return false;
+		}
+
+		//The file is sparse, pages are only allocated once they are written to
+		if(ftruncate(fd, (off_t)size) != 0) {
+			close(fd);
+			shm_unlink(name.c_str());
+			return false;
+		}
+
+		void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if(data == MAP_FAILED) {
+			shm_unlink(name.c_str());
+			return false;
+		}
+	#endif
+
+	_name = name;
+	_data = (uint8_t*)data;
+	_size = size;
+	return true;
+}
+
+void SharedMemory::Close()
+{
+	if(!_data) {
+		return;
+	}
+
+	#ifdef _WIN32
+		UnmapViewOfFile(_data);
+		CloseHandle((HANDLE)_handle);
+		_handle = nullptr;
+	#else
+		munmap(_data, _size);
+		shm_unlink(_name.c_str());
+	#endif
+
+	_data = nullptr;
+	_size = 0;
+	_name.clear();
+}
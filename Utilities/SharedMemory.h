@@ -0,0 +1,26 @@
+#pragma once
+#include "pch.h"
+
+//Named block of memory that other processes on the same machine can map (shm_open on Linux/macOS, a named file mapping on Windows)
+class SharedMemory
+{
+private:
+	string _name;
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+
+	#ifdef _WIN32
+	void* _handle = nullptr;
+	#endif
+
+public:
+	SharedMemory() {}
+	~SharedMemory();
+
+	bool Create(const string& name, size_t size);
+	void Close();
+
+	const string& GetName() { return _name; }
+	uint8_t* GetData() { return _data; }
+	size_t GetSize() { return _size; }
+};
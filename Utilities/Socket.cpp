@@ -14,6 +14,8 @@ using namespace std;
 #else
 	#include <sys/types.h>
 	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/uio.h>
 	#include <sys/ioctl.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
@@ -21,6 +23,7 @@ using namespace std;
 	#include <netinet/tcp.h>
 	#include <netdb.h>
 	#include <unistd.h>
+	#include <poll.h>
 
 	#define INVALID_SOCKET (uintptr_t)-1
 	#define SOCKET_ERROR -1
@@ -203,6 +206,101 @@ unique_ptr<Socket> Socket::Accept()
 	return unique_ptr<Socket>(new Socket(socket));
 }
 
+unique_ptr<Socket> Socket::CreateLocalListener(const string& path, int backlog)
+{
+	#ifdef _WIN32
+		(void)path;
+		(void)backlog;
+		return nullptr;
+	#else
+		sockaddr_un addr = {};
+		if(path.empty() || path.size() >= sizeof(addr.sun_path)) {
+			return nullptr;
+		}
+		addr.sun_family = AF_UNIX;
+		memcpy(addr.sun_path, path.c_str(), path.size());
+
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0) {
+			return nullptr;
+		}
+
+		//Remove the socket file left behind by a previous instance
+		unlink(path.c_str());
+
+		if(::bind(fd, (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(fd, backlog) == SOCKET_ERROR) {
+			std::cout << "Unable to bind local socket." << std::endl;
+			close(fd);
+			return nullptr;
+		}
+
+		return unique_ptr<Socket>(new Socket((uintptr_t)fd));
+	#endif
+}
+
+bool Socket::CreateLoopbackPair(unique_ptr<Socket>& sender, unique_ptr<Socket>& receiver)
+{
+	sender.reset();
+	receiver.reset();
+
+	#ifndef _WIN32
+		int fds[2];
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+			sender.reset(new Socket((uintptr_t)fds[0]));
+			receiver.reset(new Socket((uintptr_t)fds[1]));
+			return true;
+		}
+	#endif
+
+	//No socketpair() on Windows - connect through a temporary listener bound to an ephemeral port
+	//on the loopback interface, which is closed as soon as the connection is accepted
+	Socket listener;
+	if(listener.ConnectionError()) {
+		return false;
+	}
+
+	SOCKADDR_IN addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	socklen_t addrSize = sizeof(addr);
+	if(::bind(listener._socket, (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR || getsockname(listener._socket, (SOCKADDR*)&addr, &addrSize) == SOCKET_ERROR) {
+		return false;
+	}
+
+	listener.Listen(1);
+	unique_ptr<Socket> connection(new Socket());
+	if(listener.ConnectionError() || !connection->Connect("127.0.0.1", ntohs(addr.sin_port))) {
+		return false;
+	}
+
+	SOCKADDR_IN localAddr = {};
+	addrSize = sizeof(localAddr);
+	if(getsockname(connection->_socket, (SOCKADDR*)&localAddr, &addrSize) == SOCKET_ERROR) {
+		return false;
+	}
+
+	vector<Socket*> sockets = { &listener };
+	vector<uint8_t> events = { Socket::PollRead };
+	vector<uint8_t> results;
+	if(Socket::Poll(sockets, events, results, 1000) <= 0) {
+		return false;
+	}
+
+	SOCKADDR_IN peerAddr = {};
+	addrSize = sizeof(peerAddr);
+	uintptr_t socket = accept(listener._socket, (SOCKADDR*)&peerAddr, &addrSize);
+	unique_ptr<Socket> accepted(new Socket(socket));
+	if(accepted->ConnectionError() || peerAddr.sin_port != localAddr.sin_port || peerAddr.sin_addr.s_addr != localAddr.sin_addr.s_addr) {
+		//Another process connected to the port first, don't use it
+		return false;
+	}
+
+	sender = std::move(connection);
+	receiver = std::move(accepted);
+	return true;
+}
+
 bool WouldBlock(int nError)
 {
 	return nError == WSAEWOULDBLOCK || nError == EAGAIN;
@@ -262,3 +360,149 @@ int Socket::Recv(char *buf, int len, int flags)
 
 	return returnVal;
 }
+
+int Socket::SendVectored(const SocketBuffer* buffers, int count, bool waitForCompletion)
+{
+	//Max number of buffers given to the OS in a single call (IOV_MAX is 1024 on most platforms)
+	constexpr size_t maxBuffersPerCall = 512;
+
+	#ifdef _WIN32
+		thread_local vector<WSABUF> vec;
+	#else
+		thread_local vector<iovec> vec;
+	#endif
+
+	vec.clear();
+	int totalSize = 0;
+	for(int i = 0; i < count; i++) {
+		if(buffers[i].Length > 0) {
+			#ifdef _WIN32
+				vec.push_back({ (ULONG)buffers[i].Length, (CHAR*)buffers[i].Data });
+			#else
+				vec.push_back({ (void*)buffers[i].Data, (size_t)buffers[i].Length });
+			#endif
+			totalSize += (int)buffers[i].Length;
+		}
+	}
+
+	int retryCount = 100;
+	int sentTotal = 0;
+	size_t first = 0;
+	while(first < vec.size()) {
+		size_t bufferCount = std::min(vec.size() - first, maxBuffersPerCall);
+
+		#ifdef _WIN32
+			DWORD sent = 0;
+			int returnVal = WSASend(_socket, vec.data() + first, (DWORD)bufferCount, &sent, 0, nullptr, nullptr) == 0 ? (int)sent : SOCKET_ERROR;
+		#else
+			msghdr msg = {};
+			msg.msg_iov = vec.data() + first;
+			msg.msg_iovlen = bufferCount;
+			int returnVal = (int)sendmsg(_socket, &msg, 0);
+		#endif
+
+		if(returnVal > 0) {
+			//Skip the buffers that were fully sent, and adjust the first partially sent buffer
+			sentTotal += returnVal;
+			size_t sentSize = (size_t)returnVal;
+			while(sentSize > 0) {
+				#ifdef _WIN32
+					size_t len = vec[first].len;
+				#else
+					size_t len = vec[first].iov_len;
+				#endif
+
+				if(sentSize >= len) {
+					sentSize -= len;
+					first++;
+				} else {
+					#ifdef _WIN32
+						vec[first].buf += sentSize;
+						vec[first].len -= (ULONG)sentSize;
+					#else
+						vec[first].iov_base = (uint8_t*)vec[first].iov_base + sentSize;
+						vec[first].iov_len -= sentSize;
+					#endif
+					sentSize = 0;
+				}
+			}
+		} else if(returnVal == SOCKET_ERROR) {
+			int nError = WSAGetLastError();
+			if(!WouldBlock(nError)) {
+				SetConnectionErrorFlag();
+				return -1;
+			}
+
+			if(!waitForCompletion) {
+				return sentTotal;
+			}
+
+			retryCount--;
+			if(retryCount == 0) {
+				//Connection seems dead, close it.
+				std::cout << "Unable to send data, closing socket." << std::endl;
+				Close();
+				return -1;
+			}
+
+			std::this_thread::sleep_for(std::chrono::duration<int, std::milli>(20));
+		}
+	}
+
+	return totalSize;
+}
+
+int Socket::Poll(const vector<Socket*>& sockets, const vector<uint8_t>& events, vector<uint8_t>& results, int msTimeout)
+{
+	//Reused between calls to avoid allocating on every wake up
+	thread_local vector<pollfd> fds;
+	thread_local vector<size_t> fdIndexes;
+
+	results.assign(sockets.size(), 0);
+	fds.clear();
+	fdIndexes.clear();
+
+	for(size_t i = 0; i < sockets.size(); i++) {
+		if(sockets[i] && sockets[i]->_socket != INVALID_SOCKET && events[i]) {
+			pollfd fd = {};
+			fd.fd = (decltype(fd.fd))sockets[i]->_socket;
+			fd.events = ((events[i] & Socket::PollRead) ? POLLIN : 0) | ((events[i] & Socket::PollWrite) ? POLLOUT : 0);
+			fds.push_back(fd);
+			fdIndexes.push_back(i);
+		}
+	}
+
+	if(fds.empty()) {
+		//WSAPoll fails immediately when given no sockets, sleep instead to keep the behavior consistent
+		std::this_thread::sleep_for(std::chrono::duration<int, std::milli>(msTimeout));
+		return 0;
+	}
+
+	#ifdef _WIN32
+		int returnVal = WSAPoll(fds.data(), (ULONG)fds.size(), msTimeout);
+	#else
+		int returnVal = poll(fds.data(), (nfds_t)fds.size(), msTimeout);
+	#endif
+
+	if(returnVal <= 0) {
+		return 0;
+	}
+
+	int readyCount = 0;
+	for(size_t i = 0; i < fds.size(); i++) {
+		uint8_t ready = 0;
+		//Closed/errored sockets are reported as readable so the caller can call Recv() and detect the error
+		if(fds[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+			ready |= Socket::PollRead;
+		}
+		if(fds[i].revents & POLLOUT) {
+			ready |= Socket::PollWrite;
+		}
+
+		if(ready) {
+			results[fdIndexes[i]] = ready;
+			readyCount++;
+		}
+	}
+	return readyCount;
+}
@@ -2,6 +2,12 @@
 
 #include "pch.h"
 
+struct SocketBuffer
+{
+	const void* Data;
+	uint32_t Length;
+};
+
 class Socket
 {
 private:
@@ -29,8 +35,28 @@ public:
 	void Listen(int backlog);
 	unique_ptr<Socket> Accept();
 
+	//Creates a socket listening on a Unix domain socket (local connections only) - returns nullptr if not supported or if the path can't be bound
+	static unique_ptr<Socket> CreateLocalListener(const string& path, int backlog);
+
+	//Creates a pair of connected sockets that can only be used by the current process (e.g to wake up a thread waiting in Poll)
+	//Uses socketpair() when available, otherwise a loopback connection to a temporary listener - returns false on failure
+	static bool CreateLoopbackPair(unique_ptr<Socket>& sender, unique_ptr<Socket>& receiver);
+
 	int Send(char *buf, int len, int flags);
 	void BufferedSend(char *buf, int len);
 	void SendBuffer();
 	int Recv(char *buf, int len, int flags);
+
+	//Sends multiple buffers with a single call (scatter/gather) without copying them into a temporary buffer first
+	//Returns the total number of bytes sent, or -1 if the data could not be sent
+	//When waitForCompletion is false, returns as soon as the socket's send buffer is full (the return value can be lower than the total size)
+	int SendVectored(const SocketBuffer* buffers, int count, bool waitForCompletion = true);
+
+	static constexpr uint8_t PollRead = 0x01;
+	static constexpr uint8_t PollWrite = 0x02;
+
+	//Blocks until at least one of the sockets is ready, or until the timeout expires
+	//events[i] contains the PollRead/PollWrite flags to wait for on each socket (null sockets are ignored). results[i] is set to the
+	//flags that are ready for each socket (closed/errored sockets are reported as readable). Returns the number of ready sockets.
+	static int Poll(const vector<Socket*>& sockets, const vector<uint8_t>& events, vector<uint8_t>& results, int msTimeout);
 };
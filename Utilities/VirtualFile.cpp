@@ -15,7 +15,7 @@ const std::initializer_list<string> VirtualFile::RomExtensions = {
 	".nes", ".fds", ".qd", ".unif", ".unf", ".nsf", ".nsfe", ".studybox",
 	".sfc", ".swc", ".fig", ".smc", ".bs", ".st", ".spc",
 	".gb", ".gbc", ".gbx", ".gbs",
-	".pce", ".sgx", ".cue", ".hes",
+	".pce", ".sgx", ".cue", ".chd", ".hes",
 	".sms", ".gg", ".sg", ".col",
 	".gba",
 	".ws", ".wsc"
@@ -229,9 +229,8 @@ bool VirtualFile::CheckFileSignature(vector<string> signatures, bool loadArchive
 
 void VirtualFile::InitChunks()
 {
-	if(!_useChunks) {
-		_useChunks = true;
-		_chunks.resize(GetSize() / VirtualFile::ChunkSize + 1);
+	if(!_chunkCache) {
+		_chunkCache.reset(new ChunkCache());
 	}
 }
 
@@ -268,22 +267,94 @@ bool VirtualFile::ReadFile(uint8_t* out, uint32_t expectedSize)
 
 uint8_t VirtualFile::ReadByte(uint32_t offset)
 {
-	InitChunks();
-	if(offset < 0 || offset > GetSize()) {
+	uint8_t value = 0;
+	ReadBytes(offset, &value, 1);
+	return value;
+}
+
+bool VirtualFile::ReadBytes(uint32_t offset, uint8_t* out, uint32_t length)
+{
+	if((uint64_t)offset + length > GetSize()) {
 		//Out of bounds
-		return 0;
+		return false;
 	}
 
-	uint32_t chunkId = offset / VirtualFile::ChunkSize;
-	uint32_t chunkStart = chunkId * VirtualFile::ChunkSize;
-	if(_chunks[chunkId].size() == 0) {
-		ifstream input(_path, std::ios::in | std::ios::binary);
-		input.seekg(chunkStart, std::ios::beg);
+	if(_data.size() > 0) {
+		memcpy(out, _data.data() + offset, length);
+		return true;
+	}
+
+	InitChunks();
+	auto lock = _chunkCache->Lock.AcquireSafe();
+	while(length > 0) {
+		uint32_t chunkId = offset / VirtualFile::ChunkSize;
+		uint32_t chunkOffset = offset - chunkId * VirtualFile::ChunkSize;
+		CachedChunk* chunk = GetChunk(chunkId);
+		if(!chunk) {
+			return false;
+		}
 
-		_chunks[chunkId].resize(VirtualFile::ChunkSize);
-		input.read((char*)_chunks[chunkId].data(), VirtualFile::ChunkSize);
+		uint32_t count = std::min<uint32_t>(length, VirtualFile::ChunkSize - chunkOffset);
+		memcpy(out, chunk->Data.data() + chunkOffset, count);
+		out += count;
+		offset += count;
+		length -= count;
 	}
-	return _chunks[chunkId][offset - chunkStart];
+	return true;
+}
+
+VirtualFile::CachedChunk* VirtualFile::GetChunk(uint32_t chunkId)
+{
+	//The chunk cache's lock must be held by the caller
+	ChunkCache& cache = *_chunkCache;
+	cache.AccessCounter++;
+
+	if(cache.LastChunkIndex < cache.Chunks.size() && cache.Chunks[cache.LastChunkIndex].Id == chunkId) {
+		cache.Chunks[cache.LastChunkIndex].LastAccess = cache.AccessCounter;
+		return &cache.Chunks[cache.LastChunkIndex];
+	}
+
+	uint32_t index = 0;
+	for(size_t i = 0; i < cache.Chunks.size(); i++) {
+		if(cache.Chunks[i].Id == chunkId) {
+			cache.Chunks[i].LastAccess = cache.AccessCounter;
+			cache.LastChunkIndex = (uint32_t)i;
+			return &cache.Chunks[i];
+		}
+		if(cache.Chunks[i].LastAccess < cache.Chunks[index].LastAccess) {
+			index = (uint32_t)i;
+		}
+	}
+
+	if(!cache.Stream.is_open()) {
+		cache.Stream.open(_path, std::ios::in | std::ios::binary);
+		if(!cache.Stream) {
+			return nullptr;
+		}
+	}
+
+	if(cache.Chunks.size() < VirtualFile::MaxCachedChunks) {
+		index = (uint32_t)cache.Chunks.size();
+		cache.Chunks.push_back({});
+		cache.Chunks[index].Data.resize(VirtualFile::ChunkSize);
+	}
+
+	//Load the chunk, replacing the least recently used one when the cache is full
+	CachedChunk& chunk = cache.Chunks[index];
+	chunk.Id = chunkId;
+	chunk.LastAccess = cache.AccessCounter;
+
+	cache.Stream.clear();
+	cache.Stream.seekg((std::streamoff)chunkId * VirtualFile::ChunkSize, std::ios::beg);
+	cache.Stream.read((char*)chunk.Data.data(), VirtualFile::ChunkSize);
+	std::streamsize bytesRead = std::max<std::streamsize>(cache.Stream.gcount(), 0);
+	if(bytesRead < VirtualFile::ChunkSize) {
+		//Last chunk of the file
+		memset(chunk.Data.data() + bytesRead, 0, VirtualFile::ChunkSize - bytesRead);
+	}
+
+	cache.LastChunkIndex = index;
+	return &chunk;
 }
 
 bool VirtualFile::ApplyPatch(VirtualFile& patch)
@@ -1,11 +1,31 @@
 #pragma once
 #include "pch.h"
 #include <sstream>
+#include "Utilities/SimpleLock.h"
 
 class VirtualFile
 {
 private:
 	constexpr static int ChunkSize = 256 * 1024;
+	constexpr static int MaxCachedChunks = 32;
+
+	struct CachedChunk
+	{
+		uint32_t Id;
+		uint64_t LastAccess;
+		vector<uint8_t> Data;
+	};
+
+	//Used when reading parts of a file without loading it entirely (e.g disc images).
+	//Shared by all copies of the VirtualFile, and can be used by multiple threads.
+	struct ChunkCache
+	{
+		SimpleLock Lock;
+		ifstream Stream;
+		vector<CachedChunk> Chunks;
+		uint64_t AccessCounter = 0;
+		uint32_t LastChunkIndex = 0;
+	};
 
 	string _path = "";
 	string _innerFile = "";
@@ -13,12 +33,12 @@ private:
 	vector<uint8_t> _data;
 	int64_t _fileSize = -1;
 
-	vector<vector<uint8_t>> _chunks;
-	bool _useChunks = false;
+	shared_ptr<ChunkCache> _chunkCache;
 
 	void FromStream(std::istream &input, vector<uint8_t> &output);
 
 	void LoadFile();
+	CachedChunk* GetChunk(uint32_t chunkId);
 
 public:
 	static const std::initializer_list<string> RomExtensions;
@@ -49,20 +69,27 @@ public:
 	bool ReadFile(uint8_t* out, uint32_t expectedSize);
 
 	uint8_t ReadByte(uint32_t offset);
+	bool ReadBytes(uint32_t offset, uint8_t* out, uint32_t length);
 
 	bool ApplyPatch(VirtualFile &patch);
 
 	template<typename T>
 	bool ReadChunk(T& container, int start, int length)
 	{
-		InitChunks();
-		if(start < 0 || start + length > GetSize()) {
+		if(start < 0 || length < 0 || start + length > GetSize()) {
 			//Out of bounds
 			return false;
 		}
 
-		for(int i = start, end = start + length; i < end; i++) {
-			container.push_back(ReadByte(i));
+		uint8_t buffer[4096];
+		while(length > 0) {
+			int count = std::min(length, (int)sizeof(buffer));
+			if(!ReadBytes(start, buffer, count)) {
+				return false;
+			}
+			container.insert(container.end(), buffer, buffer + count);
+			start += count;
+			length -= count;
 		}
 
 		return true;